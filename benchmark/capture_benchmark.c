@@ -0,0 +1,332 @@
+// Benchmark of the capture path of vimbasrc driven by the VimbaC mock (build with -DVIMBA_MOCK=ON).
+//
+// For every combination of resolution, pixel format, number of frame buffers and zero-copy/copy output a pipeline of
+// the form "vimbasrc ! capsfilter ! fakesink" (or appsink) is run. The mock generates frames as fast as the requested
+// frame rate allows. After a warm-up phase the following values are measured:
+//  - sustained frame rate at the sink
+//  - CPU time (user + system) of the whole process per frame. This includes generating the frames in the mock
+//  - bandwidth of the image data copied in gst_vimbasrc_create (0 if all frames were passed on without copying)
+//  - percentiles of the time between the Vimba frame callback and pushing the buffer downstream. These are taken from
+//    the residence histogram of the "stats" property and given as upper bound of the histogram bucket
+//  - frames dropped because no frame buffer was queued in time
+//
+// Usage: capture_benchmark [duration_s] [frame_rate] [fakesink|appsink]
+
+#include <gst/gst.h>
+
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <sys/resource.h>
+#endif
+
+// Type of the memory vimbasrc passes downstream if a frame is not copied. See gstvimbaallocator.h
+#define VIMBA_MEMORY_TYPE "VimbaFrameMemory"
+
+// Time the pipeline runs before measuring so buffer pools and caps are settled
+#define WARMUP_DURATION (500 * GST_MSECOND)
+
+typedef struct
+{
+    gint width;
+    gint height;
+} BenchmarkResolution_t;
+
+typedef struct
+{
+    const char *vimba_format;
+    const char *caps;
+} BenchmarkFormat_t;
+
+static const BenchmarkResolution_t resolutions[] = {{640, 480}, {1920, 1080}, {4096, 3000}};
+
+static const BenchmarkFormat_t formats[] = {
+    {"Mono8", "video/x-raw,format=GRAY8"},
+    {"Mono12", "video/x-raw,format=GRAY16_LE"},
+    {"BayerRG8", "video/x-bayer,format=rggb"},
+    {"RGB8", "video/x-raw,format=RGB"},
+};
+
+static const guint frame_buffer_counts[] = {3, 8, 32};
+
+typedef struct
+{
+    // Written from the streaming thread, read from the main thread
+    gsize frame_count;
+    gsize copied_bytes;
+} SinkCounters_t;
+
+typedef struct
+{
+    GstClockTime wall_time;
+    GstClockTime cpu_time;
+    gsize frame_count;
+    gsize copied_bytes;
+    guint64 dropped_frames;
+    guint64 residence_histogram[32];
+    guint residence_histogram_size;
+} Snapshot_t;
+
+static GstClockTime get_process_cpu_time(void)
+{
+#ifdef _WIN32
+    FILETIME creation_time, exit_time, kernel_time, user_time;
+    GetProcessTimes(GetCurrentProcess(), &creation_time, &exit_time, &kernel_time, &user_time);
+    ULARGE_INTEGER kernel, user;
+    kernel.LowPart = kernel_time.dwLowDateTime;
+    kernel.HighPart = kernel_time.dwHighDateTime;
+    user.LowPart = user_time.dwLowDateTime;
+    user.HighPart = user_time.dwHighDateTime;
+    // FILETIME counts in units of 100 ns
+    return (kernel.QuadPart + user.QuadPart) * 100;
+#else
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    return GST_TIMEVAL_TO_TIME(usage.ru_utime) + GST_TIMEVAL_TO_TIME(usage.ru_stime);
+#endif
+}
+
+static void count_buffer(SinkCounters_t *counters, GstBuffer *buffer)
+{
+    GstMemory *memory = gst_buffer_peek_memory(buffer, 0);
+    if (!gst_memory_is_type(memory, VIMBA_MEMORY_TYPE))
+    {
+        g_atomic_pointer_add(&counters->copied_bytes, (gssize)gst_buffer_get_size(buffer));
+    }
+    g_atomic_pointer_add(&counters->frame_count, 1);
+}
+
+static void on_handoff(GstElement *sink, GstBuffer *buffer, GstPad *pad, gpointer user_data)
+{
+    (void)sink;
+    (void)pad;
+    count_buffer(user_data, buffer);
+}
+
+static GstFlowReturn on_new_sample(GstElement *sink, gpointer user_data)
+{
+    GstSample *sample = NULL;
+    g_signal_emit_by_name(sink, "pull-sample", &sample);
+    if (sample == NULL)
+    {
+        return GST_FLOW_EOS;
+    }
+    count_buffer(user_data, gst_sample_get_buffer(sample));
+    gst_sample_unref(sample);
+    return GST_FLOW_OK;
+}
+
+static void take_snapshot(Snapshot_t *snapshot, GstElement *src, SinkCounters_t *counters)
+{
+    snapshot->wall_time = gst_util_get_timestamp();
+    snapshot->cpu_time = get_process_cpu_time();
+    snapshot->frame_count = (gsize)g_atomic_pointer_get(&counters->frame_count);
+    snapshot->copied_bytes = (gsize)g_atomic_pointer_get(&counters->copied_bytes);
+
+    GstStructure *stats = NULL;
+    g_object_get(src, "droppedframes", &snapshot->dropped_frames, "stats", &stats, NULL);
+    const GValue *histogram = gst_structure_get_value(stats, "residence-histogram");
+    snapshot->residence_histogram_size = MIN(gst_value_array_get_size(histogram),
+                                             G_N_ELEMENTS(snapshot->residence_histogram));
+    for (guint i = 0; i < snapshot->residence_histogram_size; i++)
+    {
+        snapshot->residence_histogram[i] = g_value_get_uint64(gst_value_array_get_value(histogram, i));
+    }
+    gst_structure_free(stats);
+}
+
+// Returns the upper bound (in ns) of the histogram bucket holding the given percentile of frames, or
+// GST_CLOCK_TIME_NONE if it lies in the last bucket, which is unbounded
+static GstClockTime get_residence_percentile(const Snapshot_t *start,
+                                             const Snapshot_t *end,
+                                             const GValue *bounds,
+                                             double percentile)
+{
+    guint64 total = 0;
+    for (guint i = 0; i < end->residence_histogram_size; i++)
+    {
+        total += end->residence_histogram[i] - start->residence_histogram[i];
+    }
+    guint64 threshold = (guint64)(percentile * (double)total);
+    guint64 count = 0;
+    for (guint i = 0; i < end->residence_histogram_size && i < gst_value_array_get_size(bounds); i++)
+    {
+        count += end->residence_histogram[i] - start->residence_histogram[i];
+        if (count > threshold)
+        {
+            return g_value_get_uint64(gst_value_array_get_value(bounds, i));
+        }
+    }
+    return GST_CLOCK_TIME_NONE;
+}
+
+static void format_percentile(char *text, size_t size, GstClockTime percentile)
+{
+    if (GST_CLOCK_TIME_IS_VALID(percentile))
+    {
+        g_snprintf(text, size, "<%" G_GUINT64_FORMAT "us", percentile / GST_USECOND);
+    }
+    else
+    {
+        g_snprintf(text, size, "overflow");
+    }
+}
+
+// Waits for the given time on the bus. Returns false if the pipeline reported an error or stopped before
+static bool wait_without_error(GstBus *bus, GstClockTime timeout)
+{
+    GstMessage *message = gst_bus_timed_pop_filtered(bus, timeout, GST_MESSAGE_ERROR | GST_MESSAGE_EOS);
+    if (message == NULL)
+    {
+        return true;
+    }
+    if (GST_MESSAGE_TYPE(message) == GST_MESSAGE_ERROR)
+    {
+        GError *error = NULL;
+        gst_message_parse_error(message, &error, NULL);
+        fprintf(stderr, "Pipeline error: %s\n", error->message);
+        g_error_free(error);
+    }
+    gst_message_unref(message);
+    return false;
+}
+
+static void run(const BenchmarkResolution_t *resolution,
+                const BenchmarkFormat_t *format,
+                guint frame_buffer_count,
+                gboolean zerocopy,
+                const char *sink_name,
+                GstClockTime duration)
+{
+    char value[32];
+    g_snprintf(value, sizeof(value), "%d", resolution->width);
+    g_setenv("VIMBA_MOCK_WIDTH", value, TRUE);
+    g_snprintf(value, sizeof(value), "%d", resolution->height);
+    g_setenv("VIMBA_MOCK_HEIGHT", value, TRUE);
+    g_setenv("VIMBA_MOCK_PIXEL_FORMAT", format->vimba_format, TRUE);
+
+    // The exposure time is set to the minimum of the mock so it does not limit the frame rate
+    char *description = g_strdup_printf("vimbasrc name=src camera=mock exposuretime=10 numframebuffers=%u zerocopy=%s ! "
+                                        "%s ! %s name=sink sync=false",
+                                        frame_buffer_count,
+                                        zerocopy ? "true" : "false",
+                                        format->caps,
+                                        sink_name);
+    GError *error = NULL;
+    GstElement *pipeline = gst_parse_launch(description, &error);
+    g_free(description);
+    if (pipeline == NULL)
+    {
+        fprintf(stderr, "Could not create pipeline: %s\n", error->message);
+        g_error_free(error);
+        return;
+    }
+    GstElement *src = gst_bin_get_by_name(GST_BIN(pipeline), "src");
+    GstElement *sink = gst_bin_get_by_name(GST_BIN(pipeline), "sink");
+    SinkCounters_t counters = {0, 0};
+    if (strcmp(sink_name, "appsink") == 0)
+    {
+        g_object_set(sink, "emit-signals", TRUE, NULL);
+        g_signal_connect(sink, "new-sample", G_CALLBACK(on_new_sample), &counters);
+    }
+    else
+    {
+        g_object_set(sink, "signal-handoffs", TRUE, NULL);
+        g_signal_connect(sink, "handoff", G_CALLBACK(on_handoff), &counters);
+    }
+
+    GstBus *bus = gst_element_get_bus(pipeline);
+    Snapshot_t start = {0}, end = {0};
+    bool is_ok = gst_element_set_state(pipeline, GST_STATE_PLAYING) != GST_STATE_CHANGE_FAILURE &&
+                 wait_without_error(bus, WARMUP_DURATION);
+    if (is_ok)
+    {
+        take_snapshot(&start, src, &counters);
+        is_ok = wait_without_error(bus, duration);
+        take_snapshot(&end, src, &counters);
+    }
+
+    printf("%4dx%-4d %-9s %3u %-4s ", resolution->width, resolution->height, format->vimba_format, frame_buffer_count,
+           zerocopy ? "zero" : "copy");
+    if (is_ok)
+    {
+        GstStructure *stats = NULL;
+        g_object_get(src, "stats", &stats, NULL);
+        const GValue *bounds = gst_structure_get_value(stats, "residence-histogram-bounds");
+        char p50[16], p99[16];
+        format_percentile(p50, sizeof(p50), get_residence_percentile(&start, &end, bounds, 0.5));
+        format_percentile(p99, sizeof(p99), get_residence_percentile(&start, &end, bounds, 0.99));
+        gst_structure_free(stats);
+
+        double seconds = (double)(end.wall_time - start.wall_time) / GST_SECOND;
+        gsize frame_count = end.frame_count - start.frame_count;
+        printf("%10.1f %10.1f %10.1f %10s %10s %8" G_GUINT64_FORMAT "\n",
+               (double)frame_count / seconds,
+               frame_count > 0 ? (double)(end.cpu_time - start.cpu_time) / GST_USECOND / (double)frame_count : 0.,
+               (double)(end.copied_bytes - start.copied_bytes) / seconds / (1024. * 1024.),
+               p50,
+               p99,
+               end.dropped_frames - start.dropped_frames);
+    }
+    else
+    {
+        printf("failed\n");
+    }
+
+    gst_element_set_state(pipeline, GST_STATE_NULL);
+    gst_object_unref(bus);
+    gst_object_unref(sink);
+    gst_object_unref(src);
+    gst_object_unref(pipeline);
+}
+
+int main(int argc, char *argv[])
+{
+    gst_init(&argc, &argv);
+
+    GstClockTime duration = (argc > 1 ? strtoul(argv[1], NULL, 10) : 2) * GST_SECOND;
+    const char *frame_rate = argc > 2 ? argv[2] : "10000";
+    const char *sink_name = argc > 3 ? argv[3] : "fakesink";
+    if (duration == 0 || (strcmp(sink_name, "fakesink") != 0 && strcmp(sink_name, "appsink") != 0))
+    {
+        fprintf(stderr, "Usage: %s [duration_s] [frame_rate] [fakesink|appsink]\n", argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    GError *error = NULL;
+    GstPlugin *plugin = gst_plugin_load_file(VIMBASRC_PLUGIN_PATH, &error);
+    if (plugin == NULL)
+    {
+        fprintf(stderr, "Could not load %s: %s\n", VIMBASRC_PLUGIN_PATH, error->message);
+        g_error_free(error);
+        return EXIT_FAILURE;
+    }
+    gst_object_unref(plugin);
+    g_setenv("VIMBA_MOCK_FRAME_RATE", frame_rate, TRUE);
+
+    printf("Running each configuration for %" G_GUINT64_FORMAT " s at up to %s fps into %s\n",
+           duration / GST_SECOND,
+           frame_rate,
+           sink_name);
+    printf("%-9s %-9s %3s %-4s %10s %10s %10s %10s %10s %8s\n",
+           "size", "format", "buf", "mode", "fps", "cpu us/f", "copy MB/s", "lat p50", "lat p99", "dropped");
+    for (size_t r = 0; r < G_N_ELEMENTS(resolutions); r++)
+    {
+        for (size_t f = 0; f < G_N_ELEMENTS(formats); f++)
+        {
+            for (size_t b = 0; b < G_N_ELEMENTS(frame_buffer_counts); b++)
+            {
+                run(&resolutions[r], &formats[f], frame_buffer_counts[b], TRUE, sink_name, duration);
+                run(&resolutions[r], &formats[f], frame_buffer_counts[b], FALSE, sink_name, duration);
+            }
+        }
+    }
+
+    gst_deinit();
+    return EXIT_SUCCESS;
+}
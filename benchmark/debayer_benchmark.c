@@ -0,0 +1,151 @@
+// Micro-benchmark of demosaicing 8 bit Bayer images into the RGB, BGRx and GRAY8 formats.
+//
+// Every kernel the CPU supports demosaics a random RGGB image of the given size with both interpolation methods, once
+// with a single thread and once with the given number of threads. The output of each run is compared against the
+// single-threaded scalar kernel. The throughput is given in megapixels per second.
+//
+// Usage: debayer_benchmark [width] [height] [iterations] [threads]
+
+#include "debayer.h"
+#include "pixelunpack.h"
+
+#include <glib.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+typedef struct
+{
+    const char *name;
+    DebayerOutput_t output;
+} BenchmarkOutput_t;
+
+static const BenchmarkOutput_t outputs[] = {
+    {"RGB", DEBAYER_OUTPUT_RGB},
+    {"BGRx", DEBAYER_OUTPUT_BGRX},
+    {"GRAY8", DEBAYER_OUTPUT_GRAY8},
+};
+
+static const char *method_names[] = {"Bilinear", "EdgeAware"};
+
+static const PixelUnpackIsa_t isas[] = {PIXEL_UNPACK_ISA_SCALAR,
+                                        PIXEL_UNPACK_ISA_SSE2,
+                                        PIXEL_UNPACK_ISA_AVX2,
+                                        PIXEL_UNPACK_ISA_NEON};
+
+static double run(Debayer_t *debayer,
+                  DebayerMethod_t method,
+                  const BenchmarkOutput_t *output,
+                  const guint8 *src,
+                  guint width,
+                  guint height,
+                  guint8 *dst,
+                  guint iterations)
+{
+    gsize stride = ((gsize)width * debayer_output_bytes_per_pixel(output->output) + 3) & ~(gsize)3;
+    gint64 start = g_get_monotonic_time();
+    for (guint i = 0; i < iterations; i++)
+    {
+        debayer_image(debayer,
+                      BAYER_PATTERN_RGGB,
+                      method,
+                      output->output,
+                      src,
+                      (gsize)width * height,
+                      width,
+                      height,
+                      dst,
+                      stride);
+    }
+    gint64 duration = MAX(g_get_monotonic_time() - start, 1);
+    return (double)width * height * iterations / (double)duration;
+}
+
+int main(int argc, char *argv[])
+{
+    guint width = argc > 1 ? (guint)strtoul(argv[1], NULL, 10) : 4096;
+    guint height = argc > 2 ? (guint)strtoul(argv[2], NULL, 10) : 3000;
+    guint iterations = argc > 3 ? (guint)strtoul(argv[3], NULL, 10) : 20;
+    guint threads = argc > 4 ? (guint)strtoul(argv[4], NULL, 10) : 0;
+    if (width < 2 || height < 2 || iterations == 0)
+    {
+        fprintf(stderr, "Usage: %s [width] [height] [iterations] [threads]\n", argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    gsize src_size = (gsize)width * height;
+    gsize dst_size = ((gsize)width * 4 + 3) / 4 * 4 * height;
+    guint8 *src = g_malloc(src_size);
+    guint8 *dst = g_malloc(dst_size);
+    guint8 *reference = g_malloc(dst_size);
+    GRand *rand = g_rand_new_with_seed(1);
+    for (gsize i = 0; i < src_size; i++)
+    {
+        src[i] = (guint8)g_rand_int(rand);
+    }
+    Debayer_t *debayer = debayer_new(threads);
+    bool has_mismatch = false;
+
+    printf("Demosaicing %ux%u images %u times. Throughput in MP/s with 1 and %u threads\n",
+           width,
+           height,
+           iterations,
+           debayer->num_threads);
+    printf("%-6s %-10s %-7s %10s %10s\n", "format", "method", "isa", "1 thread", "threads");
+    for (gsize o = 0; o < G_N_ELEMENTS(outputs); o++)
+    {
+        gsize stride = ((gsize)width * debayer_output_bytes_per_pixel(outputs[o].output) + 3) & ~(gsize)3;
+        for (guint method = DEBAYER_METHOD_BILINEAR; method <= DEBAYER_METHOD_EDGE_AWARE; method++)
+        {
+            // The single-threaded scalar kernel provides the reference output
+            pixel_unpack_set_isa(PIXEL_UNPACK_ISA_SCALAR);
+            run(NULL, (DebayerMethod_t)method, &outputs[o], src, width, height, reference, 1);
+
+            for (gsize i = 0; i < G_N_ELEMENTS(isas); i++)
+            {
+                if (!pixel_unpack_isa_supported(isas[i]))
+                {
+                    continue;
+                }
+                pixel_unpack_set_isa(isas[i]);
+                double throughput[2];
+                for (guint j = 0; j < 2; j++)
+                {
+                    memset(dst, 0, dst_size);
+                    throughput[j] = run(j == 0 ? NULL : debayer,
+                                        (DebayerMethod_t)method,
+                                        &outputs[o],
+                                        src,
+                                        width,
+                                        height,
+                                        dst,
+                                        iterations);
+                    if (memcmp(dst, reference, stride * height) != 0)
+                    {
+                        fprintf(stderr,
+                                "%s %s output of %s kernel with %u threads differs from scalar kernel\n",
+                                outputs[o].name,
+                                method_names[method],
+                                pixel_unpack_isa_name(isas[i]),
+                                j == 0 ? 1 : debayer->num_threads);
+                        has_mismatch = true;
+                    }
+                }
+                printf("%-6s %-10s %-7s %10.0f %10.0f\n",
+                       outputs[o].name,
+                       method_names[method],
+                       pixel_unpack_isa_name(isas[i]),
+                       throughput[0],
+                       throughput[1]);
+            }
+        }
+    }
+
+    debayer_free(debayer);
+    g_rand_free(rand);
+    g_free(reference);
+    g_free(dst);
+    g_free(src);
+    return has_mismatch ? EXIT_FAILURE : EXIT_SUCCESS;
+}
@@ -0,0 +1,198 @@
+// Micro-benchmark comparing the frame handoff from the Vimba frame callback to the streaming thread via the lock-free
+// FrameQueue_t with the GAsyncQueue that was used before.
+//
+// A producer thread emulates the frame callback by pushing one element every <interval> microseconds (0 pushes as fast
+// as possible). The consumer thread emulates gst_vimbasrc_create by waiting for elements and records the time between
+// push and pop for every element.
+//
+// Usage: framequeue_benchmark [iterations] [interval_us]
+
+#include "framequeue.h"
+
+#include <glib.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <time.h>
+#endif
+
+// Capacity of the frame queue. Matches a generously sized ring of announced frames
+#define QUEUE_CAPACITY 64
+
+typedef struct
+{
+    gint64 push_time_ns;
+} HandoffItem_t;
+
+typedef struct
+{
+    guint iterations;
+    guint interval_us;
+    HandoffItem_t *items;
+    gint64 *latencies_ns;
+    FrameQueue_t *frame_queue;
+    GAsyncQueue *async_queue;
+} Benchmark_t;
+
+static gint64 now_ns(void)
+{
+#ifdef _WIN32
+    static LARGE_INTEGER frequency = {.QuadPart = 0};
+    LARGE_INTEGER counter;
+    if (frequency.QuadPart == 0)
+    {
+        QueryPerformanceFrequency(&frequency);
+    }
+    QueryPerformanceCounter(&counter);
+    return (gint64)((double)counter.QuadPart * 1e9 / (double)frequency.QuadPart);
+#else
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (gint64)ts.tv_sec * G_GINT64_CONSTANT(1000000000) + ts.tv_nsec;
+#endif
+}
+
+// Busy waits instead of sleeping so the producer timing is not distorted by scheduler wakeup latency
+static void wait_until_ns(gint64 deadline_ns)
+{
+    while (now_ns() < deadline_ns)
+    {
+    }
+}
+
+static gpointer frame_queue_producer(gpointer data)
+{
+    Benchmark_t *benchmark = data;
+    gint64 next_push_ns = now_ns();
+    for (guint i = 0; i < benchmark->iterations; i++)
+    {
+        wait_until_ns(next_push_ns);
+        next_push_ns += (gint64)benchmark->interval_us * 1000;
+
+        HandoffItem_t *item = &benchmark->items[i];
+        item->push_time_ns = now_ns();
+        while (!frame_queue_push(benchmark->frame_queue, item))
+        {
+            g_thread_yield();
+        }
+    }
+    return NULL;
+}
+
+static gpointer frame_queue_consumer(gpointer data)
+{
+    Benchmark_t *benchmark = data;
+    for (guint i = 0; i < benchmark->iterations; i++)
+    {
+        HandoffItem_t *item = frame_queue_pop_wait(benchmark->frame_queue);
+        benchmark->latencies_ns[i] = now_ns() - item->push_time_ns;
+    }
+    return NULL;
+}
+
+static gpointer async_queue_producer(gpointer data)
+{
+    Benchmark_t *benchmark = data;
+    gint64 next_push_ns = now_ns();
+    for (guint i = 0; i < benchmark->iterations; i++)
+    {
+        wait_until_ns(next_push_ns);
+        next_push_ns += (gint64)benchmark->interval_us * 1000;
+
+        HandoffItem_t *item = &benchmark->items[i];
+        item->push_time_ns = now_ns();
+        g_async_queue_push(benchmark->async_queue, item);
+    }
+    return NULL;
+}
+
+static gpointer async_queue_consumer(gpointer data)
+{
+    Benchmark_t *benchmark = data;
+    for (guint i = 0; i < benchmark->iterations; i++)
+    {
+        HandoffItem_t *item = g_async_queue_pop(benchmark->async_queue);
+        benchmark->latencies_ns[i] = now_ns() - item->push_time_ns;
+    }
+    return NULL;
+}
+
+static gint compare_latencies(gconstpointer a, gconstpointer b)
+{
+    gint64 latency_a = *(const gint64 *)a;
+    gint64 latency_b = *(const gint64 *)b;
+    return (latency_a > latency_b) - (latency_a < latency_b);
+}
+
+static void print_statistics(const char *name, Benchmark_t *benchmark, gint64 duration_ns)
+{
+    guint count = benchmark->iterations;
+    gint64 *latencies = benchmark->latencies_ns;
+    qsort(latencies, count, sizeof(gint64), compare_latencies);
+
+    double mean = 0.;
+    for (guint i = 0; i < count; i++)
+    {
+        mean += (double)latencies[i];
+    }
+    mean /= count;
+    // Mean absolute deviation from the mean latency as measure for the jitter
+    double jitter = 0.;
+    for (guint i = 0; i < count; i++)
+    {
+        double deviation = (double)latencies[i] - mean;
+        jitter += deviation < 0. ? -deviation : deviation;
+    }
+    jitter /= count;
+
+    printf("%-12s mean %9.0f ns  jitter %9.0f ns  p50 %9" G_GINT64_FORMAT " ns  p99 %9" G_GINT64_FORMAT
+           " ns  max %9" G_GINT64_FORMAT " ns  throughput %10.0f/s\n",
+           name,
+           mean,
+           jitter,
+           latencies[count / 2],
+           latencies[(guint)((guint64)count * 99 / 100)],
+           latencies[count - 1],
+           (double)count * 1e9 / (double)duration_ns);
+}
+
+static void run(const char *name, Benchmark_t *benchmark, GThreadFunc producer, GThreadFunc consumer)
+{
+    gint64 start_ns = now_ns();
+    GThread *consumer_thread = g_thread_new("consumer", consumer, benchmark);
+    GThread *producer_thread = g_thread_new("producer", producer, benchmark);
+    g_thread_join(producer_thread);
+    g_thread_join(consumer_thread);
+    print_statistics(name, benchmark, now_ns() - start_ns);
+}
+
+int main(int argc, char *argv[])
+{
+    Benchmark_t benchmark = {
+        .iterations = argc > 1 ? (guint)strtoul(argv[1], NULL, 10) : 100000,
+        .interval_us = argc > 2 ? (guint)strtoul(argv[2], NULL, 10) : 100};
+    if (benchmark.iterations == 0)
+    {
+        fprintf(stderr, "Usage: %s [iterations] [interval_us]\n", argv[0]);
+        return EXIT_FAILURE;
+    }
+    benchmark.items = g_new0(HandoffItem_t, benchmark.iterations);
+    benchmark.latencies_ns = g_new0(gint64, benchmark.iterations);
+    benchmark.frame_queue = frame_queue_new(QUEUE_CAPACITY);
+    benchmark.async_queue = g_async_queue_new();
+
+    printf("Handing off %u elements, one every %u us\n", benchmark.iterations, benchmark.interval_us);
+    run("GAsyncQueue", &benchmark, async_queue_producer, async_queue_consumer);
+    run("FrameQueue", &benchmark, frame_queue_producer, frame_queue_consumer);
+
+    g_async_queue_unref(benchmark.async_queue);
+    frame_queue_free(benchmark.frame_queue);
+    g_free(benchmark.latencies_ns);
+    g_free(benchmark.items);
+
+    return EXIT_SUCCESS;
+}
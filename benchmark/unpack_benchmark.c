@@ -0,0 +1,188 @@
+// Micro-benchmark of the kernels unpacking the packed Mono10p, Mono12p and Mono12Packed formats and scaling or
+// narrowing the bit depth of unpacked Mono12 images.
+//
+// Every kernel the CPU supports unpacks a random image of the given size into 16 bit and 8 bit pixels. The output of
+// each kernel is compared against the scalar kernel. The throughput is given in packed bytes per second and compared
+// against the line rate of common camera interfaces to show whether unpacking keeps up with the link. Afterwards the
+// bit depth of a 16 bit image is scaled in place and narrowed to 8 bit with every kernel.
+//
+// Usage: unpack_benchmark [width] [height] [iterations]
+
+#include "pixelunpack.h"
+
+#include <glib.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+typedef struct
+{
+    const char *name;
+    PackedFormat_t format;
+} BenchmarkFormat_t;
+
+static const BenchmarkFormat_t formats[] = {
+    {"Mono10p", PACKED_FORMAT_MONO10P},
+    {"Mono12p", PACKED_FORMAT_MONO12P},
+    {"Mono12Packed", PACKED_FORMAT_MONO12PACKED},
+};
+
+static const PixelUnpackIsa_t isas[] = {PIXEL_UNPACK_ISA_SCALAR,
+                                        PIXEL_UNPACK_ISA_SSE2,
+                                        PIXEL_UNPACK_ISA_AVX2,
+                                        PIXEL_UNPACK_ISA_NEON};
+
+// Payload bandwidth (in bytes per second) of the camera interfaces the throughput is compared against
+#define GIGE_LINE_RATE 125e6
+#define USB3_LINE_RATE 400e6
+#define TEN_GIGE_LINE_RATE 1250e6
+
+static double run(const BenchmarkFormat_t *format,
+                  const guint8 *src,
+                  gsize src_size,
+                  guint width,
+                  guint height,
+                  guint8 *dst,
+                  guint dst_bits_per_pixel,
+                  guint iterations)
+{
+    gsize stride = ((gsize)width * dst_bits_per_pixel / 8 + 3) & ~(gsize)3;
+    gint64 start = g_get_monotonic_time();
+    for (guint i = 0; i < iterations; i++)
+    {
+        pixel_unpack_image(format->format,
+                           src,
+                           src_size,
+                           width,
+                           height,
+                           dst,
+                           stride,
+                           dst_bits_per_pixel,
+                           BIT_DEPTH_SCALING_NONE);
+    }
+    gint64 duration = MAX(g_get_monotonic_time() - start, 1);
+    return (double)src_size * iterations * G_USEC_PER_SEC / (double)duration;
+}
+
+int main(int argc, char *argv[])
+{
+    guint width = argc > 1 ? (guint)strtoul(argv[1], NULL, 10) : 4096;
+    guint height = argc > 2 ? (guint)strtoul(argv[2], NULL, 10) : 3000;
+    guint iterations = argc > 3 ? (guint)strtoul(argv[3], NULL, 10) : 50;
+    if (width == 0 || height == 0 || iterations == 0)
+    {
+        fprintf(stderr, "Usage: %s [width] [height] [iterations]\n", argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    gsize dst_size = ((gsize)width * 2 + 3) / 4 * 4 * height;
+    guint8 *dst = g_malloc(dst_size);
+    guint8 *reference = g_malloc(dst_size);
+    GRand *rand = g_rand_new_with_seed(1);
+    bool has_mismatch = false;
+
+    printf("Unpacking %ux%u images %u times. Throughput in packed MB/s (multiple of 10GigE line rate)\n",
+           width,
+           height,
+           iterations);
+    printf("%-13s %-7s %12s %12s\n", "format", "isa", "to GRAY16", "to GRAY8");
+    for (gsize f = 0; f < G_N_ELEMENTS(formats); f++)
+    {
+        gsize src_size = ((gsize)width * height * packed_format_bits_per_pixel(formats[f].format) + 7) / 8;
+        guint8 *src = g_malloc(src_size);
+        for (gsize i = 0; i < src_size; i++)
+        {
+            src[i] = (guint8)g_rand_int(rand);
+        }
+
+        for (gsize i = 0; i < G_N_ELEMENTS(isas); i++)
+        {
+            if (!pixel_unpack_isa_supported(isas[i]))
+            {
+                continue;
+            }
+            double throughput[2];
+            for (guint bits = 16, j = 0; bits >= 8; bits -= 8, j++)
+            {
+                // The scalar kernel provides the reference output
+                gsize stride = ((gsize)width * bits / 8 + 3) & ~(gsize)3;
+                pixel_unpack_set_isa(PIXEL_UNPACK_ISA_SCALAR);
+                pixel_unpack_image(formats[f].format,
+                                   src,
+                                   src_size,
+                                   width,
+                                   height,
+                                   reference,
+                                   stride,
+                                   bits,
+                                   BIT_DEPTH_SCALING_NONE);
+                pixel_unpack_set_isa(isas[i]);
+                throughput[j] = run(&formats[f], src, src_size, width, height, dst, bits, iterations);
+                if (memcmp(dst, reference, stride * height) != 0)
+                {
+                    fprintf(stderr,
+                            "%s output of %s kernel differs from scalar kernel\n",
+                            formats[f].name,
+                            pixel_unpack_isa_name(isas[i]));
+                    has_mismatch = true;
+                }
+            }
+            printf("%-13s %-7s %7.0f (%4.1f) %7.0f (%4.1f)\n",
+                   formats[f].name,
+                   pixel_unpack_isa_name(isas[i]),
+                   throughput[0] / 1e6,
+                   throughput[0] / TEN_GIGE_LINE_RATE,
+                   throughput[1] / 1e6,
+                   throughput[1] / TEN_GIGE_LINE_RATE);
+        }
+        g_free(src);
+    }
+
+    // Scaling 12 bit pixels to the full 16 bit range in place and narrowing them to 8 bit
+    gsize pixel_count = (gsize)width * height;
+    guint16 *pixels = (guint16 *)dst;
+    gsize narrowed_stride = ((gsize)width + 3) & ~(gsize)3;
+    printf("%-13s %-7s %12s %12s\n", "format", "isa", "scaled", "narrowed");
+    for (gsize i = 0; i < G_N_ELEMENTS(isas); i++)
+    {
+        if (!pixel_unpack_isa_supported(isas[i]))
+        {
+            continue;
+        }
+        pixel_unpack_set_isa(isas[i]);
+        gint64 start = g_get_monotonic_time();
+        for (guint j = 0; j < iterations; j++)
+        {
+            pixel_scale_bit_depth(pixels, pixels, pixel_count, 12, BIT_DEPTH_SCALING_SCALE);
+        }
+        gint64 duration = MAX(g_get_monotonic_time() - start, 1);
+        double throughput[2];
+        throughput[0] = (double)pixel_count * sizeof(guint16) * iterations * G_USEC_PER_SEC / (double)duration;
+
+        start = g_get_monotonic_time();
+        for (guint j = 0; j < iterations; j++)
+        {
+            pixel_narrow_image(pixels, pixel_count * sizeof(guint16), width, height, 12, reference, narrowed_stride);
+        }
+        duration = MAX(g_get_monotonic_time() - start, 1);
+        throughput[1] = (double)pixel_count * sizeof(guint16) * iterations * G_USEC_PER_SEC / (double)duration;
+        printf("%-13s %-7s %7.0f (%4.1f) %7.0f (%4.1f)\n",
+               "Mono12",
+               pixel_unpack_isa_name(isas[i]),
+               throughput[0] / 1e6,
+               throughput[0] / TEN_GIGE_LINE_RATE,
+               throughput[1] / 1e6,
+               throughput[1] / TEN_GIGE_LINE_RATE);
+    }
+
+    printf("Line rates: GigE %.0f MB/s, USB3 %.0f MB/s, 10GigE %.0f MB/s\n",
+           GIGE_LINE_RATE / 1e6,
+           USB3_LINE_RATE / 1e6,
+           TEN_GIGE_LINE_RATE / 1e6);
+
+    g_rand_free(rand);
+    g_free(reference);
+    g_free(dst);
+    return has_mismatch ? EXIT_FAILURE : EXIT_SUCCESS;
+}
@@ -0,0 +1,134 @@
+// Micro-benchmark of repacking the packed YUV 4:1:1 and 4:2:2 formats into the planar I420 and NV12 formats.
+//
+// Every kernel the CPU supports repacks a random image of the given size into both planar formats. The output of each
+// run is compared against the scalar kernel. The throughput is given in megapixels per second.
+//
+// Usage: yuvrepack_benchmark [width] [height] [iterations]
+
+#include "pixelunpack.h"
+#include "yuvrepack.h"
+
+#include <glib.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+typedef struct
+{
+    const char *name;
+    YuvPacking_t packing;
+    // Bytes of one group of pixels and the number of pixels in it
+    guint group_size;
+    guint group_pixels;
+} BenchmarkPacking_t;
+
+typedef struct
+{
+    const char *name;
+    YuvOutput_t output;
+} BenchmarkOutput_t;
+
+static const BenchmarkPacking_t packings[] = {
+    {"IYU1", YUV_PACKING_411, 6, 4},
+    {"UYVY", YUV_PACKING_422, 4, 2},
+};
+
+static const BenchmarkOutput_t outputs[] = {
+    {"I420", YUV_OUTPUT_I420},
+    {"NV12", YUV_OUTPUT_NV12},
+};
+
+static const PixelUnpackIsa_t isas[] = {PIXEL_UNPACK_ISA_SCALAR,
+                                        PIXEL_UNPACK_ISA_SSE2,
+                                        PIXEL_UNPACK_ISA_AVX2,
+                                        PIXEL_UNPACK_ISA_NEON};
+
+static double run(const BenchmarkPacking_t *packing,
+                  const BenchmarkOutput_t *output,
+                  const guint8 *src,
+                  gsize src_size,
+                  guint width,
+                  guint height,
+                  guint8 *dst,
+                  guint iterations)
+{
+    gint64 start = g_get_monotonic_time();
+    for (guint i = 0; i < iterations; i++)
+    {
+        yuv_repack_image(packing->packing, output->output, src, src_size, width, height, dst);
+    }
+    gint64 duration = MAX(g_get_monotonic_time() - start, 1);
+    return (double)width * height * iterations / (double)duration;
+}
+
+int main(int argc, char *argv[])
+{
+    guint width = argc > 1 ? (guint)strtoul(argv[1], NULL, 10) : 1920;
+    guint height = argc > 2 ? (guint)strtoul(argv[2], NULL, 10) : 1080;
+    guint iterations = argc > 3 ? (guint)strtoul(argv[3], NULL, 10) : 100;
+    if (width == 0 || height == 0 || iterations == 0)
+    {
+        fprintf(stderr, "Usage: %s [width] [height] [iterations]\n", argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    // 4:2:2 is the larger of both packed formats
+    gsize max_src_size = ((gsize)width + 1) / 2 * 4 * height;
+    gsize max_dst_size = MAX(yuv_repack_output_size(YUV_OUTPUT_I420, width, height),
+                             yuv_repack_output_size(YUV_OUTPUT_NV12, width, height));
+    guint8 *src = g_malloc(max_src_size);
+    guint8 *dst = g_malloc(max_dst_size);
+    guint8 *reference = g_malloc(max_dst_size);
+    GRand *rand = g_rand_new_with_seed(1);
+    for (gsize i = 0; i < max_src_size; i++)
+    {
+        src[i] = (guint8)g_rand_int(rand);
+    }
+    bool has_mismatch = false;
+
+    printf("Repacking %ux%u images %u times. Throughput in MP/s\n", width, height, iterations);
+    printf("%-6s %-6s %-7s %10s\n", "input", "output", "isa", "MP/s");
+    for (gsize p = 0; p < G_N_ELEMENTS(packings); p++)
+    {
+        gsize src_size =
+            ((gsize)width + packings[p].group_pixels - 1) / packings[p].group_pixels * packings[p].group_size * height;
+        for (gsize o = 0; o < G_N_ELEMENTS(outputs); o++)
+        {
+            gsize dst_size = yuv_repack_output_size(outputs[o].output, width, height);
+            pixel_unpack_set_isa(PIXEL_UNPACK_ISA_SCALAR);
+            run(&packings[p], &outputs[o], src, src_size, width, height, reference, 1);
+
+            for (gsize i = 0; i < G_N_ELEMENTS(isas); i++)
+            {
+                if (!pixel_unpack_isa_supported(isas[i]))
+                {
+                    continue;
+                }
+                pixel_unpack_set_isa(isas[i]);
+                memset(dst, 0, dst_size);
+                double throughput = run(&packings[p], &outputs[o], src, src_size, width, height, dst, iterations);
+                if (memcmp(dst, reference, dst_size) != 0)
+                {
+                    fprintf(stderr,
+                            "%s to %s output of %s kernel differs from scalar kernel\n",
+                            packings[p].name,
+                            outputs[o].name,
+                            pixel_unpack_isa_name(isas[i]));
+                    has_mismatch = true;
+                }
+                printf("%-6s %-6s %-7s %10.0f\n",
+                       packings[p].name,
+                       outputs[o].name,
+                       pixel_unpack_isa_name(isas[i]),
+                       throughput);
+            }
+        }
+    }
+
+    g_rand_free(rand);
+    g_free(reference);
+    g_free(dst);
+    g_free(src);
+    return has_mismatch ? EXIT_FAILURE : EXIT_SUCCESS;
+}
@@ -0,0 +1,176 @@
+// Subset of the VimbaC 1.x API used by gst-vimbasrc. Declarations follow the Vimba SDK so the plugin builds unchanged
+// against the VimbaC mock, which generates synthetic frames instead of talking to a camera. See mock/README.md
+
+#ifndef VIMBAC_H_INCLUDE_
+#define VIMBAC_H_INCLUDE_
+
+#include <VimbaC/Include/VmbCommonTypes.h>
+
+#if defined(_WIN32)
+#define VMB_CALL __stdcall
+#if defined(VIMBA_MOCK_EXPORTS)
+#define IMEXPORTC __declspec(dllexport)
+#else
+#define IMEXPORTC __declspec(dllimport)
+#endif
+#else
+#define VMB_CALL
+#define IMEXPORTC __attribute__((visibility("default")))
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef enum VmbAccessModeType
+{
+    VmbAccessModeNone = 0,
+    VmbAccessModeFull = 1,
+    VmbAccessModeRead = 2,
+    VmbAccessModeConfig = 4,
+    VmbAccessModeLite = 8,
+} VmbAccessModeType;
+typedef VmbUint32_t VmbAccessMode_t;
+
+typedef struct
+{
+    const char *cameraIdString;
+    const char *cameraName;
+    const char *modelName;
+    const char *serialString;
+    VmbAccessMode_t permittedAccess;
+    const char *interfaceIdString;
+} VmbCameraInfo_t;
+
+typedef enum VmbFeaturePersistType
+{
+    VmbFeaturePersistAll = 0,
+    VmbFeaturePersistStreamable = 1,
+    VmbFeaturePersistNoLUT = 2
+} VmbFeaturePersistType;
+typedef VmbUint32_t VmbFeaturePersist_t;
+
+typedef struct
+{
+    VmbFeaturePersist_t persistFlag;
+    VmbUint32_t maxIterations;
+    VmbUint32_t loggingLevel;
+} VmbFeaturePersistSettings_t;
+
+typedef enum VmbFrameStatusType
+{
+    VmbFrameStatusComplete = 0,
+    VmbFrameStatusIncomplete = -1,
+    VmbFrameStatusTooSmall = -2,
+    VmbFrameStatusInvalid = -3,
+} VmbFrameStatusType;
+typedef VmbInt32_t VmbFrameStatus_t;
+
+typedef enum VmbFrameFlagsType
+{
+    VmbFrameFlagsNone = 0,
+    VmbFrameFlagsDimension = 1,
+    VmbFrameFlagsOffset = 2,
+    VmbFrameFlagsFrameID = 4,
+    VmbFrameFlagsTimestamp = 8,
+} VmbFrameFlagsType;
+typedef VmbUint32_t VmbFrameFlags_t;
+
+typedef struct
+{
+    void *buffer;
+    VmbUint32_t bufferSize;
+    void *context[4];
+
+    VmbFrameStatus_t receiveStatus;
+    VmbFrameFlags_t receiveFlags;
+    VmbUint32_t imageSize;
+    VmbUint32_t ancillarySize;
+    VmbPixelFormat_t pixelFormat;
+    VmbUint32_t width;
+    VmbUint32_t height;
+    VmbUint32_t offsetX;
+    VmbUint32_t offsetY;
+    VmbUint64_t frameID;
+    VmbUint64_t timestamp;
+} VmbFrame_t;
+
+typedef void(VMB_CALL *VmbInvalidationCallback)(const VmbHandle_t handle, const char *name, void *pUserContext);
+typedef void(VMB_CALL *VmbFrameCallback)(const VmbHandle_t cameraHandle, VmbFrame_t *pFrame);
+
+IMEXPORTC extern const VmbHandle_t gVimbaHandle;
+
+IMEXPORTC VmbError_t VMB_CALL VmbVersionQuery(VmbVersionInfo_t *pVersionInfo, VmbUint32_t sizeofVersionInfo);
+IMEXPORTC VmbError_t VMB_CALL VmbStartup(void);
+IMEXPORTC void VMB_CALL VmbShutdown(void);
+
+IMEXPORTC VmbError_t VMB_CALL VmbCameraInfoQuery(const char *idCamera,
+                                                 VmbCameraInfo_t *pInfo,
+                                                 VmbUint32_t sizeofCameraInfo);
+IMEXPORTC VmbError_t VMB_CALL VmbCameraOpen(const char *idCamera,
+                                            VmbAccessMode_t accessMode,
+                                            VmbHandle_t *pCameraHandle);
+IMEXPORTC VmbError_t VMB_CALL VmbCameraClose(const VmbHandle_t cameraHandle);
+IMEXPORTC VmbError_t VMB_CALL VmbCameraSettingsLoad(const VmbHandle_t handle,
+                                                    const char *filePath,
+                                                    VmbFeaturePersistSettings_t *pSettings,
+                                                    VmbUint32_t sizeofSettings);
+
+IMEXPORTC VmbError_t VMB_CALL VmbFeatureIntGet(const VmbHandle_t handle, const char *name, VmbInt64_t *pValue);
+IMEXPORTC VmbError_t VMB_CALL VmbFeatureIntSet(const VmbHandle_t handle, const char *name, VmbInt64_t value);
+IMEXPORTC VmbError_t VMB_CALL VmbFeatureIntRangeQuery(const VmbHandle_t handle,
+                                                      const char *name,
+                                                      VmbInt64_t *pMin,
+                                                      VmbInt64_t *pMax);
+IMEXPORTC VmbError_t VMB_CALL VmbFeatureIntIncrementQuery(const VmbHandle_t handle,
+                                                          const char *name,
+                                                          VmbInt64_t *pValue);
+IMEXPORTC VmbError_t VMB_CALL VmbFeatureFloatGet(const VmbHandle_t handle, const char *name, double *pValue);
+IMEXPORTC VmbError_t VMB_CALL VmbFeatureFloatSet(const VmbHandle_t handle, const char *name, double value);
+IMEXPORTC VmbError_t VMB_CALL VmbFeatureFloatRangeQuery(const VmbHandle_t handle,
+                                                        const char *name,
+                                                        double *pMin,
+                                                        double *pMax);
+IMEXPORTC VmbError_t VMB_CALL VmbFeatureEnumGet(const VmbHandle_t handle, const char *name, const char **pValue);
+IMEXPORTC VmbError_t VMB_CALL VmbFeatureEnumSet(const VmbHandle_t handle, const char *name, const char *value);
+IMEXPORTC VmbError_t VMB_CALL VmbFeatureEnumRangeQuery(const VmbHandle_t handle,
+                                                       const char *name,
+                                                       const char **pNameArray,
+                                                       VmbUint32_t arrayLength,
+                                                       VmbUint32_t *pNumFilled);
+IMEXPORTC VmbError_t VMB_CALL VmbFeatureEnumIsAvailable(const VmbHandle_t handle,
+                                                        const char *name,
+                                                        const char *value,
+                                                        VmbBool_t *pIsAvailable);
+IMEXPORTC VmbError_t VMB_CALL VmbFeatureBoolGet(const VmbHandle_t handle, const char *name, VmbBool_t *pValue);
+IMEXPORTC VmbError_t VMB_CALL VmbFeatureBoolSet(const VmbHandle_t handle, const char *name, VmbBool_t value);
+IMEXPORTC VmbError_t VMB_CALL VmbFeatureCommandRun(const VmbHandle_t handle, const char *name);
+IMEXPORTC VmbError_t VMB_CALL VmbFeatureCommandIsDone(const VmbHandle_t handle, const char *name, VmbBool_t *pIsDone);
+IMEXPORTC VmbError_t VMB_CALL VmbFeatureInvalidationRegister(const VmbHandle_t handle,
+                                                             const char *name,
+                                                             VmbInvalidationCallback callback,
+                                                             void *pUserContext);
+IMEXPORTC VmbError_t VMB_CALL VmbFeatureInvalidationUnregister(const VmbHandle_t handle,
+                                                               const char *name,
+                                                               VmbInvalidationCallback callback);
+
+IMEXPORTC VmbError_t VMB_CALL VmbFrameAnnounce(const VmbHandle_t cameraHandle,
+                                               const VmbFrame_t *pFrame,
+                                               VmbUint32_t sizeofFrame);
+IMEXPORTC VmbError_t VMB_CALL VmbFrameRevoke(const VmbHandle_t cameraHandle, const VmbFrame_t *pFrame);
+IMEXPORTC VmbError_t VMB_CALL VmbFrameRevokeAll(const VmbHandle_t cameraHandle);
+IMEXPORTC VmbError_t VMB_CALL VmbCaptureStart(const VmbHandle_t cameraHandle);
+IMEXPORTC VmbError_t VMB_CALL VmbCaptureEnd(const VmbHandle_t cameraHandle);
+IMEXPORTC VmbError_t VMB_CALL VmbCaptureFrameQueue(const VmbHandle_t cameraHandle,
+                                                   const VmbFrame_t *pFrame,
+                                                   VmbFrameCallback callback);
+IMEXPORTC VmbError_t VMB_CALL VmbCaptureQueueFlush(const VmbHandle_t cameraHandle);
+
+IMEXPORTC VmbError_t VMB_CALL VmbAncillaryDataOpen(VmbFrame_t *pFrame, VmbHandle_t *pAncillaryDataHandle);
+IMEXPORTC VmbError_t VMB_CALL VmbAncillaryDataClose(VmbHandle_t ancillaryDataHandle);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // VIMBAC_H_INCLUDE_
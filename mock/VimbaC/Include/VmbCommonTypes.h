@@ -0,0 +1,60 @@
+// Subset of the VimbaC 1.x common type definitions used by gst-vimbasrc. Part of the VimbaC mock, see mock/README.md
+
+#ifndef VMBCOMMONTYPES_H_INCLUDE_
+#define VMBCOMMONTYPES_H_INCLUDE_
+
+typedef signed char VmbInt8_t;
+typedef unsigned char VmbUint8_t;
+typedef short VmbInt16_t;
+typedef unsigned short VmbUint16_t;
+typedef int VmbInt32_t;
+typedef unsigned int VmbUint32_t;
+typedef long long VmbInt64_t;
+typedef unsigned long long VmbUint64_t;
+
+typedef void *VmbHandle_t;
+
+typedef char VmbBool_t;
+typedef enum VmbBoolVal
+{
+    VmbBoolTrue = 1,
+    VmbBoolFalse = 0,
+} VmbBoolVal;
+
+typedef unsigned char VmbUchar_t;
+
+typedef enum VmbErrorType
+{
+    VmbErrorSuccess = 0,
+    VmbErrorInternalFault = -1,
+    VmbErrorApiNotStarted = -2,
+    VmbErrorNotFound = -3,
+    VmbErrorBadHandle = -4,
+    VmbErrorDeviceNotOpen = -5,
+    VmbErrorInvalidAccess = -6,
+    VmbErrorBadParameter = -7,
+    VmbErrorStructSize = -8,
+    VmbErrorMoreData = -9,
+    VmbErrorWrongType = -10,
+    VmbErrorInvalidValue = -11,
+    VmbErrorTimeout = -12,
+    VmbErrorOther = -13,
+    VmbErrorResources = -14,
+    VmbErrorInvalidCall = -15,
+    VmbErrorNoTL = -16,
+    VmbErrorNotImplemented = -17,
+    VmbErrorNotSupported = -18,
+    VmbErrorIncomplete = -19,
+} VmbErrorType;
+typedef VmbInt32_t VmbError_t;
+
+typedef struct
+{
+    VmbUint32_t major;
+    VmbUint32_t minor;
+    VmbUint32_t patch;
+} VmbVersionInfo_t;
+
+typedef VmbUint32_t VmbPixelFormat_t;
+
+#endif // VMBCOMMONTYPES_H_INCLUDE_
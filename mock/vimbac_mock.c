@@ -0,0 +1,1239 @@
+// Stand-in for the VimbaC library that implements the subset of the API used by gst-vimbasrc. Opened cameras generate
+// synthetic frames on their own thread instead of talking to real hardware. The generated stream is configured with
+// environment variables that are read when a camera is opened:
+//
+//  VIMBA_MOCK_WIDTH             Sensor width in pixels (default 1920)
+//  VIMBA_MOCK_HEIGHT            Sensor height in pixels (default 1080)
+//  VIMBA_MOCK_PIXEL_FORMAT      Initial value of the PixelFormat feature (default Mono8)
+//  VIMBA_MOCK_FRAME_RATE        Initial value of the AcquisitionFrameRate feature in Hz (default 30)
+//  VIMBA_MOCK_LINK_THROUGHPUT   Initial value of the DeviceLinkThroughputLimit feature in bytes per second (default
+//                               125000000, the bandwidth of Gigabit Ethernet)
+//  VIMBA_MOCK_INCOMPLETE_RATIO  Fraction of frames that are reported as incomplete (default 0)
+//  VIMBA_MOCK_JITTER_US         Maximum random delay (in us) added to the delivery of each frame (default 0)
+//  VIMBA_MOCK_SEED              Seed of the random number generator (default 1) for reproducible streams
+
+#include <VimbaC/Include/VimbaC.h>
+
+#include <glib.h>
+
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define MOCK_VERSION_MAJOR 1
+#define MOCK_VERSION_MINOR 9
+#define MOCK_VERSION_PATCH 0
+
+#define MOCK_MODEL_NAME "VimbaC mock camera"
+#define MOCK_INTERFACE_ID "VimbaC mock interface"
+
+// Frames can not be delivered faster than this even if the exposure time would allow it
+#define MOCK_MAX_FRAME_RATE 10000.
+
+// Number of invalidation callbacks that can be registered per feature
+#define MOCK_MAX_INVALIDATION_CALLBACKS 4
+
+// Largest factor the BinningHorizontal and BinningVertical features accept
+#define MOCK_MAX_BINNING 4
+
+typedef enum
+{
+    FEATURE_TYPE_INT,
+    FEATURE_TYPE_FLOAT,
+    FEATURE_TYPE_ENUM,
+    FEATURE_TYPE_BOOL,
+    FEATURE_TYPE_COMMAND
+} FeatureType_t;
+
+typedef struct
+{
+    const char *name;
+    FeatureType_t type;
+    bool is_read_only;
+
+    VmbInt64_t int_value;
+    VmbInt64_t int_min;
+    VmbInt64_t int_max;
+
+    double float_value;
+    double float_min;
+    double float_max;
+
+    const char *const *enum_entries;
+    const char *enum_value;
+
+    VmbBool_t bool_value;
+
+    // Registered invalidation callbacks. Unused slots hold NULL
+    VmbInvalidationCallback invalidation_callbacks[MOCK_MAX_INVALIDATION_CALLBACKS];
+    void *invalidation_contexts[MOCK_MAX_INVALIDATION_CALLBACKS];
+} MockFeature_t;
+
+typedef struct
+{
+    const char *name;
+    VmbUint32_t bits_per_pixel;
+} MockPixelFormat_t;
+
+static const MockPixelFormat_t pixel_formats[] = {
+    {"Mono8", 8},
+    {"Mono10", 16},
+    {"Mono10p", 10},
+    {"Mono12", 16},
+    {"Mono12p", 12},
+    {"Mono12Packed", 12},
+    {"Mono14", 16},
+    {"Mono16", 16},
+    {"BayerGR8", 8},
+    {"BayerRG8", 8},
+    {"BayerGB8", 8},
+    {"BayerBG8", 8},
+    {"BayerGR12", 16},
+    {"BayerRG12", 16},
+    {"BayerGB12", 16},
+    {"BayerBG12", 16},
+    {"BayerRG12p", 12},
+    {"RGB8", 24},
+    {"BGR8", 24},
+    {"YUV411Packed", 12},
+    {"YUV422Packed", 16},
+    {"YUV444Packed", 24},
+};
+
+static const char *const pixel_format_entries[] = {
+    "Mono8",
+    "Mono10",
+    "Mono10p",
+    "Mono12",
+    "Mono12p",
+    "Mono12Packed",
+    "Mono14",
+    "Mono16",
+    "BayerGR8",
+    "BayerRG8",
+    "BayerGB8",
+    "BayerBG8",
+    "BayerGR12",
+    "BayerRG12",
+    "BayerGB12",
+    "BayerBG12",
+    "BayerRG12p",
+    "RGB8",
+    "BGR8",
+    "YUV411Packed",
+    "YUV422Packed",
+    "YUV444Packed",
+    NULL};
+static const char *const auto_entries[] = {"Off", "Once", "Continuous", NULL};
+static const char *const trigger_selector_entries[] = {"FrameStart", "AcquisitionStart", "AcquisitionEnd", NULL};
+static const char *const trigger_mode_entries[] = {"Off", "On", NULL};
+static const char *const trigger_source_entries[] = {"Software", "Line0", "Line1", "Line2", "Line3", NULL};
+static const char *const trigger_activation_entries[] = {"RisingEdge", "FallingEdge", "AnyEdge", "LevelHigh",
+                                                         "LevelLow", NULL};
+
+typedef struct
+{
+    VmbFrame_t *frame;
+    VmbFrameCallback callback;
+} QueuedFrame_t;
+
+typedef struct
+{
+    char *id;
+    MockFeature_t *features;
+    guint feature_count;
+    // Size of the sensor. Width and Height are limited to it divided by the binning factors
+    VmbInt64_t sensor_width;
+    VmbInt64_t sensor_height;
+
+    GMutex lock;
+    GCond cond;
+    GThread *thread;
+    bool is_closing;
+
+    // Frames announced with VmbFrameAnnounce
+    GPtrArray *announced_frames;
+    // QueuedFrame_t elements in the order they were queued with VmbCaptureFrameQueue
+    GQueue queued_frames;
+    bool is_capturing;
+    bool is_acquiring;
+    // Set while a frame callback runs. VmbCaptureEnd waits until it returns
+    bool is_in_callback;
+    // Software triggers that were not answered with a frame yet
+    guint pending_triggers;
+
+    VmbUint64_t next_frame_id;
+    // Monotonic time (in us) at which the camera was opened. Frame timestamps are given relative to it in ns
+    gint64 open_time;
+
+    double incomplete_ratio;
+    gint64 jitter;
+    GRand *rand;
+} MockCamera_t;
+
+// Only used to recognise the system handle. The system features are answered without a feature table
+static int system_handle_target;
+const VmbHandle_t gVimbaHandle = &system_handle_target;
+
+static bool is_started = false;
+
+static const char *get_env_string(const char *name, const char *default_value)
+{
+    const char *value = g_getenv(name);
+    return value != NULL && value[0] != '\0' ? value : default_value;
+}
+
+static double get_env_double(const char *name, double default_value)
+{
+    const char *value = g_getenv(name);
+    return value != NULL && value[0] != '\0' ? g_ascii_strtod(value, NULL) : default_value;
+}
+
+static const MockPixelFormat_t *find_pixel_format(const char *name)
+{
+    for (size_t i = 0; i < G_N_ELEMENTS(pixel_formats); i++)
+    {
+        if (strcmp(pixel_formats[i].name, name) == 0)
+        {
+            return &pixel_formats[i];
+        }
+    }
+    return NULL;
+}
+
+static MockFeature_t *find_feature(MockCamera_t *camera, const char *name)
+{
+    for (guint i = 0; i < camera->feature_count; i++)
+    {
+        if (strcmp(camera->features[i].name, name) == 0)
+        {
+            return &camera->features[i];
+        }
+    }
+    return NULL;
+}
+
+static MockFeature_t int_feature(const char *name, VmbInt64_t value, VmbInt64_t min, VmbInt64_t max)
+{
+    return (MockFeature_t){.name = name, .type = FEATURE_TYPE_INT, .int_value = value, .int_min = min, .int_max = max};
+}
+
+static MockFeature_t float_feature(const char *name, double value, double min, double max)
+{
+    return (MockFeature_t){.name = name,
+                           .type = FEATURE_TYPE_FLOAT,
+                           .float_value = value,
+                           .float_min = min,
+                           .float_max = max};
+}
+
+static MockFeature_t enum_feature(const char *name, const char *const *entries, const char *value)
+{
+    return (MockFeature_t){.name = name, .type = FEATURE_TYPE_ENUM, .enum_entries = entries, .enum_value = value};
+}
+
+static MockFeature_t command_feature(const char *name)
+{
+    return (MockFeature_t){.name = name, .type = FEATURE_TYPE_COMMAND};
+}
+
+static void create_features(MockCamera_t *camera)
+{
+    VmbInt64_t sensor_width = (VmbInt64_t)get_env_double("VIMBA_MOCK_WIDTH", 1920);
+    VmbInt64_t sensor_height = (VmbInt64_t)get_env_double("VIMBA_MOCK_HEIGHT", 1080);
+    sensor_width = MAX(sensor_width, 8);
+    sensor_height = MAX(sensor_height, 8);
+
+    const char *pixel_format = get_env_string("VIMBA_MOCK_PIXEL_FORMAT", "Mono8");
+    if (find_pixel_format(pixel_format) == NULL)
+    {
+        fprintf(stderr, "VimbaC mock: Unsupported pixel format \"%s\". Using Mono8 instead\n", pixel_format);
+        pixel_format = "Mono8";
+    }
+    // Enum values are returned as pointers into the entry list
+    for (size_t i = 0; pixel_format_entries[i] != NULL; i++)
+    {
+        if (strcmp(pixel_format_entries[i], pixel_format) == 0)
+        {
+            pixel_format = pixel_format_entries[i];
+        }
+    }
+    double frame_rate = CLAMP(get_env_double("VIMBA_MOCK_FRAME_RATE", 30.), 0.01, MOCK_MAX_FRAME_RATE);
+    VmbInt64_t link_throughput = (VmbInt64_t)get_env_double("VIMBA_MOCK_LINK_THROUGHPUT", 125000000.);
+    link_throughput = MAX(link_throughput, 1);
+
+    MockFeature_t features[] = {
+        int_feature("Width", sensor_width, 8, sensor_width),
+        int_feature("Height", sensor_height, 8, sensor_height),
+        int_feature("OffsetX", 0, 0, 0),
+        int_feature("OffsetY", 0, 0, 0),
+        int_feature("BinningHorizontal", 1, 1, MOCK_MAX_BINNING),
+        int_feature("BinningVertical", 1, 1, MOCK_MAX_BINNING),
+        int_feature("PayloadSize", 0, 0, G_MAXINT32),
+        float_feature("ExposureTime", 1000., 10., 10000000.),
+        float_feature("Gain", 0., 0., 24.),
+        float_feature("AcquisitionFrameRate", frame_rate, 0.01, MOCK_MAX_FRAME_RATE),
+        enum_feature("PixelFormat", pixel_format_entries, pixel_format),
+        enum_feature("ExposureAuto", auto_entries, "Off"),
+        enum_feature("BalanceWhiteAuto", auto_entries, "Off"),
+        enum_feature("TriggerSelector", trigger_selector_entries, "FrameStart"),
+        enum_feature("TriggerMode", trigger_mode_entries, "Off"),
+        enum_feature("TriggerSource", trigger_source_entries, "Software"),
+        enum_feature("TriggerActivation", trigger_activation_entries, "RisingEdge"),
+        command_feature("AcquisitionStart"),
+        command_feature("AcquisitionStop"),
+        command_feature("TriggerSoftware"),
+        int_feature("DeviceLinkThroughputLimit", link_throughput, 1, G_MAXINT64),
+    };
+    features[6].is_read_only = true;
+
+    camera->sensor_width = sensor_width;
+    camera->sensor_height = sensor_height;
+    camera->feature_count = G_N_ELEMENTS(features);
+    camera->features = g_new(MockFeature_t, camera->feature_count);
+    memcpy(camera->features, features, sizeof(features));
+}
+
+// Must be called with the camera lock held
+static void update_dependent_features(MockCamera_t *camera)
+{
+    MockFeature_t *width = find_feature(camera, "Width");
+    MockFeature_t *height = find_feature(camera, "Height");
+    MockFeature_t *offset_x = find_feature(camera, "OffsetX");
+    MockFeature_t *offset_y = find_feature(camera, "OffsetY");
+    // Binning reduces the size of the sensor. The ROI is shrunk if it no longer fits
+    width->int_max = MAX(camera->sensor_width / find_feature(camera, "BinningHorizontal")->int_value, width->int_min);
+    height->int_max = MAX(camera->sensor_height / find_feature(camera, "BinningVertical")->int_value, height->int_min);
+    width->int_value = MIN(width->int_value, width->int_max);
+    height->int_value = MIN(height->int_value, height->int_max);
+    offset_x->int_value = MIN(offset_x->int_value, width->int_max - width->int_value);
+    offset_y->int_value = MIN(offset_y->int_value, height->int_max - height->int_value);
+    offset_x->int_max = width->int_max - width->int_value;
+    offset_y->int_max = height->int_max - height->int_value;
+
+    const MockPixelFormat_t *format = find_pixel_format(find_feature(camera, "PixelFormat")->enum_value);
+    find_feature(camera, "PayloadSize")->int_value =
+        (width->int_value * height->int_value * format->bits_per_pixel + 7) / 8;
+}
+
+static MockCamera_t *get_camera(const VmbHandle_t handle)
+{
+    return handle != NULL && handle != gVimbaHandle ? (MockCamera_t *)handle : NULL;
+}
+
+// Invalidation callbacks are called without holding the camera lock so they may access features
+static void notify_invalidation(MockFeature_t *feature, VmbHandle_t handle)
+{
+    for (size_t i = 0; i < MOCK_MAX_INVALIDATION_CALLBACKS; i++)
+    {
+        if (feature->invalidation_callbacks[i] != NULL)
+        {
+            feature->invalidation_callbacks[i](handle, feature->name, feature->invalidation_contexts[i]);
+        }
+    }
+}
+
+static void fill_frame(MockCamera_t *camera, VmbFrame_t *frame, bool is_incomplete)
+{
+    VmbInt64_t width = find_feature(camera, "Width")->int_value;
+    VmbInt64_t height = find_feature(camera, "Height")->int_value;
+    VmbUint32_t payload_size = (VmbUint32_t)find_feature(camera, "PayloadSize")->int_value;
+
+    frame->receiveFlags = VmbFrameFlagsDimension | VmbFrameFlagsOffset | VmbFrameFlagsFrameID | VmbFrameFlagsTimestamp;
+    frame->width = (VmbUint32_t)width;
+    frame->height = (VmbUint32_t)height;
+    frame->offsetX = (VmbUint32_t)find_feature(camera, "OffsetX")->int_value;
+    frame->offsetY = (VmbUint32_t)find_feature(camera, "OffsetY")->int_value;
+    frame->ancillarySize = 0;
+    frame->pixelFormat = 0;
+
+    if (frame->bufferSize < payload_size)
+    {
+        frame->receiveStatus = VmbFrameStatusTooSmall;
+        frame->imageSize = 0;
+        return;
+    }
+
+    // Rows with a brightness that moves with every frame. Cheap to generate and makes dropped frames visible
+    VmbUint32_t row_size = payload_size / (VmbUint32_t)height;
+    VmbInt64_t filled_rows = is_incomplete ? height / 2 : height;
+    guint8 *data = frame->buffer;
+    for (VmbInt64_t row = 0; row < filled_rows; row++)
+    {
+        memset(data + row * row_size, (int)((row + (VmbInt64_t)frame->frameID) & 0xff), row_size);
+    }
+    frame->receiveStatus = is_incomplete ? VmbFrameStatusIncomplete : VmbFrameStatusComplete;
+    frame->imageSize = payload_size;
+}
+
+// Must be called with the camera lock held
+static gint64 get_frame_period(MockCamera_t *camera)
+{
+    double frame_rate = find_feature(camera, "AcquisitionFrameRate")->float_value;
+    double exposure_time = find_feature(camera, "ExposureTime")->float_value;
+    // The camera can not deliver frames faster than it exposes them
+    return MAX((gint64)(G_USEC_PER_SEC / frame_rate), (gint64)exposure_time);
+}
+
+// Must be called with the camera lock held
+static bool is_triggered(MockCamera_t *camera)
+{
+    return strcmp(find_feature(camera, "TriggerMode")->enum_value, "On") == 0;
+}
+
+static gpointer capture_thread(gpointer data)
+{
+    MockCamera_t *camera = data;
+    gint64 next_frame_time = 0;
+
+    g_mutex_lock(&camera->lock);
+    while (!camera->is_closing)
+    {
+        if (!camera->is_capturing || !camera->is_acquiring)
+        {
+            g_cond_wait(&camera->cond, &camera->lock);
+            next_frame_time = g_get_monotonic_time();
+            continue;
+        }
+
+        if (is_triggered(camera))
+        {
+            if (camera->pending_triggers == 0)
+            {
+                g_cond_wait(&camera->cond, &camera->lock);
+                continue;
+            }
+            camera->pending_triggers--;
+            // Exposure and readout of the triggered frame
+            next_frame_time = g_get_monotonic_time() + get_frame_period(camera);
+        }
+        gint64 exposure_time = next_frame_time;
+        gint64 delivery_time = next_frame_time;
+        if (camera->jitter > 0)
+        {
+            delivery_time += g_rand_int_range(camera->rand, 0, (gint32)MIN(camera->jitter, G_MAXINT32));
+        }
+        // Waiting is interrupted if the acquisition is stopped or the camera is closed
+        bool is_interrupted = false;
+        while (g_get_monotonic_time() < delivery_time && !is_interrupted)
+        {
+            g_cond_wait_until(&camera->cond, &camera->lock, delivery_time);
+            is_interrupted = camera->is_closing || !camera->is_capturing || !camera->is_acquiring;
+        }
+        if (is_interrupted)
+        {
+            continue;
+        }
+        if (!is_triggered(camera))
+        {
+            next_frame_time += get_frame_period(camera);
+            // Skip frames the camera could not have recorded if the thread fell behind by more than a second
+            next_frame_time = MAX(next_frame_time, g_get_monotonic_time() - G_USEC_PER_SEC);
+        }
+
+        VmbUint64_t frame_id = camera->next_frame_id++;
+        QueuedFrame_t *queued_frame = g_queue_pop_head(&camera->queued_frames);
+        if (queued_frame == NULL)
+        {
+            // No frame to capture into. The frame is lost, which shows as a gap in the frame IDs
+            continue;
+        }
+        bool is_incomplete = camera->incomplete_ratio > 0. && g_rand_double(camera->rand) < camera->incomplete_ratio;
+
+        VmbFrame_t *frame = queued_frame->frame;
+        VmbFrameCallback callback = queued_frame->callback;
+        g_free(queued_frame);
+        frame->frameID = frame_id;
+        frame->timestamp = (VmbUint64_t)(exposure_time - camera->open_time) * 1000;
+        fill_frame(camera, frame, is_incomplete);
+
+        camera->is_in_callback = true;
+        g_mutex_unlock(&camera->lock);
+        callback(camera, frame);
+        g_mutex_lock(&camera->lock);
+        camera->is_in_callback = false;
+        g_cond_broadcast(&camera->cond);
+    }
+    g_mutex_unlock(&camera->lock);
+
+    return NULL;
+}
+
+VmbError_t VMB_CALL VmbVersionQuery(VmbVersionInfo_t *pVersionInfo, VmbUint32_t sizeofVersionInfo)
+{
+    if (pVersionInfo == NULL)
+    {
+        return VmbErrorBadParameter;
+    }
+    if (sizeofVersionInfo != sizeof(VmbVersionInfo_t))
+    {
+        return VmbErrorStructSize;
+    }
+    pVersionInfo->major = MOCK_VERSION_MAJOR;
+    pVersionInfo->minor = MOCK_VERSION_MINOR;
+    pVersionInfo->patch = MOCK_VERSION_PATCH;
+    return VmbErrorSuccess;
+}
+
+VmbError_t VMB_CALL VmbStartup(void)
+{
+    is_started = true;
+    return VmbErrorSuccess;
+}
+
+void VMB_CALL VmbShutdown(void)
+{
+    is_started = false;
+}
+
+VmbError_t VMB_CALL VmbCameraInfoQuery(const char *idCamera, VmbCameraInfo_t *pInfo, VmbUint32_t sizeofCameraInfo)
+{
+    if (!is_started)
+    {
+        return VmbErrorApiNotStarted;
+    }
+    if (idCamera == NULL || pInfo == NULL)
+    {
+        return VmbErrorBadParameter;
+    }
+    if (sizeofCameraInfo != sizeof(VmbCameraInfo_t))
+    {
+        return VmbErrorStructSize;
+    }
+    // Every camera ID refers to a mock camera
+    pInfo->cameraIdString = idCamera;
+    pInfo->cameraName = MOCK_MODEL_NAME;
+    pInfo->modelName = MOCK_MODEL_NAME;
+    pInfo->serialString = idCamera;
+    pInfo->permittedAccess = VmbAccessModeFull | VmbAccessModeRead | VmbAccessModeConfig;
+    pInfo->interfaceIdString = MOCK_INTERFACE_ID;
+    return VmbErrorSuccess;
+}
+
+VmbError_t VMB_CALL VmbCameraOpen(const char *idCamera, VmbAccessMode_t accessMode, VmbHandle_t *pCameraHandle)
+{
+    (void)accessMode;
+    if (!is_started)
+    {
+        return VmbErrorApiNotStarted;
+    }
+    if (idCamera == NULL || pCameraHandle == NULL)
+    {
+        return VmbErrorBadParameter;
+    }
+
+    MockCamera_t *camera = g_new0(MockCamera_t, 1);
+    camera->id = g_strdup(idCamera);
+    create_features(camera);
+    update_dependent_features(camera);
+    g_mutex_init(&camera->lock);
+    g_cond_init(&camera->cond);
+    camera->announced_frames = g_ptr_array_new();
+    g_queue_init(&camera->queued_frames);
+    camera->open_time = g_get_monotonic_time();
+    camera->incomplete_ratio = CLAMP(get_env_double("VIMBA_MOCK_INCOMPLETE_RATIO", 0.), 0., 1.);
+    camera->jitter = (gint64)MAX(get_env_double("VIMBA_MOCK_JITTER_US", 0.), 0.);
+    camera->rand = g_rand_new_with_seed((guint32)get_env_double("VIMBA_MOCK_SEED", 1.));
+    camera->thread = g_thread_new("vimbac-mock", capture_thread, camera);
+
+    *pCameraHandle = camera;
+    return VmbErrorSuccess;
+}
+
+VmbError_t VMB_CALL VmbCameraClose(const VmbHandle_t cameraHandle)
+{
+    MockCamera_t *camera = get_camera(cameraHandle);
+    if (camera == NULL)
+    {
+        return VmbErrorBadHandle;
+    }
+
+    g_mutex_lock(&camera->lock);
+    camera->is_closing = true;
+    g_cond_broadcast(&camera->cond);
+    g_mutex_unlock(&camera->lock);
+    g_thread_join(camera->thread);
+
+    g_queue_clear_full(&camera->queued_frames, g_free);
+    g_ptr_array_free(camera->announced_frames, TRUE);
+    g_rand_free(camera->rand);
+    g_cond_clear(&camera->cond);
+    g_mutex_clear(&camera->lock);
+    g_free(camera->features);
+    g_free(camera->id);
+    g_free(camera);
+    return VmbErrorSuccess;
+}
+
+VmbError_t VMB_CALL VmbCameraSettingsLoad(const VmbHandle_t handle,
+                                          const char *filePath,
+                                          VmbFeaturePersistSettings_t *pSettings,
+                                          VmbUint32_t sizeofSettings)
+{
+    (void)handle;
+    (void)filePath;
+    (void)pSettings;
+    (void)sizeofSettings;
+    return VmbErrorNotSupported;
+}
+
+// Looks up a feature of the given type and locks the camera. On success the caller must unlock the camera
+static VmbError_t lock_feature(const VmbHandle_t handle,
+                               const char *name,
+                               FeatureType_t type,
+                               MockCamera_t **camera,
+                               MockFeature_t **feature)
+{
+    *camera = get_camera(handle);
+    if (*camera == NULL)
+    {
+        return handle == gVimbaHandle ? VmbErrorNotFound : VmbErrorBadHandle;
+    }
+    if (name == NULL)
+    {
+        return VmbErrorBadParameter;
+    }
+    g_mutex_lock(&(*camera)->lock);
+    *feature = find_feature(*camera, name);
+    if (*feature == NULL || (*feature)->type != type)
+    {
+        g_mutex_unlock(&(*camera)->lock);
+        return *feature == NULL ? VmbErrorNotFound : VmbErrorWrongType;
+    }
+    return VmbErrorSuccess;
+}
+
+// Width, height, binning and pixel format can not be changed while the camera is acquiring. Like on many cameras, the
+// offsets can be changed to move the ROI during the acquisition
+static bool is_locked_while_acquiring(const MockFeature_t *feature)
+{
+    return strcmp(feature->name, "Width") == 0 || strcmp(feature->name, "Height") == 0 ||
+           strcmp(feature->name, "BinningHorizontal") == 0 || strcmp(feature->name, "BinningVertical") == 0 ||
+           strcmp(feature->name, "PixelFormat") == 0;
+}
+
+VmbError_t VMB_CALL VmbFeatureIntGet(const VmbHandle_t handle, const char *name, VmbInt64_t *pValue)
+{
+    MockCamera_t *camera;
+    MockFeature_t *feature;
+    if (pValue == NULL)
+    {
+        return VmbErrorBadParameter;
+    }
+    VmbError_t result = lock_feature(handle, name, FEATURE_TYPE_INT, &camera, &feature);
+    if (result == VmbErrorSuccess)
+    {
+        *pValue = feature->int_value;
+        g_mutex_unlock(&camera->lock);
+    }
+    return result;
+}
+
+VmbError_t VMB_CALL VmbFeatureIntSet(const VmbHandle_t handle, const char *name, VmbInt64_t value)
+{
+    MockCamera_t *camera;
+    MockFeature_t *feature;
+    if (handle == gVimbaHandle)
+    {
+        // System features configuring the GigE discovery are accepted without effect
+        return VmbErrorSuccess;
+    }
+    VmbError_t result = lock_feature(handle, name, FEATURE_TYPE_INT, &camera, &feature);
+    if (result != VmbErrorSuccess)
+    {
+        return result;
+    }
+    if (feature->is_read_only || (camera->is_acquiring && is_locked_while_acquiring(feature)))
+    {
+        result = VmbErrorInvalidAccess;
+    }
+    else if (value < feature->int_min || value > feature->int_max)
+    {
+        result = VmbErrorInvalidValue;
+    }
+    else
+    {
+        feature->int_value = value;
+        update_dependent_features(camera);
+    }
+    g_mutex_unlock(&camera->lock);
+    if (result == VmbErrorSuccess)
+    {
+        notify_invalidation(feature, handle);
+    }
+    return result;
+}
+
+VmbError_t VMB_CALL VmbFeatureIntRangeQuery(const VmbHandle_t handle,
+                                            const char *name,
+                                            VmbInt64_t *pMin,
+                                            VmbInt64_t *pMax)
+{
+    MockCamera_t *camera;
+    MockFeature_t *feature;
+    VmbError_t result = lock_feature(handle, name, FEATURE_TYPE_INT, &camera, &feature);
+    if (result == VmbErrorSuccess)
+    {
+        if (pMin != NULL)
+        {
+            *pMin = feature->int_min;
+        }
+        if (pMax != NULL)
+        {
+            *pMax = feature->int_max;
+        }
+        g_mutex_unlock(&camera->lock);
+    }
+    return result;
+}
+
+// All integer features accept every value within their range
+VmbError_t VMB_CALL VmbFeatureIntIncrementQuery(const VmbHandle_t handle, const char *name, VmbInt64_t *pValue)
+{
+    MockCamera_t *camera;
+    MockFeature_t *feature;
+    if (pValue == NULL)
+    {
+        return VmbErrorBadParameter;
+    }
+    VmbError_t result = lock_feature(handle, name, FEATURE_TYPE_INT, &camera, &feature);
+    if (result == VmbErrorSuccess)
+    {
+        *pValue = 1;
+        g_mutex_unlock(&camera->lock);
+    }
+    return result;
+}
+
+VmbError_t VMB_CALL VmbFeatureFloatGet(const VmbHandle_t handle, const char *name, double *pValue)
+{
+    MockCamera_t *camera;
+    MockFeature_t *feature;
+    if (pValue == NULL)
+    {
+        return VmbErrorBadParameter;
+    }
+    VmbError_t result = lock_feature(handle, name, FEATURE_TYPE_FLOAT, &camera, &feature);
+    if (result == VmbErrorSuccess)
+    {
+        *pValue = feature->float_value;
+        g_mutex_unlock(&camera->lock);
+    }
+    return result;
+}
+
+VmbError_t VMB_CALL VmbFeatureFloatRangeQuery(const VmbHandle_t handle, const char *name, double *pMin, double *pMax)
+{
+    MockCamera_t *camera;
+    MockFeature_t *feature;
+    VmbError_t result = lock_feature(handle, name, FEATURE_TYPE_FLOAT, &camera, &feature);
+    if (result == VmbErrorSuccess)
+    {
+        if (pMin != NULL)
+        {
+            *pMin = feature->float_min;
+        }
+        if (pMax != NULL)
+        {
+            *pMax = feature->float_max;
+        }
+        g_mutex_unlock(&camera->lock);
+    }
+    return result;
+}
+
+VmbError_t VMB_CALL VmbFeatureFloatSet(const VmbHandle_t handle, const char *name, double value)
+{
+    MockCamera_t *camera;
+    MockFeature_t *feature;
+    VmbError_t result = lock_feature(handle, name, FEATURE_TYPE_FLOAT, &camera, &feature);
+    if (result != VmbErrorSuccess)
+    {
+        return result;
+    }
+    if (value < feature->float_min || value > feature->float_max)
+    {
+        result = VmbErrorInvalidValue;
+    }
+    else
+    {
+        feature->float_value = value;
+        // A new frame rate or exposure time applies to the next frame
+        g_cond_broadcast(&camera->cond);
+    }
+    g_mutex_unlock(&camera->lock);
+    if (result == VmbErrorSuccess)
+    {
+        notify_invalidation(feature, handle);
+    }
+    return result;
+}
+
+VmbError_t VMB_CALL VmbFeatureEnumGet(const VmbHandle_t handle, const char *name, const char **pValue)
+{
+    MockCamera_t *camera;
+    MockFeature_t *feature;
+    if (pValue == NULL)
+    {
+        return VmbErrorBadParameter;
+    }
+    VmbError_t result = lock_feature(handle, name, FEATURE_TYPE_ENUM, &camera, &feature);
+    if (result == VmbErrorSuccess)
+    {
+        *pValue = feature->enum_value;
+        g_mutex_unlock(&camera->lock);
+    }
+    return result;
+}
+
+VmbError_t VMB_CALL VmbFeatureEnumSet(const VmbHandle_t handle, const char *name, const char *value)
+{
+    MockCamera_t *camera;
+    MockFeature_t *feature;
+    if (value == NULL)
+    {
+        return VmbErrorBadParameter;
+    }
+    VmbError_t result = lock_feature(handle, name, FEATURE_TYPE_ENUM, &camera, &feature);
+    if (result != VmbErrorSuccess)
+    {
+        return result;
+    }
+    result = VmbErrorInvalidValue;
+    if (camera->is_acquiring && is_locked_while_acquiring(feature))
+    {
+        result = VmbErrorInvalidAccess;
+    }
+    else
+    {
+        for (size_t i = 0; feature->enum_entries[i] != NULL; i++)
+        {
+            if (strcmp(feature->enum_entries[i], value) == 0)
+            {
+                feature->enum_value = feature->enum_entries[i];
+                update_dependent_features(camera);
+                g_cond_broadcast(&camera->cond);
+                result = VmbErrorSuccess;
+                break;
+            }
+        }
+    }
+    g_mutex_unlock(&camera->lock);
+    if (result == VmbErrorSuccess)
+    {
+        notify_invalidation(feature, handle);
+    }
+    return result;
+}
+
+VmbError_t VMB_CALL VmbFeatureEnumRangeQuery(const VmbHandle_t handle,
+                                             const char *name,
+                                             const char **pNameArray,
+                                             VmbUint32_t arrayLength,
+                                             VmbUint32_t *pNumFilled)
+{
+    MockCamera_t *camera;
+    MockFeature_t *feature;
+    VmbError_t result = lock_feature(handle, name, FEATURE_TYPE_ENUM, &camera, &feature);
+    if (result != VmbErrorSuccess)
+    {
+        return result;
+    }
+    VmbUint32_t entry_count = 0;
+    while (feature->enum_entries[entry_count] != NULL)
+    {
+        entry_count++;
+    }
+    if (pNameArray == NULL)
+    {
+        // Only the number of entries is requested
+        if (pNumFilled != NULL)
+        {
+            *pNumFilled = entry_count;
+        }
+    }
+    else
+    {
+        VmbUint32_t filled_count = MIN(entry_count, arrayLength);
+        for (VmbUint32_t i = 0; i < filled_count; i++)
+        {
+            pNameArray[i] = feature->enum_entries[i];
+        }
+        if (pNumFilled != NULL)
+        {
+            *pNumFilled = filled_count;
+        }
+        if (filled_count < entry_count)
+        {
+            result = VmbErrorMoreData;
+        }
+    }
+    g_mutex_unlock(&camera->lock);
+    return result;
+}
+
+VmbError_t VMB_CALL VmbFeatureEnumIsAvailable(const VmbHandle_t handle,
+                                              const char *name,
+                                              const char *value,
+                                              VmbBool_t *pIsAvailable)
+{
+    MockCamera_t *camera;
+    MockFeature_t *feature;
+    if (value == NULL || pIsAvailable == NULL)
+    {
+        return VmbErrorBadParameter;
+    }
+    VmbError_t result = lock_feature(handle, name, FEATURE_TYPE_ENUM, &camera, &feature);
+    if (result != VmbErrorSuccess)
+    {
+        return result;
+    }
+    result = VmbErrorInvalidValue;
+    for (size_t i = 0; feature->enum_entries[i] != NULL; i++)
+    {
+        if (strcmp(feature->enum_entries[i], value) == 0)
+        {
+            *pIsAvailable = VmbBoolTrue;
+            result = VmbErrorSuccess;
+            break;
+        }
+    }
+    g_mutex_unlock(&camera->lock);
+    return result;
+}
+
+VmbError_t VMB_CALL VmbFeatureBoolGet(const VmbHandle_t handle, const char *name, VmbBool_t *pValue)
+{
+    if (pValue == NULL || name == NULL)
+    {
+        return VmbErrorBadParameter;
+    }
+    if (handle == gVimbaHandle && strcmp(name, "GeVTLIsPresent") == 0)
+    {
+        // There is no GigE transport layer that would need camera discovery
+        *pValue = VmbBoolFalse;
+        return VmbErrorSuccess;
+    }
+
+    MockCamera_t *camera;
+    MockFeature_t *feature;
+    VmbError_t result = lock_feature(handle, name, FEATURE_TYPE_BOOL, &camera, &feature);
+    if (result == VmbErrorSuccess)
+    {
+        *pValue = feature->bool_value;
+        g_mutex_unlock(&camera->lock);
+    }
+    return result;
+}
+
+VmbError_t VMB_CALL VmbFeatureBoolSet(const VmbHandle_t handle, const char *name, VmbBool_t value)
+{
+    MockCamera_t *camera;
+    MockFeature_t *feature;
+    VmbError_t result = lock_feature(handle, name, FEATURE_TYPE_BOOL, &camera, &feature);
+    if (result != VmbErrorSuccess)
+    {
+        return result;
+    }
+    if (feature->is_read_only)
+    {
+        result = VmbErrorInvalidAccess;
+    }
+    else
+    {
+        feature->bool_value = value;
+    }
+    g_mutex_unlock(&camera->lock);
+    if (result == VmbErrorSuccess)
+    {
+        notify_invalidation(feature, handle);
+    }
+    return result;
+}
+
+VmbError_t VMB_CALL VmbFeatureCommandRun(const VmbHandle_t handle, const char *name)
+{
+    MockCamera_t *camera;
+    MockFeature_t *feature;
+    VmbError_t result = lock_feature(handle, name, FEATURE_TYPE_COMMAND, &camera, &feature);
+    if (result != VmbErrorSuccess)
+    {
+        return result;
+    }
+    if (strcmp(name, "AcquisitionStart") == 0)
+    {
+        camera->is_acquiring = true;
+    }
+    else if (strcmp(name, "AcquisitionStop") == 0)
+    {
+        camera->is_acquiring = false;
+    }
+    else if (strcmp(name, "TriggerSoftware") == 0)
+    {
+        if (is_triggered(camera) && strcmp(find_feature(camera, "TriggerSource")->enum_value, "Software") == 0)
+        {
+            camera->pending_triggers++;
+        }
+    }
+    g_cond_broadcast(&camera->cond);
+    g_mutex_unlock(&camera->lock);
+    return VmbErrorSuccess;
+}
+
+VmbError_t VMB_CALL VmbFeatureCommandIsDone(const VmbHandle_t handle, const char *name, VmbBool_t *pIsDone)
+{
+    MockCamera_t *camera;
+    MockFeature_t *feature;
+    if (pIsDone == NULL)
+    {
+        return VmbErrorBadParameter;
+    }
+    VmbError_t result = lock_feature(handle, name, FEATURE_TYPE_COMMAND, &camera, &feature);
+    if (result == VmbErrorSuccess)
+    {
+        // Commands take effect immediately
+        *pIsDone = VmbBoolTrue;
+        g_mutex_unlock(&camera->lock);
+    }
+    return result;
+}
+
+VmbError_t VMB_CALL VmbFeatureInvalidationRegister(const VmbHandle_t handle,
+                                                   const char *name,
+                                                   VmbInvalidationCallback callback,
+                                                   void *pUserContext)
+{
+    MockCamera_t *camera = get_camera(handle);
+    if (camera == NULL)
+    {
+        return VmbErrorBadHandle;
+    }
+    if (name == NULL || callback == NULL)
+    {
+        return VmbErrorBadParameter;
+    }
+    g_mutex_lock(&camera->lock);
+    MockFeature_t *feature = find_feature(camera, name);
+    VmbError_t result = feature != NULL ? VmbErrorResources : VmbErrorNotFound;
+    // Registering the same callback again only replaces its context, like Vimba does
+    for (size_t i = 0; feature != NULL && i < MOCK_MAX_INVALIDATION_CALLBACKS; i++)
+    {
+        if (feature->invalidation_callbacks[i] == callback)
+        {
+            feature->invalidation_contexts[i] = pUserContext;
+            result = VmbErrorSuccess;
+            break;
+        }
+    }
+    for (size_t i = 0; result == VmbErrorResources && i < MOCK_MAX_INVALIDATION_CALLBACKS; i++)
+    {
+        if (feature->invalidation_callbacks[i] == NULL)
+        {
+            feature->invalidation_callbacks[i] = callback;
+            feature->invalidation_contexts[i] = pUserContext;
+            result = VmbErrorSuccess;
+        }
+    }
+    g_mutex_unlock(&camera->lock);
+    return result;
+}
+
+VmbError_t VMB_CALL VmbFeatureInvalidationUnregister(const VmbHandle_t handle,
+                                                     const char *name,
+                                                     VmbInvalidationCallback callback)
+{
+    MockCamera_t *camera = get_camera(handle);
+    if (camera == NULL)
+    {
+        return VmbErrorBadHandle;
+    }
+    if (name == NULL)
+    {
+        return VmbErrorBadParameter;
+    }
+    g_mutex_lock(&camera->lock);
+    MockFeature_t *feature = find_feature(camera, name);
+    bool is_registered = false;
+    for (size_t i = 0; feature != NULL && i < MOCK_MAX_INVALIDATION_CALLBACKS; i++)
+    {
+        if (feature->invalidation_callbacks[i] == callback)
+        {
+            feature->invalidation_callbacks[i] = NULL;
+            feature->invalidation_contexts[i] = NULL;
+            is_registered = true;
+        }
+    }
+    g_mutex_unlock(&camera->lock);
+    return is_registered ? VmbErrorSuccess : VmbErrorNotFound;
+}
+
+VmbError_t VMB_CALL VmbFrameAnnounce(const VmbHandle_t cameraHandle, const VmbFrame_t *pFrame, VmbUint32_t sizeofFrame)
+{
+    MockCamera_t *camera = get_camera(cameraHandle);
+    if (camera == NULL)
+    {
+        return VmbErrorBadHandle;
+    }
+    if (pFrame == NULL || pFrame->buffer == NULL)
+    {
+        return VmbErrorBadParameter;
+    }
+    if (sizeofFrame != sizeof(VmbFrame_t))
+    {
+        return VmbErrorStructSize;
+    }
+    g_mutex_lock(&camera->lock);
+    g_ptr_array_add(camera->announced_frames, (gpointer)pFrame);
+    g_mutex_unlock(&camera->lock);
+    return VmbErrorSuccess;
+}
+
+static gboolean is_queued_frame(gconstpointer queued_frame, gconstpointer frame)
+{
+    return ((const QueuedFrame_t *)queued_frame)->frame == frame;
+}
+
+// Must be called with the camera lock held
+static void remove_from_queue(MockCamera_t *camera, const VmbFrame_t *frame)
+{
+    GList *link = g_queue_find_custom(&camera->queued_frames, frame, (GCompareFunc)is_queued_frame);
+    if (link != NULL)
+    {
+        g_free(link->data);
+        g_queue_delete_link(&camera->queued_frames, link);
+    }
+}
+
+VmbError_t VMB_CALL VmbFrameRevoke(const VmbHandle_t cameraHandle, const VmbFrame_t *pFrame)
+{
+    MockCamera_t *camera = get_camera(cameraHandle);
+    if (camera == NULL)
+    {
+        return VmbErrorBadHandle;
+    }
+    g_mutex_lock(&camera->lock);
+    bool is_announced = g_ptr_array_remove(camera->announced_frames, (gpointer)pFrame);
+    if (is_announced)
+    {
+        remove_from_queue(camera, pFrame);
+    }
+    g_mutex_unlock(&camera->lock);
+    return is_announced ? VmbErrorSuccess : VmbErrorBadParameter;
+}
+
+VmbError_t VMB_CALL VmbFrameRevokeAll(const VmbHandle_t cameraHandle)
+{
+    MockCamera_t *camera = get_camera(cameraHandle);
+    if (camera == NULL)
+    {
+        return VmbErrorBadHandle;
+    }
+    g_mutex_lock(&camera->lock);
+    g_ptr_array_set_size(camera->announced_frames, 0);
+    g_queue_clear_full(&camera->queued_frames, g_free);
+    g_queue_init(&camera->queued_frames);
+    g_mutex_unlock(&camera->lock);
+    return VmbErrorSuccess;
+}
+
+VmbError_t VMB_CALL VmbCaptureStart(const VmbHandle_t cameraHandle)
+{
+    MockCamera_t *camera = get_camera(cameraHandle);
+    if (camera == NULL)
+    {
+        return VmbErrorBadHandle;
+    }
+    g_mutex_lock(&camera->lock);
+    VmbError_t result = camera->is_capturing ? VmbErrorInvalidCall : VmbErrorSuccess;
+    camera->is_capturing = true;
+    g_cond_broadcast(&camera->cond);
+    g_mutex_unlock(&camera->lock);
+    return result;
+}
+
+VmbError_t VMB_CALL VmbCaptureEnd(const VmbHandle_t cameraHandle)
+{
+    MockCamera_t *camera = get_camera(cameraHandle);
+    if (camera == NULL)
+    {
+        return VmbErrorBadHandle;
+    }
+    g_mutex_lock(&camera->lock);
+    camera->is_capturing = false;
+    g_cond_broadcast(&camera->cond);
+    // Like VimbaC, no frame callback runs anymore once this returns
+    while (camera->is_in_callback)
+    {
+        g_cond_wait(&camera->cond, &camera->lock);
+    }
+    g_mutex_unlock(&camera->lock);
+    return VmbErrorSuccess;
+}
+
+VmbError_t VMB_CALL VmbCaptureFrameQueue(const VmbHandle_t cameraHandle,
+                                         const VmbFrame_t *pFrame,
+                                         VmbFrameCallback callback)
+{
+    MockCamera_t *camera = get_camera(cameraHandle);
+    if (camera == NULL)
+    {
+        return VmbErrorBadHandle;
+    }
+    if (pFrame == NULL)
+    {
+        return VmbErrorBadParameter;
+    }
+    g_mutex_lock(&camera->lock);
+    VmbError_t result = VmbErrorSuccess;
+    guint index;
+    if (!g_ptr_array_find(camera->announced_frames, pFrame, &index))
+    {
+        result = VmbErrorInvalidValue;
+    }
+    else if (!camera->is_capturing)
+    {
+        result = VmbErrorInvalidCall;
+    }
+    else if (g_queue_find_custom(&camera->queued_frames, pFrame, (GCompareFunc)is_queued_frame) != NULL)
+    {
+        result = VmbErrorInvalidCall;
+    }
+    else
+    {
+        QueuedFrame_t *queued_frame = g_new(QueuedFrame_t, 1);
+        queued_frame->frame = (VmbFrame_t *)pFrame;
+        queued_frame->callback = callback;
+        g_queue_push_tail(&camera->queued_frames, queued_frame);
+    }
+    g_mutex_unlock(&camera->lock);
+    return result;
+}
+
+VmbError_t VMB_CALL VmbCaptureQueueFlush(const VmbHandle_t cameraHandle)
+{
+    MockCamera_t *camera = get_camera(cameraHandle);
+    if (camera == NULL)
+    {
+        return VmbErrorBadHandle;
+    }
+    g_mutex_lock(&camera->lock);
+    g_queue_clear_full(&camera->queued_frames, g_free);
+    g_queue_init(&camera->queued_frames);
+    g_mutex_unlock(&camera->lock);
+    return VmbErrorSuccess;
+}
+
+VmbError_t VMB_CALL VmbAncillaryDataOpen(VmbFrame_t *pFrame, VmbHandle_t *pAncillaryDataHandle)
+{
+    (void)pFrame;
+    (void)pAncillaryDataHandle;
+    // Mock frames carry no chunk data
+    return VmbErrorNotSupported;
+}
+
+VmbError_t VMB_CALL VmbAncillaryDataClose(VmbHandle_t ancillaryDataHandle)
+{
+    (void)ancillaryDataHandle;
+    return VmbErrorBadHandle;
+}
@@ -0,0 +1,710 @@
+#include "debayer.h"
+#include "pixelunpack.h"
+
+#include <stdbool.h>
+#include <string.h>
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#define DEBAYER_X86
+#include <immintrin.h>
+#endif
+
+#if defined(__ARM_NEON) || defined(__aarch64__) || defined(_M_ARM64)
+#define DEBAYER_NEON
+#include <arm_neon.h>
+#endif
+
+// See pixelunpack.c. The kernels are selected with the instruction set chosen for unpacking
+#if defined(__GNUC__)
+#define TARGET_SSE2 __attribute__((target("sse2")))
+#define TARGET_AVX2 __attribute__((target("avx2")))
+#else
+#define TARGET_SSE2
+#define TARGET_AVX2
+#endif
+
+// Bands are not made smaller than this, so that the overhead of handing them to a worker stays small
+#define MIN_BAND_ROWS 32
+
+// Weights (summing up to 256) of the red, green and blue value in the GRAY8 output. ITU-R BT.601 luma
+#define LUMA_RED 77
+#define LUMA_GREEN 150
+#define LUMA_BLUE 29
+
+// One row of the Bayer image with the rows above and below it, demosaiced into one plane per colour
+typedef struct
+{
+    const guint8 *up;
+    const guint8 *center;
+    const guint8 *down;
+    guint width;
+    // Set if green pixels are in the even columns of the row. The other colour of the row is in the odd columns
+    bool green_first;
+    bool edge_aware;
+    // Plane of the colour (red or blue) that the row holds besides green
+    guint8 *own;
+    guint8 *green;
+    // Plane of the colour (blue or red) that is only held by the rows above and below
+    guint8 *other;
+} DebayerRow_t;
+
+typedef struct
+{
+    BayerPattern_t pattern;
+    DebayerMethod_t method;
+    DebayerOutput_t output;
+    const guint8 *src;
+    guint width;
+    guint height;
+    guint8 *dst;
+    gsize dst_stride;
+} DebayerImage_t;
+
+typedef struct
+{
+    const DebayerImage_t *image;
+    guint first_row;
+    guint row_count;
+} DebayerBand_t;
+
+typedef void (*DemosaicRowKernel_t)(const DebayerRow_t *row);
+typedef void (*PackKernel_t)(const guint8 *red, const guint8 *green, const guint8 *blue, guint8 *dst, gsize count);
+
+static inline guint8 average(guint a, guint b)
+{
+    return (guint8)((a + b + 1) >> 1);
+}
+
+static inline guint absolute_difference(guint a, guint b)
+{
+    return a > b ? a - b : b - a;
+}
+
+// All kernels average neighbouring pixels pairwise with rounding up like the SIMD average instructions, so that their
+// results are identical
+static void demosaic_pixels_scalar(const DebayerRow_t *row, guint x, guint end)
+{
+    for (; x < end; x++)
+    {
+        // Neighbours beyond the image border are mirrored, which keeps the colour of the pattern
+        guint left = x > 0 ? x - 1 : 1;
+        guint right = x + 1 < row->width ? x + 1 : row->width - 2;
+        guint8 horizontal = average(row->center[left], row->center[right]);
+        guint8 vertical = average(row->up[x], row->down[x]);
+        if (((x & 1) == 0) == row->green_first)
+        {
+            row->own[x] = horizontal;
+            row->green[x] = row->center[x];
+            row->other[x] = vertical;
+        }
+        else
+        {
+            guint8 green = average(horizontal, vertical);
+            if (row->edge_aware)
+            {
+                guint gradient_horizontal = absolute_difference(row->center[left], row->center[right]);
+                guint gradient_vertical = absolute_difference(row->up[x], row->down[x]);
+                if (gradient_horizontal < gradient_vertical)
+                {
+                    green = horizontal;
+                }
+                else if (gradient_vertical < gradient_horizontal)
+                {
+                    green = vertical;
+                }
+            }
+            row->own[x] = row->center[x];
+            row->green[x] = green;
+            row->other[x] = average(average(row->up[left], row->up[right]), average(row->down[left], row->down[right]));
+        }
+    }
+}
+
+static void demosaic_row_scalar(const DebayerRow_t *row)
+{
+    demosaic_pixels_scalar(row, 0, row->width);
+}
+
+static void pack_rgb_scalar(const guint8 *red, const guint8 *green, const guint8 *blue, guint8 *dst, gsize count)
+{
+    for (gsize i = 0; i < count; i++)
+    {
+        dst[3 * i] = red[i];
+        dst[3 * i + 1] = green[i];
+        dst[3 * i + 2] = blue[i];
+    }
+}
+
+static void pack_bgrx_scalar(const guint8 *red, const guint8 *green, const guint8 *blue, guint8 *dst, gsize count)
+{
+    for (gsize i = 0; i < count; i++)
+    {
+        dst[4 * i] = blue[i];
+        dst[4 * i + 1] = green[i];
+        dst[4 * i + 2] = red[i];
+        dst[4 * i + 3] = 0xFF;
+    }
+}
+
+static void pack_gray_scalar(const guint8 *red, const guint8 *green, const guint8 *blue, guint8 *dst, gsize count)
+{
+    for (gsize i = 0; i < count; i++)
+    {
+        dst[i] = (guint8)((LUMA_RED * red[i] + LUMA_GREEN * green[i] + LUMA_BLUE * blue[i] + 128) >> 8);
+    }
+}
+
+#ifdef DEBAYER_X86
+TARGET_SSE2 static inline __m128i blend_sse2(__m128i mask, __m128i a, __m128i b)
+{
+    return _mm_or_si128(_mm_and_si128(mask, a), _mm_andnot_si128(mask, b));
+}
+
+TARGET_SSE2 static void demosaic_row_sse2(const DebayerRow_t *row)
+{
+    // Vectors start at even columns, so the green pixels are in the same byte lanes in every vector
+    __m128i even_columns = _mm_set1_epi16(0x00FF);
+    __m128i green_sites = row->green_first ? even_columns : _mm_xor_si128(even_columns, _mm_set1_epi8(-1));
+
+    // The first pixel needs a mirrored neighbour. The loads of the last vector must not reach past the row end
+    demosaic_pixels_scalar(row, 0, MIN(2, row->width));
+    guint x = 2;
+    for (; x + 17 <= row->width; x += 16)
+    {
+        __m128i center = _mm_loadu_si128((const __m128i *)(row->center + x));
+        __m128i left = _mm_loadu_si128((const __m128i *)(row->center + x - 1));
+        __m128i right = _mm_loadu_si128((const __m128i *)(row->center + x + 1));
+        __m128i up = _mm_loadu_si128((const __m128i *)(row->up + x));
+        __m128i down = _mm_loadu_si128((const __m128i *)(row->down + x));
+        __m128i horizontal = _mm_avg_epu8(left, right);
+        __m128i vertical = _mm_avg_epu8(up, down);
+        __m128i green = _mm_avg_epu8(horizontal, vertical);
+        if (row->edge_aware)
+        {
+            __m128i gradient_horizontal = _mm_or_si128(_mm_subs_epu8(left, right), _mm_subs_epu8(right, left));
+            __m128i gradient_vertical = _mm_or_si128(_mm_subs_epu8(up, down), _mm_subs_epu8(down, up));
+            __m128i gradient_max = _mm_max_epu8(gradient_horizontal, gradient_vertical);
+            green = blend_sse2(_mm_cmpeq_epi8(gradient_max, gradient_horizontal), green, horizontal);
+            green = blend_sse2(_mm_cmpeq_epi8(gradient_max, gradient_vertical), green, vertical);
+        }
+        __m128i diagonal = _mm_avg_epu8(_mm_avg_epu8(_mm_loadu_si128((const __m128i *)(row->up + x - 1)),
+                                                     _mm_loadu_si128((const __m128i *)(row->up + x + 1))),
+                                        _mm_avg_epu8(_mm_loadu_si128((const __m128i *)(row->down + x - 1)),
+                                                     _mm_loadu_si128((const __m128i *)(row->down + x + 1))));
+        _mm_storeu_si128((__m128i *)(row->own + x), blend_sse2(green_sites, horizontal, center));
+        _mm_storeu_si128((__m128i *)(row->green + x), blend_sse2(green_sites, center, green));
+        _mm_storeu_si128((__m128i *)(row->other + x), blend_sse2(green_sites, vertical, diagonal));
+    }
+    demosaic_pixels_scalar(row, x, row->width);
+}
+
+TARGET_SSE2 static void pack_bgrx_sse2(const guint8 *red,
+                                       const guint8 *green,
+                                       const guint8 *blue,
+                                       guint8 *dst,
+                                       gsize count)
+{
+    __m128i alpha = _mm_set1_epi8(-1);
+    gsize i = 0;
+    for (; i + 16 <= count; i += 16)
+    {
+        __m128i r = _mm_loadu_si128((const __m128i *)(red + i));
+        __m128i g = _mm_loadu_si128((const __m128i *)(green + i));
+        __m128i b = _mm_loadu_si128((const __m128i *)(blue + i));
+        __m128i bg_low = _mm_unpacklo_epi8(b, g);
+        __m128i bg_high = _mm_unpackhi_epi8(b, g);
+        __m128i rx_low = _mm_unpacklo_epi8(r, alpha);
+        __m128i rx_high = _mm_unpackhi_epi8(r, alpha);
+        _mm_storeu_si128((__m128i *)(dst + 4 * i), _mm_unpacklo_epi16(bg_low, rx_low));
+        _mm_storeu_si128((__m128i *)(dst + 4 * i + 16), _mm_unpackhi_epi16(bg_low, rx_low));
+        _mm_storeu_si128((__m128i *)(dst + 4 * i + 32), _mm_unpacklo_epi16(bg_high, rx_high));
+        _mm_storeu_si128((__m128i *)(dst + 4 * i + 48), _mm_unpackhi_epi16(bg_high, rx_high));
+    }
+    pack_bgrx_scalar(red + i, green + i, blue + i, dst + 4 * i, count - i);
+}
+
+TARGET_SSE2 static __m128i luma_sse2(__m128i red, __m128i green, __m128i blue)
+{
+    __m128i luma = _mm_add_epi16(_mm_mullo_epi16(red, _mm_set1_epi16(LUMA_RED)),
+                                 _mm_mullo_epi16(green, _mm_set1_epi16(LUMA_GREEN)));
+    luma = _mm_add_epi16(luma, _mm_mullo_epi16(blue, _mm_set1_epi16(LUMA_BLUE)));
+    return _mm_srli_epi16(_mm_add_epi16(luma, _mm_set1_epi16(128)), 8);
+}
+
+TARGET_SSE2 static void pack_gray_sse2(const guint8 *red,
+                                       const guint8 *green,
+                                       const guint8 *blue,
+                                       guint8 *dst,
+                                       gsize count)
+{
+    __m128i zero = _mm_setzero_si128();
+    gsize i = 0;
+    for (; i + 16 <= count; i += 16)
+    {
+        __m128i r = _mm_loadu_si128((const __m128i *)(red + i));
+        __m128i g = _mm_loadu_si128((const __m128i *)(green + i));
+        __m128i b = _mm_loadu_si128((const __m128i *)(blue + i));
+        __m128i low = luma_sse2(_mm_unpacklo_epi8(r, zero), _mm_unpacklo_epi8(g, zero), _mm_unpacklo_epi8(b, zero));
+        __m128i high = luma_sse2(_mm_unpackhi_epi8(r, zero), _mm_unpackhi_epi8(g, zero), _mm_unpackhi_epi8(b, zero));
+        _mm_storeu_si128((__m128i *)(dst + i), _mm_packus_epi16(low, high));
+    }
+    pack_gray_scalar(red + i, green + i, blue + i, dst + i, count - i);
+}
+
+TARGET_AVX2 static inline __m256i blend_avx2(__m256i mask, __m256i a, __m256i b)
+{
+    return _mm256_or_si256(_mm256_and_si256(mask, a), _mm256_andnot_si256(mask, b));
+}
+
+TARGET_AVX2 static void demosaic_row_avx2(const DebayerRow_t *row)
+{
+    __m256i even_columns = _mm256_set1_epi16(0x00FF);
+    __m256i green_sites = row->green_first ? even_columns : _mm256_xor_si256(even_columns, _mm256_set1_epi8(-1));
+
+    demosaic_pixels_scalar(row, 0, MIN(2, row->width));
+    guint x = 2;
+    for (; x + 33 <= row->width; x += 32)
+    {
+        __m256i center = _mm256_loadu_si256((const __m256i *)(row->center + x));
+        __m256i left = _mm256_loadu_si256((const __m256i *)(row->center + x - 1));
+        __m256i right = _mm256_loadu_si256((const __m256i *)(row->center + x + 1));
+        __m256i up = _mm256_loadu_si256((const __m256i *)(row->up + x));
+        __m256i down = _mm256_loadu_si256((const __m256i *)(row->down + x));
+        __m256i horizontal = _mm256_avg_epu8(left, right);
+        __m256i vertical = _mm256_avg_epu8(up, down);
+        __m256i green = _mm256_avg_epu8(horizontal, vertical);
+        if (row->edge_aware)
+        {
+            __m256i gradient_horizontal = _mm256_or_si256(_mm256_subs_epu8(left, right), _mm256_subs_epu8(right, left));
+            __m256i gradient_vertical = _mm256_or_si256(_mm256_subs_epu8(up, down), _mm256_subs_epu8(down, up));
+            __m256i gradient_max = _mm256_max_epu8(gradient_horizontal, gradient_vertical);
+            green = blend_avx2(_mm256_cmpeq_epi8(gradient_max, gradient_horizontal), green, horizontal);
+            green = blend_avx2(_mm256_cmpeq_epi8(gradient_max, gradient_vertical), green, vertical);
+        }
+        __m256i diagonal = _mm256_avg_epu8(_mm256_avg_epu8(_mm256_loadu_si256((const __m256i *)(row->up + x - 1)),
+                                                           _mm256_loadu_si256((const __m256i *)(row->up + x + 1))),
+                                           _mm256_avg_epu8(_mm256_loadu_si256((const __m256i *)(row->down + x - 1)),
+                                                           _mm256_loadu_si256((const __m256i *)(row->down + x + 1))));
+        _mm256_storeu_si256((__m256i *)(row->own + x), blend_avx2(green_sites, horizontal, center));
+        _mm256_storeu_si256((__m256i *)(row->green + x), blend_avx2(green_sites, center, green));
+        _mm256_storeu_si256((__m256i *)(row->other + x), blend_avx2(green_sites, vertical, diagonal));
+    }
+    demosaic_pixels_scalar(row, x, row->width);
+}
+
+TARGET_AVX2 static void pack_rgb_avx2(const guint8 *red,
+                                      const guint8 *green,
+                                      const guint8 *blue,
+                                      guint8 *dst,
+                                      gsize count)
+{
+    // Byte shuffles spreading 16 pixels of each plane over 3 output vectors. Bytes not taken from a plane are cleared
+    __m128i shuffles[3][3];
+    for (guint v = 0; v < 3; v++)
+    {
+        for (guint plane = 0; plane < 3; plane++)
+        {
+            guint8 indices[16];
+            for (guint j = 0; j < 16; j++)
+            {
+                guint byte = v * 16 + j;
+                indices[j] = byte % 3 == plane ? (guint8)(byte / 3) : 0x80;
+            }
+            shuffles[v][plane] = _mm_loadu_si128((const __m128i *)indices);
+        }
+    }
+
+    gsize i = 0;
+    for (; i + 16 <= count; i += 16)
+    {
+        __m128i r = _mm_loadu_si128((const __m128i *)(red + i));
+        __m128i g = _mm_loadu_si128((const __m128i *)(green + i));
+        __m128i b = _mm_loadu_si128((const __m128i *)(blue + i));
+        for (guint v = 0; v < 3; v++)
+        {
+            __m128i rgb = _mm_or_si128(_mm_or_si128(_mm_shuffle_epi8(r, shuffles[v][0]),
+                                                    _mm_shuffle_epi8(g, shuffles[v][1])),
+                                       _mm_shuffle_epi8(b, shuffles[v][2]));
+            _mm_storeu_si128((__m128i *)(dst + 3 * i + 16 * v), rgb);
+        }
+    }
+    pack_rgb_scalar(red + i, green + i, blue + i, dst + 3 * i, count - i);
+}
+
+TARGET_AVX2 static void pack_bgrx_avx2(const guint8 *red,
+                                       const guint8 *green,
+                                       const guint8 *blue,
+                                       guint8 *dst,
+                                       gsize count)
+{
+    __m256i alpha = _mm256_set1_epi8(-1);
+    gsize i = 0;
+    for (; i + 32 <= count; i += 32)
+    {
+        __m256i r = _mm256_loadu_si256((const __m256i *)(red + i));
+        __m256i g = _mm256_loadu_si256((const __m256i *)(green + i));
+        __m256i b = _mm256_loadu_si256((const __m256i *)(blue + i));
+        __m256i bg_low = _mm256_unpacklo_epi8(b, g);
+        __m256i bg_high = _mm256_unpackhi_epi8(b, g);
+        __m256i rx_low = _mm256_unpacklo_epi8(r, alpha);
+        __m256i rx_high = _mm256_unpackhi_epi8(r, alpha);
+        // The unpack instructions work within 128 bit lanes. Pixels 0-3 and 16-19 are in the first vector, 4-7 and
+        // 20-23 in the second and so on
+        __m256i pixels0 = _mm256_unpacklo_epi16(bg_low, rx_low);
+        __m256i pixels1 = _mm256_unpackhi_epi16(bg_low, rx_low);
+        __m256i pixels2 = _mm256_unpacklo_epi16(bg_high, rx_high);
+        __m256i pixels3 = _mm256_unpackhi_epi16(bg_high, rx_high);
+        _mm256_storeu_si256((__m256i *)(dst + 4 * i), _mm256_permute2x128_si256(pixels0, pixels1, 0x20));
+        _mm256_storeu_si256((__m256i *)(dst + 4 * i + 32), _mm256_permute2x128_si256(pixels2, pixels3, 0x20));
+        _mm256_storeu_si256((__m256i *)(dst + 4 * i + 64), _mm256_permute2x128_si256(pixels0, pixels1, 0x31));
+        _mm256_storeu_si256((__m256i *)(dst + 4 * i + 96), _mm256_permute2x128_si256(pixels2, pixels3, 0x31));
+    }
+    pack_bgrx_scalar(red + i, green + i, blue + i, dst + 4 * i, count - i);
+}
+
+TARGET_AVX2 static __m256i luma_avx2(const guint8 *red, const guint8 *green, const guint8 *blue)
+{
+    __m256i r = _mm256_cvtepu8_epi16(_mm_loadu_si128((const __m128i *)red));
+    __m256i g = _mm256_cvtepu8_epi16(_mm_loadu_si128((const __m128i *)green));
+    __m256i b = _mm256_cvtepu8_epi16(_mm_loadu_si128((const __m128i *)blue));
+    __m256i luma = _mm256_add_epi16(_mm256_mullo_epi16(r, _mm256_set1_epi16(LUMA_RED)),
+                                    _mm256_mullo_epi16(g, _mm256_set1_epi16(LUMA_GREEN)));
+    luma = _mm256_add_epi16(luma, _mm256_mullo_epi16(b, _mm256_set1_epi16(LUMA_BLUE)));
+    return _mm256_srli_epi16(_mm256_add_epi16(luma, _mm256_set1_epi16(128)), 8);
+}
+
+TARGET_AVX2 static void pack_gray_avx2(const guint8 *red,
+                                       const guint8 *green,
+                                       const guint8 *blue,
+                                       guint8 *dst,
+                                       gsize count)
+{
+    gsize i = 0;
+    for (; i + 32 <= count; i += 32)
+    {
+        __m256i low = luma_avx2(red + i, green + i, blue + i);
+        __m256i high = luma_avx2(red + i + 16, green + i + 16, blue + i + 16);
+        // Packing works within 128 bit lanes, which leaves the 64 bit quarters in the order 0, 2, 1, 3
+        __m256i gray = _mm256_permute4x64_epi64(_mm256_packus_epi16(low, high), 0xD8);
+        _mm256_storeu_si256((__m256i *)(dst + i), gray);
+    }
+    pack_gray_scalar(red + i, green + i, blue + i, dst + i, count - i);
+}
+#endif
+
+#ifdef DEBAYER_NEON
+static void demosaic_row_neon(const DebayerRow_t *row)
+{
+    uint8x16_t even_columns = vreinterpretq_u8_u16(vdupq_n_u16(0x00FF));
+    uint8x16_t green_sites = row->green_first ? even_columns : vmvnq_u8(even_columns);
+
+    demosaic_pixels_scalar(row, 0, MIN(2, row->width));
+    guint x = 2;
+    for (; x + 17 <= row->width; x += 16)
+    {
+        uint8x16_t center = vld1q_u8(row->center + x);
+        uint8x16_t left = vld1q_u8(row->center + x - 1);
+        uint8x16_t right = vld1q_u8(row->center + x + 1);
+        uint8x16_t up = vld1q_u8(row->up + x);
+        uint8x16_t down = vld1q_u8(row->down + x);
+        uint8x16_t horizontal = vrhaddq_u8(left, right);
+        uint8x16_t vertical = vrhaddq_u8(up, down);
+        uint8x16_t green = vrhaddq_u8(horizontal, vertical);
+        if (row->edge_aware)
+        {
+            uint8x16_t gradient_horizontal = vabdq_u8(left, right);
+            uint8x16_t gradient_vertical = vabdq_u8(up, down);
+            green = vbslq_u8(vcltq_u8(gradient_horizontal, gradient_vertical), horizontal, green);
+            green = vbslq_u8(vcltq_u8(gradient_vertical, gradient_horizontal), vertical, green);
+        }
+        uint8x16_t diagonal = vrhaddq_u8(vrhaddq_u8(vld1q_u8(row->up + x - 1), vld1q_u8(row->up + x + 1)),
+                                         vrhaddq_u8(vld1q_u8(row->down + x - 1), vld1q_u8(row->down + x + 1)));
+        vst1q_u8(row->own + x, vbslq_u8(green_sites, horizontal, center));
+        vst1q_u8(row->green + x, vbslq_u8(green_sites, center, green));
+        vst1q_u8(row->other + x, vbslq_u8(green_sites, vertical, diagonal));
+    }
+    demosaic_pixels_scalar(row, x, row->width);
+}
+
+static void pack_rgb_neon(const guint8 *red, const guint8 *green, const guint8 *blue, guint8 *dst, gsize count)
+{
+    gsize i = 0;
+    for (; i + 16 <= count; i += 16)
+    {
+        uint8x16x3_t rgb = {{vld1q_u8(red + i), vld1q_u8(green + i), vld1q_u8(blue + i)}};
+        vst3q_u8(dst + 3 * i, rgb);
+    }
+    pack_rgb_scalar(red + i, green + i, blue + i, dst + 3 * i, count - i);
+}
+
+static void pack_bgrx_neon(const guint8 *red, const guint8 *green, const guint8 *blue, guint8 *dst, gsize count)
+{
+    gsize i = 0;
+    for (; i + 16 <= count; i += 16)
+    {
+        uint8x16x4_t bgrx = {{vld1q_u8(blue + i), vld1q_u8(green + i), vld1q_u8(red + i), vdupq_n_u8(0xFF)}};
+        vst4q_u8(dst + 4 * i, bgrx);
+    }
+    pack_bgrx_scalar(red + i, green + i, blue + i, dst + 4 * i, count - i);
+}
+
+static uint8x8_t luma_neon(uint8x8_t red, uint8x8_t green, uint8x8_t blue)
+{
+    uint16x8_t luma = vmull_u8(red, vdup_n_u8(LUMA_RED));
+    luma = vmlal_u8(luma, green, vdup_n_u8(LUMA_GREEN));
+    luma = vmlal_u8(luma, blue, vdup_n_u8(LUMA_BLUE));
+    return vrshrn_n_u16(luma, 8);
+}
+
+static void pack_gray_neon(const guint8 *red, const guint8 *green, const guint8 *blue, guint8 *dst, gsize count)
+{
+    gsize i = 0;
+    for (; i + 16 <= count; i += 16)
+    {
+        uint8x16_t r = vld1q_u8(red + i);
+        uint8x16_t g = vld1q_u8(green + i);
+        uint8x16_t b = vld1q_u8(blue + i);
+        vst1q_u8(dst + i,
+                 vcombine_u8(luma_neon(vget_low_u8(r), vget_low_u8(g), vget_low_u8(b)),
+                             luma_neon(vget_high_u8(r), vget_high_u8(g), vget_high_u8(b))));
+    }
+    pack_gray_scalar(red + i, green + i, blue + i, dst + i, count - i);
+}
+#endif
+
+static DemosaicRowKernel_t get_demosaic_row_kernel(PixelUnpackIsa_t isa)
+{
+    switch (isa)
+    {
+#ifdef DEBAYER_X86
+    case PIXEL_UNPACK_ISA_SSE2:
+        return demosaic_row_sse2;
+    case PIXEL_UNPACK_ISA_AVX2:
+        return demosaic_row_avx2;
+#endif
+#ifdef DEBAYER_NEON
+    case PIXEL_UNPACK_ISA_NEON:
+        return demosaic_row_neon;
+#endif
+    default:
+        return demosaic_row_scalar;
+    }
+}
+
+static PackKernel_t get_pack_kernel(PixelUnpackIsa_t isa, DebayerOutput_t output)
+{
+    switch (isa)
+    {
+#ifdef DEBAYER_X86
+    case PIXEL_UNPACK_ISA_SSE2:
+        // Spreading the planes over 3 byte pixels needs byte shuffles, which SSE2 lacks
+        return output == DEBAYER_OUTPUT_RGB ? pack_rgb_scalar
+               : output == DEBAYER_OUTPUT_BGRX ? pack_bgrx_sse2
+                                               : pack_gray_sse2;
+    case PIXEL_UNPACK_ISA_AVX2:
+        return output == DEBAYER_OUTPUT_RGB ? pack_rgb_avx2
+               : output == DEBAYER_OUTPUT_BGRX ? pack_bgrx_avx2
+                                               : pack_gray_avx2;
+#endif
+#ifdef DEBAYER_NEON
+    case PIXEL_UNPACK_ISA_NEON:
+        return output == DEBAYER_OUTPUT_RGB ? pack_rgb_neon
+               : output == DEBAYER_OUTPUT_BGRX ? pack_bgrx_neon
+                                               : pack_gray_neon;
+#endif
+    default:
+        return output == DEBAYER_OUTPUT_RGB ? pack_rgb_scalar
+               : output == DEBAYER_OUTPUT_BGRX ? pack_bgrx_scalar
+                                               : pack_gray_scalar;
+    }
+}
+
+// Colours of the top left 2x2 pixels in row major order
+static const char *get_pattern_colours(BayerPattern_t pattern)
+{
+    switch (pattern)
+    {
+    case BAYER_PATTERN_GRBG:
+        return "GRBG";
+    case BAYER_PATTERN_GBRG:
+        return "GBRG";
+    case BAYER_PATTERN_BGGR:
+        return "BGGR";
+    default:
+        return "RGGB";
+    }
+}
+
+static void demosaic_band(const DebayerImage_t *image, guint first_row, guint row_count)
+{
+    PixelUnpackIsa_t isa = pixel_unpack_get_isa();
+    DemosaicRowKernel_t demosaic_row = get_demosaic_row_kernel(isa);
+    PackKernel_t pack = get_pack_kernel(isa, image->output);
+    const char *colours = get_pattern_colours(image->pattern);
+    gsize dst_row_size = (gsize)image->width * debayer_output_bytes_per_pixel(image->output);
+
+    // The planes only hold a single row, which keeps them in the cache until they are packed into the output
+    guint8 *planes = g_malloc((gsize)image->width * 3);
+    guint8 *red = planes;
+    guint8 *green = planes + image->width;
+    guint8 *blue = planes + 2 * (gsize)image->width;
+
+    for (guint y = first_row; y < first_row + row_count; y++)
+    {
+        // Rows beyond the image border are mirrored, which keeps the colour of the pattern
+        guint up = y > 0 ? y - 1 : 1;
+        guint down = y + 1 < image->height ? y + 1 : image->height - 2;
+        const char *row_colours = colours + 2 * (y & 1);
+        bool green_first = row_colours[0] == 'G';
+        bool own_is_red = row_colours[green_first ? 1 : 0] == 'R';
+
+        DebayerRow_t row = {image->src + (gsize)up * image->width,
+                            image->src + (gsize)y * image->width,
+                            image->src + (gsize)down * image->width,
+                            image->width,
+                            green_first,
+                            image->method == DEBAYER_METHOD_EDGE_AWARE,
+                            own_is_red ? red : blue,
+                            green,
+                            own_is_red ? blue : red};
+        demosaic_row(&row);
+
+        guint8 *dst_row = image->dst + y * image->dst_stride;
+        pack(red, green, blue, dst_row, image->width);
+        memset(dst_row + dst_row_size, 0, image->dst_stride - dst_row_size);
+    }
+    g_free(planes);
+}
+
+static void process_band(gpointer data, gpointer user_data)
+{
+    DebayerBand_t *band = data;
+    Debayer_t *debayer = user_data;
+    demosaic_band(band->image, band->first_row, band->row_count);
+
+    g_mutex_lock(&debayer->lock);
+    debayer->pending_bands--;
+    if (debayer->pending_bands == 0)
+    {
+        g_cond_signal(&debayer->cond);
+    }
+    g_mutex_unlock(&debayer->lock);
+}
+
+/**
+ * @brief Creates the state for demosaicing images in parallel
+ *
+ * @param num_threads Number of threads processing an image, including the calling thread. 0 uses one thread per CPU
+ * core
+ * @return Debayer_t* The new state. Free with debayer_free
+ */
+Debayer_t *debayer_new(guint num_threads)
+{
+    Debayer_t *debayer = g_new0(Debayer_t, 1);
+    debayer->num_threads = num_threads > 0 ? num_threads : (guint)g_get_num_processors();
+    g_mutex_init(&debayer->lock);
+    g_cond_init(&debayer->cond);
+    if (debayer->num_threads > 1)
+    {
+        // Shared pools only start their threads once work is pushed, so creating the pool can not fail
+        debayer->pool = g_thread_pool_new(process_band, debayer, (gint)debayer->num_threads - 1, FALSE, NULL);
+    }
+    return debayer;
+}
+
+void debayer_free(Debayer_t *debayer)
+{
+    if (debayer->pool != NULL)
+    {
+        g_thread_pool_free(debayer->pool, FALSE, TRUE);
+    }
+    g_cond_clear(&debayer->cond);
+    g_mutex_clear(&debayer->lock);
+    g_free(debayer);
+}
+
+guint debayer_output_bytes_per_pixel(DebayerOutput_t output)
+{
+    switch (output)
+    {
+    case DEBAYER_OUTPUT_RGB:
+        return 3;
+    case DEBAYER_OUTPUT_BGRX:
+        return 4;
+    default:
+        return 1;
+    }
+}
+
+/**
+ * @brief Demosaics an 8 bit Bayer image and writes the result directly into the output image. Must not be called
+ * concurrently with the same debayer state
+ *
+ * @param debayer Distributes the rows over multiple threads. May be NULL to only use the calling thread
+ * @param pattern Colour filter arrangement of the top left pixels of src
+ * @param method Interpolation of the missing colours
+ * @param output Pixel layout of dst
+ * @param src Bayer image with rows of width bytes
+ * @param src_size Size of src in bytes. Rows missing in incomplete images are black in dst
+ * @param width Width of the image in pixels
+ * @param height Height of the image in pixels
+ * @param dst Receives the demosaiced image. Padding at the end of the rows is cleared
+ * @param dst_stride Distance in bytes between the starts of two rows in dst
+ */
+void debayer_image(Debayer_t *debayer,
+                   BayerPattern_t pattern,
+                   DebayerMethod_t method,
+                   DebayerOutput_t output,
+                   const guint8 *src,
+                   gsize src_size,
+                   guint width,
+                   guint height,
+                   guint8 *dst,
+                   gsize dst_stride)
+{
+    guint rows = width > 0 ? (guint)MIN(height, src_size / width) : 0;
+    // Images without a complete 2x2 block have no pixels of some colours
+    if (width < 2 || rows < 2)
+    {
+        rows = 0;
+    }
+    memset(dst + (gsize)rows * dst_stride, 0, (gsize)(height - rows) * dst_stride);
+    if (rows == 0)
+    {
+        return;
+    }
+
+    DebayerImage_t image = {pattern, method, output, src, width, rows, dst, dst_stride};
+    guint num_bands = debayer != NULL && debayer->pool != NULL ? debayer->num_threads : 1;
+    num_bands = CLAMP(rows / MIN_BAND_ROWS, 1, num_bands);
+
+    // The bands are handed to the workers while the calling thread processes the last one, which also takes the
+    // remaining rows
+    guint band_rows = rows / num_bands;
+    DebayerBand_t *bands = g_newa(DebayerBand_t, num_bands);
+    for (guint i = 0; i < num_bands; i++)
+    {
+        bands[i].image = &image;
+        bands[i].first_row = i * band_rows;
+        bands[i].row_count = i + 1 < num_bands ? band_rows : rows - i * band_rows;
+    }
+
+    if (num_bands > 1)
+    {
+        debayer->pending_bands = (gint)num_bands - 1;
+        for (guint i = 0; i + 1 < num_bands; i++)
+        {
+            g_thread_pool_push(debayer->pool, &bands[i], NULL);
+        }
+    }
+    demosaic_band(&image, bands[num_bands - 1].first_row, bands[num_bands - 1].row_count);
+    if (num_bands > 1)
+    {
+        g_mutex_lock(&debayer->lock);
+        while (debayer->pending_bands > 0)
+        {
+            g_cond_wait(&debayer->cond, &debayer->lock);
+        }
+        g_mutex_unlock(&debayer->lock);
+    }
+}
@@ -0,0 +1,64 @@
+#ifndef DEBAYER_H_
+#define DEBAYER_H_
+
+#include <glib.h>
+
+// Colour filter arrangement of the top left 2x2 pixels of a Bayer image
+typedef enum
+{
+    // The image is not demosaiced
+    BAYER_PATTERN_NONE,
+    BAYER_PATTERN_RGGB,
+    BAYER_PATTERN_GRBG,
+    BAYER_PATTERN_GBRG,
+    BAYER_PATTERN_BGGR
+} BayerPattern_t;
+
+// Pixel layouts the demosaiced image can be written in
+typedef enum
+{
+    DEBAYER_OUTPUT_RGB,
+    DEBAYER_OUTPUT_BGRX,
+    DEBAYER_OUTPUT_GRAY8
+} DebayerOutput_t;
+
+typedef enum
+{
+    // Missing colours are the average of the nearest pixels of that colour
+    DEBAYER_METHOD_BILINEAR,
+    // Missing green values are interpolated along the direction with the smaller gradient, which avoids the zipper
+    // artefacts bilinear interpolation produces at edges
+    DEBAYER_METHOD_EDGE_AWARE
+} DebayerMethod_t;
+
+// Demosaics images in horizontal bands. The calling thread processes one band while the others are processed by a pool
+// of worker threads
+typedef struct
+{
+    // NULL if the image is only processed by the calling thread
+    GThreadPool *pool;
+    guint num_threads;
+
+    // Number of bands the workers have not finished yet
+    gint pending_bands;
+    GMutex lock;
+    GCond cond;
+} Debayer_t;
+
+Debayer_t *debayer_new(guint num_threads);
+void debayer_free(Debayer_t *debayer);
+
+guint debayer_output_bytes_per_pixel(DebayerOutput_t output);
+
+void debayer_image(Debayer_t *debayer,
+                   BayerPattern_t pattern,
+                   DebayerMethod_t method,
+                   DebayerOutput_t output,
+                   const guint8 *src,
+                   gsize src_size,
+                   guint width,
+                   guint height,
+                   guint8 *dst,
+                   gsize dst_stride);
+
+#endif // DEBAYER_H_
@@ -0,0 +1,180 @@
+#include "framequeue.h"
+
+static guint round_up_to_power_of_two(guint value)
+{
+    guint result = 1;
+    while (result < value)
+    {
+        result <<= 1;
+    }
+    return result;
+}
+
+/**
+ * @brief Creates a new empty queue
+ *
+ * @param capacity Minimum number of elements the queue must be able to hold. Rounded up to the next power of two
+ * @return FrameQueue_t* The new queue. Free with frame_queue_free
+ */
+FrameQueue_t *frame_queue_new(guint capacity)
+{
+    FrameQueue_t *queue = g_new0(FrameQueue_t, 1);
+    g_mutex_init(&queue->lock);
+    g_cond_init(&queue->cond);
+    frame_queue_reserve(queue, capacity);
+    return queue;
+}
+
+void frame_queue_free(FrameQueue_t *queue)
+{
+    g_free(queue->slots);
+    g_cond_clear(&queue->cond);
+    g_mutex_clear(&queue->lock);
+    g_free(queue);
+}
+
+/**
+ * @brief Makes sure the queue can hold at least capacity elements. Elements that are still queued are dropped if the
+ * queue needs to be enlarged. Neither producer nor consumer may use the queue during this call
+ *
+ * @param queue The queue to enlarge
+ * @param capacity Minimum number of elements the queue must be able to hold. Rounded up to the next power of two
+ */
+void frame_queue_reserve(FrameQueue_t *queue, guint capacity)
+{
+    capacity = round_up_to_power_of_two(MAX(capacity, 1));
+    if (capacity <= queue->capacity)
+    {
+        return;
+    }
+    g_free(queue->slots);
+    queue->slots = g_new0(gpointer, capacity);
+    queue->capacity = capacity;
+    g_atomic_int_set(&queue->head, 0);
+    g_atomic_int_set(&queue->tail, 0);
+}
+
+/**
+ * @brief Appends an element to the queue and wakes up a waiting consumer. Must only be called by the producer
+ *
+ * @param queue The queue to push to
+ * @param element The element to append. Must not be NULL
+ * @return true if the element was appended, false if the queue is full or holds max_length elements
+ */
+bool frame_queue_push(FrameQueue_t *queue, gpointer element)
+{
+    guint tail = (guint)g_atomic_int_get(&queue->tail);
+    guint head = (guint)g_atomic_int_get(&queue->head);
+    guint max_length = (guint)g_atomic_int_get(&queue->max_length);
+    if (tail - head >= queue->capacity || (max_length > 0 && tail - head >= max_length))
+    {
+        return false;
+    }
+    queue->slots[tail & (queue->capacity - 1)] = element;
+    // Publishes the slot content to the consumer
+    g_atomic_int_set(&queue->tail, (gint)(tail + 1));
+
+    // The consumer sets is_waiting before checking for elements a last time. Either it sees the new tail or we see
+    // is_waiting here
+    if (g_atomic_int_get(&queue->is_waiting))
+    {
+        g_mutex_lock(&queue->lock);
+        g_cond_signal(&queue->cond);
+        g_mutex_unlock(&queue->lock);
+    }
+    return true;
+}
+
+/**
+ * @brief Removes the oldest element from the queue without waiting. Must only be called by the consumer
+ *
+ * @param queue The queue to pop from
+ * @return gpointer The oldest element or NULL if the queue is empty
+ */
+gpointer frame_queue_pop(FrameQueue_t *queue)
+{
+    guint head = (guint)g_atomic_int_get(&queue->head);
+    if (head == (guint)g_atomic_int_get(&queue->tail))
+    {
+        return NULL;
+    }
+    gpointer element = queue->slots[head & (queue->capacity - 1)];
+    // Hands the slot back to the producer
+    g_atomic_int_set(&queue->head, (gint)(head + 1));
+    return element;
+}
+
+/**
+ * @brief Removes the oldest element from the queue, waiting for one to be pushed if the queue is empty. Must only be
+ * called by the consumer
+ *
+ * @param queue The queue to pop from
+ * @return gpointer The oldest element or NULL if the queue is set to flushing
+ */
+gpointer frame_queue_pop_wait(FrameQueue_t *queue)
+{
+    gpointer element = NULL;
+    if (!g_atomic_int_get(&queue->is_flushing))
+    {
+        element = frame_queue_pop(queue);
+    }
+    if (element != NULL)
+    {
+        return element;
+    }
+
+    g_mutex_lock(&queue->lock);
+    g_atomic_int_set(&queue->is_waiting, TRUE);
+    while (!g_atomic_int_get(&queue->is_flushing) && (element = frame_queue_pop(queue)) == NULL)
+    {
+        g_cond_wait(&queue->cond, &queue->lock);
+    }
+    g_atomic_int_set(&queue->is_waiting, FALSE);
+    g_mutex_unlock(&queue->lock);
+
+    return element;
+}
+
+/**
+ * @brief Gets the number of elements currently in the queue
+ */
+guint frame_queue_length(FrameQueue_t *queue)
+{
+    return (guint)g_atomic_int_get(&queue->tail) - (guint)g_atomic_int_get(&queue->head);
+}
+
+/**
+ * @brief Removes all elements from the queue. Must only be called by the consumer
+ */
+void frame_queue_clear(FrameQueue_t *queue)
+{
+    while (frame_queue_pop(queue) != NULL)
+    {
+    }
+}
+
+/**
+ * @brief Sets or clears the flushing state. While flushing, frame_queue_pop_wait returns NULL immediately and a
+ * consumer that currently waits is woken up. May be called from any thread
+ *
+ * @param queue The queue whose flushing state should be changed
+ * @param flushing true to abort waiting, false to allow waiting again
+ */
+void frame_queue_set_flushing(FrameQueue_t *queue, bool flushing)
+{
+    g_mutex_lock(&queue->lock);
+    g_atomic_int_set(&queue->is_flushing, flushing);
+    g_cond_broadcast(&queue->cond);
+    g_mutex_unlock(&queue->lock);
+}
+
+/**
+ * @brief Limits the number of elements the queue holds. Elements already queued are kept. May be called from any thread
+ *
+ * @param queue The queue to limit
+ * @param max_length Number of elements after which frame_queue_push fails. 0 to only limit by the capacity
+ */
+void frame_queue_set_max_length(FrameQueue_t *queue, guint max_length)
+{
+    g_atomic_int_set(&queue->max_length, (gint)max_length);
+}
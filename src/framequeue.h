@@ -0,0 +1,51 @@
+#ifndef FRAMEQUEUE_H_
+#define FRAMEQUEUE_H_
+
+#include <glib.h>
+
+#include <stdbool.h>
+
+// Assumed size of a cache line. Producer and consumer indices are kept at least this far apart to avoid false sharing
+#define FRAME_QUEUE_CACHE_LINE_SIZE 64
+
+// Bounded single-producer/single-consumer queue used to hand filled frames from the Vimba frame callback to the
+// streaming thread. Pushing and popping do not take a lock. The mutex and condition are only used if the consumer has
+// to wait for an element, in which case the producer wakes it up
+typedef struct
+{
+    // Index of the next element to pop. Only written by the consumer
+    gint head;
+    char head_padding[FRAME_QUEUE_CACHE_LINE_SIZE - sizeof(gint)];
+    // Index of the next element to push. Only written by the producer
+    gint tail;
+    char tail_padding[FRAME_QUEUE_CACHE_LINE_SIZE - sizeof(gint)];
+
+    // Set while the consumer waits (or is about to wait) for an element
+    gint is_waiting;
+    // Set to abort waiting in frame_queue_pop_wait
+    gint is_flushing;
+    GMutex lock;
+    GCond cond;
+
+    // Number of elements after which pushing fails even though slots are free. 0 if only the capacity limits the queue
+    gint max_length;
+
+    // Number of slots. Always a power of two so indices can be wrapped with a mask
+    guint capacity;
+    gpointer *slots;
+} FrameQueue_t;
+
+FrameQueue_t *frame_queue_new(guint capacity);
+void frame_queue_free(FrameQueue_t *queue);
+void frame_queue_reserve(FrameQueue_t *queue, guint capacity);
+
+bool frame_queue_push(FrameQueue_t *queue, gpointer element);
+gpointer frame_queue_pop(FrameQueue_t *queue);
+gpointer frame_queue_pop_wait(FrameQueue_t *queue);
+guint frame_queue_length(FrameQueue_t *queue);
+void frame_queue_clear(FrameQueue_t *queue);
+
+void frame_queue_set_flushing(FrameQueue_t *queue, bool flushing);
+void frame_queue_set_max_length(FrameQueue_t *queue, guint max_length);
+
+#endif // FRAMEQUEUE_H_
@@ -0,0 +1,54 @@
+#include "framestats.h"
+
+const guint64 frame_stats_histogram_bounds[FRAME_STATS_HISTOGRAM_BUCKET_COUNT - 1] = {
+    G_GUINT64_CONSTANT(100000),
+    G_GUINT64_CONSTANT(250000),
+    G_GUINT64_CONSTANT(500000),
+    G_GUINT64_CONSTANT(1000000),
+    G_GUINT64_CONSTANT(2500000),
+    G_GUINT64_CONSTANT(5000000),
+    G_GUINT64_CONSTANT(10000000),
+    G_GUINT64_CONSTANT(25000000),
+    G_GUINT64_CONSTANT(50000000),
+    G_GUINT64_CONSTANT(100000000),
+    G_GUINT64_CONSTANT(250000000)};
+
+/**
+ * @brief Sets all counters to 0. Must not be called while other threads update the statistics
+ */
+void frame_stats_reset(FrameStats_t *stats)
+{
+    *stats = (FrameStats_t){0};
+}
+
+/**
+ * @brief Atomically adds value to one of the counters of a FrameStats_t
+ */
+void frame_stats_add(gsize *counter, gsize value)
+{
+    g_atomic_pointer_add(counter, (gssize)value);
+}
+
+/**
+ * @brief Atomically reads one of the counters of a FrameStats_t
+ */
+gsize frame_stats_get(gsize *counter)
+{
+    return (gsize)g_atomic_pointer_get(counter);
+}
+
+/**
+ * @brief Counts a frame in the residence histogram
+ *
+ * @param stats Statistics holding the histogram
+ * @param residence_time Time (in ns) the frame spent between the frame callback and being pushed downstream
+ */
+void frame_stats_add_residence_time(FrameStats_t *stats, guint64 residence_time)
+{
+    guint bucket = 0;
+    while (bucket < G_N_ELEMENTS(frame_stats_histogram_bounds) && residence_time >= frame_stats_histogram_bounds[bucket])
+    {
+        bucket++;
+    }
+    frame_stats_add(&stats->residence_histogram[bucket], 1);
+}
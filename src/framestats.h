@@ -0,0 +1,32 @@
+#ifndef FRAMESTATS_H_
+#define FRAMESTATS_H_
+
+#include <glib.h>
+
+// Number of buckets of the frame residence histogram. The last bucket counts all frames exceeding the largest bound
+#define FRAME_STATS_HISTOGRAM_BUCKET_COUNT 12
+
+// Upper bounds (in ns, exclusive) of all but the last histogram bucket
+extern const guint64 frame_stats_histogram_bounds[FRAME_STATS_HISTOGRAM_BUCKET_COUNT - 1];
+
+// Statistics about the frames passing through the element. All counters are updated with atomic operations and can be
+// read from any thread without taking a lock. They are pointer sized, i.e. 64 bit wide on 64 bit platforms
+typedef struct
+{
+    gsize delivered_count;
+    gsize dropped_count;
+    gsize incomplete_count;
+    // Total time (in ns) create spent waiting for filled frames
+    gsize blocked_time;
+    // Number of frames by the time (in ns) they spent between the frame callback and being pushed downstream
+    gsize residence_histogram[FRAME_STATS_HISTOGRAM_BUCKET_COUNT];
+    // Frames delivered per second during the last completed measurement window (in 1/1000 fps)
+    gint frame_rate;
+} FrameStats_t;
+
+void frame_stats_reset(FrameStats_t *stats);
+void frame_stats_add(gsize *counter, gsize value);
+gsize frame_stats_get(gsize *counter);
+void frame_stats_add_residence_time(FrameStats_t *stats, guint64 residence_time);
+
+#endif // FRAMESTATS_H_
@@ -0,0 +1,322 @@
+/* GStreamer
+ * Copyright (C) 2021 Allied Vision Technologies GmbH
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License version 2.0 as published by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#include "gstvimbaallocator.h"
+#include "helpers.h"
+#include "vimba_helpers.h"
+
+#include <string.h>
+
+GST_DEBUG_CATEGORY_STATIC(gst_vimba_allocator_debug_category);
+#define GST_CAT_DEFAULT gst_vimba_allocator_debug_category
+
+G_DEFINE_TYPE_WITH_CODE(GstVimbaAllocator,
+                        gst_vimba_allocator,
+                        GST_TYPE_ALLOCATOR,
+                        GST_DEBUG_CATEGORY_INIT(gst_vimba_allocator_debug_category,
+                                                "vimbaallocator",
+                                                0,
+                                                "debug category for vimbasrc frame memory allocator"))
+
+static void free_memory_block(GstVimbaMemory *mem)
+{
+    g_free(mem->raw_data);
+    g_slice_free(GstVimbaMemory, mem);
+}
+
+/**
+ * @brief Revokes and frees cached memory blocks whose announced size is smaller than min_size. Must be called with the
+ * allocator lock held
+ *
+ * @param allocator Allocator holding the cached memory blocks
+ * @param min_size Size a block needs to have to be kept in the cache
+ */
+static void drop_small_cached_memory(GstVimbaAllocator *allocator, gsize min_size)
+{
+    GList *link = allocator->cached_memory.head;
+    while (link != NULL)
+    {
+        GList *next = link->next;
+        GstVimbaMemory *mem = link->data;
+        if (mem->frame.bufferSize < min_size)
+        {
+            GST_DEBUG_OBJECT(allocator, "Revoking cached frame memory of %u bytes", mem->frame.bufferSize);
+            VmbFrameRevoke(allocator->camera_handle, &mem->frame);
+            g_queue_delete_link(&allocator->cached_memory, link);
+            free_memory_block(mem);
+        }
+        link = next;
+    }
+}
+
+static GstMemory *gst_vimba_allocator_alloc(GstAllocator *allocator, gsize size, GstAllocationParams *params)
+{
+    GstVimbaAllocator *vimba_allocator = GST_VIMBA_ALLOCATOR(allocator);
+    GstVimbaMemory *mem = NULL;
+    gsize maxsize = size + params->prefix + params->padding;
+
+    g_mutex_lock(&vimba_allocator->lock);
+    if (vimba_allocator->camera_handle == NULL)
+    {
+        g_mutex_unlock(&vimba_allocator->lock);
+        GST_ERROR_OBJECT(allocator, "Can not allocate frame memory without an open camera");
+        return NULL;
+    }
+    // Reuse memory that is already announced if it is large enough
+    for (GList *link = vimba_allocator->cached_memory.head; link != NULL; link = link->next)
+    {
+        GstVimbaMemory *cached = link->data;
+        if (cached->frame.bufferSize >= maxsize)
+        {
+            mem = cached;
+            g_queue_delete_link(&vimba_allocator->cached_memory, link);
+            break;
+        }
+    }
+    if (mem == NULL)
+    {
+        // Cached blocks are too small for the current payload and would never be used again
+        drop_small_cached_memory(vimba_allocator, maxsize);
+
+        mem = g_slice_new0(GstVimbaMemory);
+        mem->raw_data = g_try_malloc(maxsize + GST_VIMBA_MEMORY_ALIGN);
+        if (mem->raw_data == NULL)
+        {
+            g_mutex_unlock(&vimba_allocator->lock);
+            GST_ERROR_OBJECT(allocator, "Could not allocate %" G_GSIZE_FORMAT " bytes of frame memory", maxsize);
+            g_slice_free(GstVimbaMemory, mem);
+            return NULL;
+        }
+        mem->data = (guint8 *)(((guintptr)mem->raw_data + GST_VIMBA_MEMORY_ALIGN) & ~(guintptr)GST_VIMBA_MEMORY_ALIGN);
+        mem->frame.buffer = mem->data;
+        mem->frame.bufferSize = (VmbUint32_t)maxsize;
+
+        VmbError_t result = VmbFrameAnnounce(vimba_allocator->camera_handle,
+                                             &mem->frame,
+                                             (VmbUint32_t)sizeof(VmbFrame_t));
+        if (result != VmbErrorSuccess)
+        {
+            g_mutex_unlock(&vimba_allocator->lock);
+            GST_ERROR_OBJECT(allocator, "Could not announce frame. Got error code: %s", ErrorCodeToMessage(result));
+            free_memory_block(mem);
+            return NULL;
+        }
+        GST_DEBUG_OBJECT(allocator, "Allocated and announced %" G_GSIZE_FORMAT " bytes of frame memory", maxsize);
+    }
+    g_mutex_unlock(&vimba_allocator->lock);
+
+    gst_memory_init(GST_MEMORY_CAST(mem),
+                    params->flags,
+                    allocator,
+                    NULL,
+                    mem->frame.bufferSize,
+                    GST_VIMBA_MEMORY_ALIGN,
+                    params->prefix,
+                    size);
+
+    return GST_MEMORY_CAST(mem);
+}
+
+static void gst_vimba_allocator_free(GstAllocator *allocator, GstMemory *memory)
+{
+    GstVimbaAllocator *vimba_allocator = GST_VIMBA_ALLOCATOR(allocator);
+    GstVimbaMemory *mem = (GstVimbaMemory *)memory;
+
+    // Shared sub-memory only references the data of its parent
+    if (memory->parent != NULL)
+    {
+        g_slice_free(GstVimbaMemory, mem);
+        return;
+    }
+
+    g_mutex_lock(&vimba_allocator->lock);
+    if (vimba_allocator->camera_handle != NULL)
+    {
+        if (!GST_MEMORY_FLAG_IS_SET(memory, GST_VIMBA_MEMORY_FLAG_DISCARD))
+        {
+            // Keep the memory announced so the next allocation does not need to announce it again
+            g_queue_push_tail(&vimba_allocator->cached_memory, mem);
+            g_mutex_unlock(&vimba_allocator->lock);
+            return;
+        }
+        GST_DEBUG_OBJECT(allocator, "Revoking discarded frame memory of %u bytes", mem->frame.bufferSize);
+        VmbFrameRevoke(vimba_allocator->camera_handle, &mem->frame);
+    }
+    g_mutex_unlock(&vimba_allocator->lock);
+
+    // The frame is either revoked above or was already revoked in gst_vimba_allocator_revoke_all
+    free_memory_block(mem);
+}
+
+static gpointer gst_vimba_memory_map(GstMemory *memory, gsize maxsize, GstMapFlags flags)
+{
+    UNUSED(maxsize);
+    UNUSED(flags);
+    return ((GstVimbaMemory *)memory)->data;
+}
+
+static void gst_vimba_memory_unmap(GstMemory *memory)
+{
+    UNUSED(memory);
+}
+
+static GstMemory *gst_vimba_memory_share(GstMemory *memory, gssize offset, gssize size)
+{
+    GstMemory *parent = memory->parent != NULL ? memory->parent : memory;
+
+    if (size == -1)
+    {
+        size = memory->size - offset;
+    }
+
+    GstVimbaMemory *sub = g_slice_new0(GstVimbaMemory);
+    gst_memory_init(GST_MEMORY_CAST(sub),
+                    GST_MINI_OBJECT_FLAGS(parent) | GST_MINI_OBJECT_FLAG_LOCK_READONLY,
+                    memory->allocator,
+                    parent,
+                    memory->maxsize,
+                    memory->align,
+                    memory->offset + offset,
+                    size);
+    sub->data = ((GstVimbaMemory *)memory)->data;
+
+    return GST_MEMORY_CAST(sub);
+}
+
+static GstMemory *gst_vimba_memory_copy(GstMemory *memory, gssize offset, gssize size)
+{
+    if (size == -1)
+    {
+        size = memory->size > (gsize)offset ? memory->size - offset : 0;
+    }
+
+    // Copies do not need to be announced to Vimba. Use system memory so no frames are announced by copying
+    GstMemory *copy = gst_allocator_alloc(NULL, size, NULL);
+    if (copy != NULL)
+    {
+        GstMapInfo map;
+        gst_memory_map(copy, &map, GST_MAP_WRITE);
+        memcpy(map.data, ((GstVimbaMemory *)memory)->data + memory->offset + offset, size);
+        gst_memory_unmap(copy, &map);
+    }
+
+    return copy;
+}
+
+static void gst_vimba_allocator_finalize(GObject *object)
+{
+    GstVimbaAllocator *allocator = GST_VIMBA_ALLOCATOR(object);
+
+    gst_vimba_allocator_revoke_all(allocator);
+    g_mutex_clear(&allocator->lock);
+
+    G_OBJECT_CLASS(gst_vimba_allocator_parent_class)->finalize(object);
+}
+
+static void gst_vimba_allocator_class_init(GstVimbaAllocatorClass *klass)
+{
+    GObjectClass *gobject_class = G_OBJECT_CLASS(klass);
+    GstAllocatorClass *allocator_class = GST_ALLOCATOR_CLASS(klass);
+
+    gobject_class->finalize = gst_vimba_allocator_finalize;
+    allocator_class->alloc = gst_vimba_allocator_alloc;
+    allocator_class->free = gst_vimba_allocator_free;
+}
+
+static void gst_vimba_allocator_init(GstVimbaAllocator *allocator)
+{
+    GstAllocator *alloc = GST_ALLOCATOR_CAST(allocator);
+
+    alloc->mem_type = GST_VIMBA_MEMORY_TYPE;
+    alloc->mem_map = gst_vimba_memory_map;
+    alloc->mem_unmap = gst_vimba_memory_unmap;
+    alloc->mem_share = gst_vimba_memory_share;
+    alloc->mem_copy = gst_vimba_memory_copy;
+
+    g_queue_init(&allocator->cached_memory);
+    g_mutex_init(&allocator->lock);
+}
+
+/**
+ * @brief Creates an allocator whose memory is announced to Vimba as frames of the given camera
+ *
+ * @param camera_handle Handle of the opened camera the frames are announced to
+ * @return GstAllocator* The new allocator
+ */
+GstAllocator *gst_vimba_allocator_new(VmbHandle_t camera_handle)
+{
+    GstVimbaAllocator *allocator = g_object_new(GST_TYPE_VIMBA_ALLOCATOR, NULL);
+    gst_object_ref_sink(allocator);
+    allocator->camera_handle = camera_handle;
+
+    return GST_ALLOCATOR_CAST(allocator);
+}
+
+/**
+ * @brief Revokes all frames announced by this allocator and frees the memory that is not in use. Memory that is still
+ * in use is freed when it is released. Must be called before the camera is closed
+ *
+ * @param allocator The allocator whose frames should be revoked
+ */
+void gst_vimba_allocator_revoke_all(GstVimbaAllocator *allocator)
+{
+    g_mutex_lock(&allocator->lock);
+    if (allocator->camera_handle != NULL)
+    {
+        GST_DEBUG_OBJECT(allocator, "Revoking all announced frames");
+        VmbFrameRevokeAll(allocator->camera_handle);
+        allocator->camera_handle = NULL;
+    }
+    GstVimbaMemory *mem;
+    while ((mem = g_queue_pop_head(&allocator->cached_memory)) != NULL)
+    {
+        free_memory_block(mem);
+    }
+    g_mutex_unlock(&allocator->lock);
+}
+
+gboolean gst_is_vimba_memory(GstMemory *mem)
+{
+    return mem != NULL && gst_memory_is_type(mem, GST_VIMBA_MEMORY_TYPE);
+}
+
+/**
+ * @brief Gets the Vimba frame that was announced with the given memory
+ *
+ * @param mem Memory allocated by a GstVimbaAllocator
+ * @return VmbFrame_t* The announced frame or NULL if mem is not frame memory of a GstVimbaAllocator
+ */
+VmbFrame_t *gst_vimba_memory_get_frame(GstMemory *mem)
+{
+    if (!gst_is_vimba_memory(mem) || mem->parent != NULL)
+    {
+        return NULL;
+    }
+    return &((GstVimbaMemory *)mem)->frame;
+}
+
+/**
+ * @brief Gets the memory a frame announced by a GstVimbaAllocator belongs to
+ *
+ * @param frame Frame that was announced by a GstVimbaAllocator (e.g. received in the frame callback)
+ * @return GstVimbaMemory* The memory holding the frame
+ */
+GstVimbaMemory *gst_vimba_memory_from_frame(VmbFrame_t *frame)
+{
+    return (GstVimbaMemory *)((guint8 *)frame - G_STRUCT_OFFSET(GstVimbaMemory, frame));
+}
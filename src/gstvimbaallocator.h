@@ -0,0 +1,88 @@
+/* GStreamer
+ * Copyright (C) 2021 Allied Vision Technologies GmbH
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License version 2.0 as published by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifndef _GST_VIMBA_ALLOCATOR_H_
+#define _GST_VIMBA_ALLOCATOR_H_
+
+#include <gst/gst.h>
+
+#include <VimbaC/Include/VimbaC.h>
+
+G_BEGIN_DECLS
+
+#define GST_TYPE_VIMBA_ALLOCATOR (gst_vimba_allocator_get_type())
+#define GST_VIMBA_ALLOCATOR(obj) (G_TYPE_CHECK_INSTANCE_CAST((obj), GST_TYPE_VIMBA_ALLOCATOR, GstVimbaAllocator))
+#define GST_IS_VIMBA_ALLOCATOR(obj) (G_TYPE_CHECK_INSTANCE_TYPE((obj), GST_TYPE_VIMBA_ALLOCATOR))
+
+// Memory type of GstMemory objects allocated by the GstVimbaAllocator. Can be used by downstream elements to recognise
+// memory that was announced to Vimba via gst_memory_is_type
+#define GST_VIMBA_MEMORY_TYPE "VimbaFrameMemory"
+
+// Alignment (as mask) of the frame memory. Page alignment allows transport layers to transfer directly into the memory
+#define GST_VIMBA_MEMORY_ALIGN 4095
+
+// Memory flag requesting that the frame is revoked and its memory freed instead of keeping it announced for reuse once
+// the memory is released
+#define GST_VIMBA_MEMORY_FLAG_DISCARD GST_MEMORY_FLAG_LAST
+
+typedef struct _GstVimbaAllocator GstVimbaAllocator;
+typedef struct _GstVimbaAllocatorClass GstVimbaAllocatorClass;
+
+typedef struct
+{
+    GstMemory mem;
+
+    // Frame that was announced to Vimba with the data of this memory block. Only valid for memory that was allocated
+    // by the allocator (not for memory created by gst_memory_share)
+    VmbFrame_t frame;
+    // Start of the (aligned) image data
+    guint8 *data;
+    // Pointer returned by the underlying allocation. Needed to free the memory
+    gpointer raw_data;
+    // Monotonic time (see gst_util_get_timestamp) at which the frame was last received from Vimba
+    GstClockTime receive_time;
+} GstVimbaMemory;
+
+struct _GstVimbaAllocator
+{
+    GstAllocator parent;
+
+    VmbHandle_t camera_handle;
+    // Memory blocks that are announced to Vimba but currently not used by any GstMemory. These are reused by the next
+    // allocations instead of allocating and announcing new memory
+    GQueue cached_memory;
+    GMutex lock;
+};
+
+struct _GstVimbaAllocatorClass
+{
+    GstAllocatorClass parent_class;
+};
+
+GType gst_vimba_allocator_get_type(void);
+
+GstAllocator *gst_vimba_allocator_new(VmbHandle_t camera_handle);
+void gst_vimba_allocator_revoke_all(GstVimbaAllocator *allocator);
+
+gboolean gst_is_vimba_memory(GstMemory *mem);
+VmbFrame_t *gst_vimba_memory_get_frame(GstMemory *mem);
+GstVimbaMemory *gst_vimba_memory_from_frame(VmbFrame_t *frame);
+
+G_END_DECLS
+
+#endif
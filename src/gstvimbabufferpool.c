@@ -0,0 +1,474 @@
+/* GStreamer
+ * Copyright (C) 2021 Allied Vision Technologies GmbH
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License version 2.0 as published by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#include "gstvimbabufferpool.h"
+#include "gstvimbaallocator.h"
+#include "vimba_helpers.h"
+
+GST_DEBUG_CATEGORY_STATIC(gst_vimba_buffer_pool_debug_category);
+#define GST_CAT_DEFAULT gst_vimba_buffer_pool_debug_category
+
+G_DEFINE_TYPE_WITH_CODE(GstVimbaBufferPool,
+                        gst_vimba_buffer_pool,
+                        GST_TYPE_BUFFER_POOL,
+                        GST_DEBUG_CATEGORY_INIT(gst_vimba_buffer_pool_debug_category,
+                                                "vimbabufferpool",
+                                                0,
+                                                "debug category for vimbasrc buffer pool"))
+
+static VmbFrame_t *get_buffer_frame(GstBuffer *buffer)
+{
+    if (gst_buffer_n_memory(buffer) != 1)
+    {
+        return NULL;
+    }
+    return gst_vimba_memory_get_frame(gst_buffer_peek_memory(buffer, 0));
+}
+
+/**
+ * @brief Queues the frame of buffer to Vimba and remembers the buffer as captured. Must be called with the pool lock
+ * held
+ */
+static VmbError_t queue_buffer_frame(GstVimbaBufferPool *pool, GstBuffer *buffer, VmbFrame_t *frame)
+{
+    frame->context[0] = pool->frame_context;
+    frame->context[1] = buffer;
+    frame->context[2] = pool;
+    // Counted before queueing since the frame callback may already run before VmbCaptureFrameQueue returns
+    g_atomic_int_inc(&pool->queued_count);
+    VmbError_t result = VmbCaptureFrameQueue(pool->camera_handle, frame, pool->frame_callback);
+    if (result == VmbErrorSuccess)
+    {
+        g_ptr_array_add(pool->captured_buffers, buffer);
+    }
+    else
+    {
+        g_atomic_int_add(&pool->queued_count, -1);
+        GST_WARNING_OBJECT(pool, "Could not queue frame. Got error code: %s", ErrorCodeToMessage(result));
+    }
+    return result;
+}
+
+static gboolean gst_vimba_buffer_pool_set_config(GstBufferPool *bpool, GstStructure *config)
+{
+    GstVimbaBufferPool *pool = GST_VIMBA_BUFFER_POOL(bpool);
+
+    guint size, min_buffers;
+    if (!gst_buffer_pool_config_get_params(config, NULL, &size, &min_buffers, NULL))
+    {
+        GST_ERROR_OBJECT(pool, "Invalid buffer pool configuration");
+        return FALSE;
+    }
+    pool->payload_size = size;
+    pool->min_buffers = min_buffers;
+
+    return GST_BUFFER_POOL_CLASS(gst_vimba_buffer_pool_parent_class)->set_config(bpool, config);
+}
+
+static GstFlowReturn gst_vimba_buffer_pool_alloc_buffer(GstBufferPool *bpool,
+                                                        GstBuffer **buffer,
+                                                        GstBufferPoolAcquireParams *params)
+{
+    GstVimbaBufferPool *pool = GST_VIMBA_BUFFER_POOL(bpool);
+
+    GstFlowReturn ret = GST_BUFFER_POOL_CLASS(gst_vimba_buffer_pool_parent_class)->alloc_buffer(bpool, buffer, params);
+    if (ret != GST_FLOW_OK)
+    {
+        return ret;
+    }
+
+    VmbFrame_t *frame = get_buffer_frame(*buffer);
+    if (frame == NULL)
+    {
+        GST_ERROR_OBJECT(pool, "Buffer memory was not allocated by a vimba allocator");
+        gst_buffer_unref(*buffer);
+        *buffer = NULL;
+        return GST_FLOW_ERROR;
+    }
+    frame->context[1] = *buffer;
+    g_atomic_int_inc(&pool->buffer_count);
+
+    return GST_FLOW_OK;
+}
+
+static void gst_vimba_buffer_pool_free_buffer(GstBufferPool *bpool, GstBuffer *buffer)
+{
+    GstVimbaBufferPool *pool = GST_VIMBA_BUFFER_POOL(bpool);
+
+    g_atomic_int_add(&pool->buffer_count, -1);
+
+    GST_BUFFER_POOL_CLASS(gst_vimba_buffer_pool_parent_class)->free_buffer(bpool, buffer);
+}
+
+static GstFlowReturn gst_vimba_buffer_pool_acquire_buffer(GstBufferPool *bpool,
+                                                          GstBuffer **buffer,
+                                                          GstBufferPoolAcquireParams *params)
+{
+    GstVimbaBufferPool *pool = GST_VIMBA_BUFFER_POOL(bpool);
+
+    if (params != NULL && (params->flags & GST_VIMBA_BUFFER_POOL_ACQUIRE_FLAG_FRAME))
+    {
+        // The buffer is not in the pool queue but was handed to Vimba. Take it back from there
+        VmbFrame_t *frame = ((GstVimbaBufferPoolAcquireParams *)params)->frame;
+        GstBuffer *frame_buffer = frame->context[1];
+
+        g_mutex_lock(&pool->lock);
+        gboolean was_captured = g_ptr_array_remove_fast(pool->captured_buffers, frame_buffer);
+        if (was_captured)
+        {
+            pool->outstanding_count++;
+        }
+        g_mutex_unlock(&pool->lock);
+        if (!was_captured)
+        {
+            GST_ERROR_OBJECT(pool, "Frame with ID %llu does not belong to a captured buffer", frame->frameID);
+            return GST_FLOW_ERROR;
+        }
+
+        *buffer = frame_buffer;
+        return GST_FLOW_OK;
+    }
+
+    return GST_BUFFER_POOL_CLASS(gst_vimba_buffer_pool_parent_class)->acquire_buffer(bpool, buffer, params);
+}
+
+static void gst_vimba_buffer_pool_reset_buffer(GstBufferPool *bpool, GstBuffer *buffer)
+{
+    GstVimbaBufferPool *pool = GST_VIMBA_BUFFER_POOL(bpool);
+
+    GST_BUFFER_POOL_CLASS(gst_vimba_buffer_pool_parent_class)->reset_buffer(bpool, buffer);
+
+    // Downstream may have changed the visible region of the frame memory. Restore the full payload
+    if (gst_buffer_n_memory(buffer) == 1 && gst_buffer_is_all_memory_writable(buffer))
+    {
+        GstMemory *mem = gst_buffer_peek_memory(buffer, 0);
+        if (mem->offset != 0 || mem->size != pool->payload_size)
+        {
+            gst_buffer_resize(buffer, -(gssize)mem->offset, pool->payload_size);
+        }
+    }
+}
+
+static void gst_vimba_buffer_pool_release_buffer(GstBufferPool *bpool, GstBuffer *buffer)
+{
+    GstVimbaBufferPool *pool = GST_VIMBA_BUFFER_POOL(bpool);
+
+    bool requeued = false;
+    VmbFrame_t *frame = get_buffer_frame(buffer);
+
+    g_mutex_lock(&pool->lock);
+    pool->outstanding_count--;
+    if (pool->pending_discards > 0 && frame != NULL && gst_buffer_is_all_memory_writable(buffer))
+    {
+        // Free the buffer and revoke its frame so the pool shrinks
+        pool->pending_discards--;
+        GST_MINI_OBJECT_FLAG_SET(gst_buffer_peek_memory(buffer, 0), GST_VIMBA_MEMORY_FLAG_DISCARD);
+        GST_BUFFER_FLAG_SET(buffer, GST_BUFFER_FLAG_TAG_MEMORY);
+    }
+    // Only hand the memory to Vimba again if nobody else can still access it
+    if (g_atomic_int_get(&pool->is_capturing) &&
+        frame != NULL &&
+        !GST_BUFFER_FLAG_IS_SET(buffer, GST_BUFFER_FLAG_TAG_MEMORY) &&
+        gst_buffer_is_all_memory_writable(buffer))
+    {
+        requeued = queue_buffer_frame(pool, buffer, frame) == VmbErrorSuccess;
+    }
+    g_mutex_unlock(&pool->lock);
+
+    if (!requeued)
+    {
+        GST_BUFFER_POOL_CLASS(gst_vimba_buffer_pool_parent_class)->release_buffer(bpool, buffer);
+    }
+}
+
+static void gst_vimba_buffer_pool_finalize(GObject *object)
+{
+    GstVimbaBufferPool *pool = GST_VIMBA_BUFFER_POOL(object);
+
+    g_ptr_array_unref(pool->captured_buffers);
+    g_mutex_clear(&pool->lock);
+
+    G_OBJECT_CLASS(gst_vimba_buffer_pool_parent_class)->finalize(object);
+}
+
+static void gst_vimba_buffer_pool_class_init(GstVimbaBufferPoolClass *klass)
+{
+    GObjectClass *gobject_class = G_OBJECT_CLASS(klass);
+    GstBufferPoolClass *buffer_pool_class = GST_BUFFER_POOL_CLASS(klass);
+
+    gobject_class->finalize = gst_vimba_buffer_pool_finalize;
+    buffer_pool_class->set_config = gst_vimba_buffer_pool_set_config;
+    buffer_pool_class->alloc_buffer = gst_vimba_buffer_pool_alloc_buffer;
+    buffer_pool_class->free_buffer = gst_vimba_buffer_pool_free_buffer;
+    buffer_pool_class->acquire_buffer = gst_vimba_buffer_pool_acquire_buffer;
+    buffer_pool_class->reset_buffer = gst_vimba_buffer_pool_reset_buffer;
+    buffer_pool_class->release_buffer = gst_vimba_buffer_pool_release_buffer;
+}
+
+static void gst_vimba_buffer_pool_init(GstVimbaBufferPool *pool)
+{
+    g_mutex_init(&pool->lock);
+    pool->captured_buffers = g_ptr_array_new();
+    g_atomic_int_set(&pool->is_capturing, 0);
+}
+
+/**
+ * @brief Creates a new buffer pool for the frames of the given camera. The pool must be configured with a
+ * GstVimbaAllocator for the same camera
+ *
+ * @param camera_handle Handle of the camera the frames are queued to
+ * @param frame_callback Callback passed to Vimba when frames are queued
+ * @param frame_context User data that is stored at frame->context[0] of every queued frame
+ * @return GstBufferPool* The new buffer pool
+ */
+GstBufferPool *gst_vimba_buffer_pool_new(VmbHandle_t camera_handle,
+                                         VmbFrameCallback frame_callback,
+                                         gpointer frame_context)
+{
+    GstVimbaBufferPool *pool = g_object_new(GST_TYPE_VIMBA_BUFFER_POOL, NULL);
+    gst_object_ref_sink(pool);
+
+    pool->camera_handle = camera_handle;
+    pool->frame_callback = frame_callback;
+    pool->frame_context = frame_context;
+
+    return GST_BUFFER_POOL_CAST(pool);
+}
+
+/**
+ * @brief Queues the frames of all buffers currently available in the pool to Vimba and requeues released buffers from
+ * now on. The pool must be active and the capture engine must be started
+ *
+ * @param pool The pool whose frames should be captured into
+ * @return VmbError_t Return status indicating errors if they occurred
+ */
+VmbError_t gst_vimba_buffer_pool_start_capture(GstVimbaBufferPool *pool)
+{
+    GstBufferPool *bpool = GST_BUFFER_POOL_CAST(pool);
+    GstBufferPoolAcquireParams params = {.flags = GST_BUFFER_POOL_ACQUIRE_FLAG_DONTWAIT};
+    VmbError_t result = VmbErrorSuccess;
+    GstBuffer *buffer;
+
+    g_mutex_lock(&pool->lock);
+    g_atomic_int_set(&pool->is_capturing, 1);
+    g_atomic_int_set(&pool->is_starved, 0);
+    // Take the buffers directly from the pool queue. They are not outstanding while Vimba owns them. Only take as many
+    // buffers as are waiting in the queue so that no additional buffers are allocated
+    gint available = g_atomic_int_get(&pool->buffer_count) - (gint)pool->captured_buffers->len -
+                     (gint)pool->outstanding_count;
+    while (available-- > 0 &&
+           GST_BUFFER_POOL_CLASS(gst_vimba_buffer_pool_parent_class)->acquire_buffer(bpool, &buffer, &params) ==
+               GST_FLOW_OK)
+    {
+        result = queue_buffer_frame(pool, buffer, get_buffer_frame(buffer));
+        if (result != VmbErrorSuccess)
+        {
+            GST_BUFFER_POOL_CLASS(gst_vimba_buffer_pool_parent_class)->release_buffer(bpool, buffer);
+            break;
+        }
+    }
+    GST_DEBUG_OBJECT(pool, "%u frames queued for capturing", pool->captured_buffers->len);
+    g_mutex_unlock(&pool->lock);
+
+    return result;
+}
+
+/**
+ * @brief Puts the buffers of all frames that were handed to Vimba back into the pool. Vimba must no longer use the
+ * frames (the capture queue must have been flushed) and filled frames that were not acquired yet must be discarded
+ *
+ * @param pool The pool whose frames should no longer be captured into
+ */
+void gst_vimba_buffer_pool_stop_capture(GstVimbaBufferPool *pool)
+{
+    GstBufferPool *bpool = GST_BUFFER_POOL_CAST(pool);
+
+    g_mutex_lock(&pool->lock);
+    g_atomic_int_set(&pool->is_capturing, 0);
+    for (guint i = 0; i < pool->captured_buffers->len; i++)
+    {
+        GstBuffer *buffer = g_ptr_array_index(pool->captured_buffers, i);
+        GST_BUFFER_POOL_CLASS(gst_vimba_buffer_pool_parent_class)->release_buffer(bpool, buffer);
+    }
+    g_ptr_array_set_size(pool->captured_buffers, 0);
+    g_atomic_int_set(&pool->queued_count, 0);
+    g_atomic_int_set(&pool->is_starved, 0);
+    g_mutex_unlock(&pool->lock);
+}
+
+/**
+ * @brief Notifies the pool owning the frame that Vimba filled it. Must be called from the frame callback for every
+ * received frame
+ *
+ * @param frame Filled frame received in the frame callback
+ */
+void gst_vimba_buffer_pool_frame_filled(VmbFrame_t *frame)
+{
+    GstVimbaBufferPool *pool = frame->context[2];
+
+    // Called for every frame, so no lock is taken that the streaming thread may hold. Frames are counted before they are
+    // queued, so the count does not drop below 0
+    if (g_atomic_int_dec_and_test(&pool->queued_count))
+    {
+        g_atomic_int_set(&pool->is_starved, 1);
+    }
+}
+
+/**
+ * @brief Acquires the buffer owning a filled frame from the pool. Releasing the buffer hands the frame back to Vimba
+ *
+ * @param pool The pool the frame belongs to
+ * @param frame Filled frame received in the frame callback
+ * @param buffer Output location for the acquired buffer
+ * @return GstFlowReturn GST_FLOW_OK if the buffer was acquired
+ */
+GstFlowReturn gst_vimba_buffer_pool_acquire_frame(GstVimbaBufferPool *pool, VmbFrame_t *frame, GstBuffer **buffer)
+{
+    GstVimbaBufferPoolAcquireParams params = {
+        .parent = {.flags = (GstBufferPoolAcquireFlags)GST_VIMBA_BUFFER_POOL_ACQUIRE_FLAG_FRAME},
+        .frame = frame};
+
+    return gst_buffer_pool_acquire_buffer(GST_BUFFER_POOL_CAST(pool),
+                                          buffer,
+                                          (GstBufferPoolAcquireParams *)&params);
+}
+
+/**
+ * @brief Hands a filled frame that was not acquired back to Vimba without passing it downstream. Takes no lock, so it
+ * may be called from the frame callback
+ *
+ * @param pool The pool the frame belongs to
+ * @param frame Filled frame received in the frame callback
+ * @return VmbError_t Return status indicating errors if they occurred
+ */
+VmbError_t gst_vimba_buffer_pool_requeue_frame(GstVimbaBufferPool *pool, VmbFrame_t *frame)
+{
+    // The buffer of the frame was never acquired and is still in captured_buffers, so only the frame is queued again
+    if (!g_atomic_int_get(&pool->is_capturing))
+    {
+        return VmbErrorInvalidCall;
+    }
+
+    g_atomic_int_inc(&pool->queued_count);
+    VmbError_t result = VmbCaptureFrameQueue(pool->camera_handle, frame, pool->frame_callback);
+    if (result != VmbErrorSuccess)
+    {
+        g_atomic_int_add(&pool->queued_count, -1);
+    }
+
+    return result;
+}
+
+/**
+ * @brief Gets the number of frames that are currently queued to Vimba and not filled yet
+ */
+guint gst_vimba_buffer_pool_get_queued_count(GstVimbaBufferPool *pool)
+{
+    return (guint)g_atomic_int_get(&pool->queued_count);
+}
+
+/**
+ * @brief Gets the number of buffers (and therefore announced frames) currently allocated by the pool
+ */
+guint gst_vimba_buffer_pool_get_buffer_count(GstVimbaBufferPool *pool)
+{
+    return (guint)g_atomic_int_get(&pool->buffer_count);
+}
+
+/**
+ * @brief Checks whether the camera ran out of queued frames since the last call and resets the indicator
+ *
+ * @param pool The pool to check
+ * @return true if a frame was filled while no other frame was queued to Vimba
+ */
+bool gst_vimba_buffer_pool_take_starved(GstVimbaBufferPool *pool)
+{
+    return g_atomic_int_compare_and_exchange(&pool->is_starved, 1, 0);
+}
+
+/**
+ * @brief Queues one additional frame to Vimba. A new frame is allocated and announced if no unused buffer is left in
+ * the pool. Must not be called from the frame callback because announcing frames is not allowed there
+ *
+ * @param pool The pool that should grow
+ * @return true if an additional frame was queued, false if the pool is not capturing or max_buffers is reached
+ */
+bool gst_vimba_buffer_pool_grow(GstVimbaBufferPool *pool)
+{
+    GstBufferPool *bpool = GST_BUFFER_POOL_CAST(pool);
+    GstBufferPoolAcquireParams params = {.flags = GST_BUFFER_POOL_ACQUIRE_FLAG_DONTWAIT};
+    GstBuffer *buffer;
+
+    g_mutex_lock(&pool->lock);
+    bool is_capturing = g_atomic_int_get(&pool->is_capturing);
+    // A pending shrink is no longer wanted
+    bool has_grown = is_capturing && pool->pending_discards > 0;
+    if (has_grown)
+    {
+        pool->pending_discards--;
+    }
+    g_mutex_unlock(&pool->lock);
+    if (!is_capturing || has_grown)
+    {
+        return has_grown;
+    }
+
+    // Allocating and announcing a new frame may take a while. The lock is not held meanwhile so that it does not block
+    // the threads releasing buffers
+    if (GST_BUFFER_POOL_CLASS(gst_vimba_buffer_pool_parent_class)->acquire_buffer(bpool, &buffer, &params) !=
+        GST_FLOW_OK)
+    {
+        return false;
+    }
+
+    g_mutex_lock(&pool->lock);
+    // Capturing may have been stopped while the frame was announced
+    if (g_atomic_int_get(&pool->is_capturing))
+    {
+        has_grown = queue_buffer_frame(pool, buffer, get_buffer_frame(buffer)) == VmbErrorSuccess;
+    }
+    g_mutex_unlock(&pool->lock);
+    if (!has_grown)
+    {
+        GST_BUFFER_POOL_CLASS(gst_vimba_buffer_pool_parent_class)->release_buffer(bpool, buffer);
+    }
+
+    return has_grown;
+}
+
+/**
+ * @brief Frees the next released buffer instead of queueing its frame to Vimba again, revoking the frame. The pool does
+ * not shrink below its configured min_buffers
+ *
+ * @param pool The pool that should shrink
+ * @return true if a buffer will be freed
+ */
+bool gst_vimba_buffer_pool_shrink(GstVimbaBufferPool *pool)
+{
+    bool will_shrink = false;
+
+    g_mutex_lock(&pool->lock);
+    if ((guint)g_atomic_int_get(&pool->buffer_count) - pool->pending_discards > pool->min_buffers)
+    {
+        pool->pending_discards++;
+        will_shrink = true;
+    }
+    g_mutex_unlock(&pool->lock);
+
+    return will_shrink;
+}
@@ -0,0 +1,109 @@
+/* GStreamer
+ * Copyright (C) 2021 Allied Vision Technologies GmbH
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License version 2.0 as published by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifndef _GST_VIMBA_BUFFER_POOL_H_
+#define _GST_VIMBA_BUFFER_POOL_H_
+
+#include <gst/gst.h>
+
+#include <VimbaC/Include/VimbaC.h>
+
+#include <stdbool.h>
+
+G_BEGIN_DECLS
+
+#define GST_TYPE_VIMBA_BUFFER_POOL (gst_vimba_buffer_pool_get_type())
+#define GST_VIMBA_BUFFER_POOL(obj) (G_TYPE_CHECK_INSTANCE_CAST((obj), GST_TYPE_VIMBA_BUFFER_POOL, GstVimbaBufferPool))
+#define GST_IS_VIMBA_BUFFER_POOL(obj) (G_TYPE_CHECK_INSTANCE_TYPE((obj), GST_TYPE_VIMBA_BUFFER_POOL))
+
+// Acquire flag requesting the buffer that owns the frame passed in GstVimbaBufferPoolAcquireParams
+#define GST_VIMBA_BUFFER_POOL_ACQUIRE_FLAG_FRAME GST_BUFFER_POOL_ACQUIRE_FLAG_LAST
+
+typedef struct _GstVimbaBufferPool GstVimbaBufferPool;
+typedef struct _GstVimbaBufferPoolClass GstVimbaBufferPoolClass;
+
+typedef struct
+{
+    GstBufferPoolAcquireParams parent;
+
+    VmbFrame_t *frame;
+} GstVimbaBufferPoolAcquireParams;
+
+// Buffer pool whose buffers each hold the memory of one Vimba frame (allocated by a GstVimbaAllocator). While capturing,
+// released buffers are not put back into the pool but queued to Vimba directly. The buffer owning a frame is stored at
+// frame->context[1], the frame_context passed on creation at frame->context[0] and the pool itself at frame->context[2]
+//
+// If the configured max_buffers is larger than min_buffers, the number of frames can be changed while capturing with
+// gst_vimba_buffer_pool_grow and gst_vimba_buffer_pool_shrink
+struct _GstVimbaBufferPool
+{
+    GstBufferPool parent;
+
+    VmbHandle_t camera_handle;
+    VmbFrameCallback frame_callback;
+    gpointer frame_context;
+
+    // Size and minimum number of the buffers as configured
+    guint payload_size;
+    guint min_buffers;
+
+    // Number of buffers currently allocated by the pool (accessed atomically)
+    gint buffer_count;
+    // Number of frames queued to Vimba that were not filled yet (accessed atomically, the frame callback takes no lock)
+    gint queued_count;
+    // Set if a frame was filled while no other frame was queued, so the camera had nothing left to capture into
+    // (accessed atomically)
+    gint is_starved;
+
+    // Set while released and rejected frames are handed back to Vimba (accessed atomically, so that rejected frames
+    // can be requeued from the frame callback without taking the lock)
+    gint is_capturing;
+
+    GMutex lock;
+    // Buffers whose frames are handed to Vimba (queued for capturing or filled and not acquired yet)
+    GPtrArray *captured_buffers;
+    // Number of buffers acquired via gst_vimba_buffer_pool_acquire_frame that were not released yet
+    guint outstanding_count;
+    // Number of released buffers that should be freed instead of being requeued
+    guint pending_discards;
+};
+
+struct _GstVimbaBufferPoolClass
+{
+    GstBufferPoolClass parent_class;
+};
+
+GType gst_vimba_buffer_pool_get_type(void);
+
+GstBufferPool *gst_vimba_buffer_pool_new(VmbHandle_t camera_handle,
+                                         VmbFrameCallback frame_callback,
+                                         gpointer frame_context);
+VmbError_t gst_vimba_buffer_pool_start_capture(GstVimbaBufferPool *pool);
+void gst_vimba_buffer_pool_stop_capture(GstVimbaBufferPool *pool);
+void gst_vimba_buffer_pool_frame_filled(VmbFrame_t *frame);
+GstFlowReturn gst_vimba_buffer_pool_acquire_frame(GstVimbaBufferPool *pool, VmbFrame_t *frame, GstBuffer **buffer);
+VmbError_t gst_vimba_buffer_pool_requeue_frame(GstVimbaBufferPool *pool, VmbFrame_t *frame);
+guint gst_vimba_buffer_pool_get_queued_count(GstVimbaBufferPool *pool);
+guint gst_vimba_buffer_pool_get_buffer_count(GstVimbaBufferPool *pool);
+bool gst_vimba_buffer_pool_take_starved(GstVimbaBufferPool *pool);
+bool gst_vimba_buffer_pool_grow(GstVimbaBufferPool *pool);
+bool gst_vimba_buffer_pool_shrink(GstVimbaBufferPool *pool);
+
+G_END_DECLS
+
+#endif
@@ -0,0 +1,162 @@
+/* GStreamer
+ * Copyright (C) 2021 Allied Vision Technologies GmbH
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License version 2.0 as published by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#include "gstvimbaframemeta.h"
+#include "helpers.h"
+
+GType gst_vimba_frame_meta_api_get_type(void)
+{
+    static GType type = 0;
+    // The meta describes the captured frame, not the memory layout, so it stays valid for any transformation
+    static const gchar *tags[] = {NULL};
+
+    if (g_once_init_enter(&type))
+    {
+        GType _type = gst_meta_api_type_register("GstVimbaFrameMetaAPI", tags);
+        g_once_init_leave(&type, _type);
+    }
+    return type;
+}
+
+static gboolean gst_vimba_frame_meta_init(GstMeta *meta, gpointer params, GstBuffer *buffer)
+{
+    UNUSED(params);
+    UNUSED(buffer);
+
+    GstVimbaFrameMeta *frame_meta = (GstVimbaFrameMeta *)meta;
+    frame_meta->frame_id = 0;
+    frame_meta->timestamp = 0;
+    frame_meta->receive_status = VmbFrameStatusInvalid;
+    frame_meta->image_size = 0;
+    frame_meta->offset_x = 0;
+    frame_meta->offset_y = 0;
+    frame_meta->width = 0;
+    frame_meta->height = 0;
+    frame_meta->has_chunk_data = FALSE;
+    frame_meta->exposure_time = 0.;
+    frame_meta->gain = 0.;
+
+    return TRUE;
+}
+
+static gboolean gst_vimba_frame_meta_transform(GstBuffer *dest,
+                                               GstMeta *meta,
+                                               GstBuffer *buffer,
+                                               GQuark type,
+                                               gpointer data)
+{
+    UNUSED(buffer);
+    UNUSED(type);
+    UNUSED(data);
+
+    GstVimbaFrameMeta *src_meta = (GstVimbaFrameMeta *)meta;
+    GstVimbaFrameMeta *dest_meta =
+        (GstVimbaFrameMeta *)gst_buffer_add_meta(dest, GST_VIMBA_FRAME_META_INFO, NULL);
+    if (dest_meta == NULL)
+    {
+        return FALSE;
+    }
+
+    dest_meta->frame_id = src_meta->frame_id;
+    dest_meta->timestamp = src_meta->timestamp;
+    dest_meta->receive_status = src_meta->receive_status;
+    dest_meta->image_size = src_meta->image_size;
+    dest_meta->offset_x = src_meta->offset_x;
+    dest_meta->offset_y = src_meta->offset_y;
+    dest_meta->width = src_meta->width;
+    dest_meta->height = src_meta->height;
+    dest_meta->has_chunk_data = src_meta->has_chunk_data;
+    dest_meta->exposure_time = src_meta->exposure_time;
+    dest_meta->gain = src_meta->gain;
+
+    return TRUE;
+}
+
+const GstMetaInfo *gst_vimba_frame_meta_get_info(void)
+{
+    static const GstMetaInfo *meta_info = NULL;
+
+    if (g_once_init_enter((GstMetaInfo **)&meta_info))
+    {
+        const GstMetaInfo *info = gst_meta_register(GST_VIMBA_FRAME_META_API_TYPE,
+                                                    "GstVimbaFrameMeta",
+                                                    sizeof(GstVimbaFrameMeta),
+                                                    gst_vimba_frame_meta_init,
+                                                    NULL,
+                                                    gst_vimba_frame_meta_transform);
+        g_once_init_leave((GstMetaInfo **)&meta_info, (GstMetaInfo *)info);
+    }
+    return meta_info;
+}
+
+/**
+ * @brief Reads exposure time and gain from the chunk data sent with the frame
+ *
+ * @param frame_meta Meta in which the values are stored
+ * @param frame Filled frame. Must not be queued to Vimba while its chunk data is accessed
+ */
+static void read_chunk_data(GstVimbaFrameMeta *frame_meta, const VmbFrame_t *frame)
+{
+    VmbHandle_t chunk_data_handle;
+    if (VmbAncillaryDataOpen((VmbFrame_t *)frame, &chunk_data_handle) != VmbErrorSuccess)
+    {
+        return;
+    }
+
+    double exposure_time;
+    double gain;
+    if (VmbFeatureFloatGet(chunk_data_handle, "ChunkExposureTime", &exposure_time) == VmbErrorSuccess &&
+        VmbFeatureFloatGet(chunk_data_handle, "ChunkGain", &gain) == VmbErrorSuccess)
+    {
+        frame_meta->has_chunk_data = TRUE;
+        frame_meta->exposure_time = exposure_time;
+        frame_meta->gain = gain;
+    }
+    VmbAncillaryDataClose(chunk_data_handle);
+}
+
+/**
+ * @brief Attaches a GstVimbaFrameMeta describing the given frame to the buffer
+ *
+ * @param buffer Buffer holding the image data of the frame
+ * @param frame Filled frame. Must not be queued to Vimba again before this call returns
+ * @return GstVimbaFrameMeta* The attached meta
+ */
+GstVimbaFrameMeta *gst_buffer_add_vimba_frame_meta(GstBuffer *buffer, const VmbFrame_t *frame)
+{
+    g_return_val_if_fail(GST_IS_BUFFER(buffer), NULL);
+    g_return_val_if_fail(frame != NULL, NULL);
+
+    GstVimbaFrameMeta *frame_meta =
+        (GstVimbaFrameMeta *)gst_buffer_add_meta(buffer, GST_VIMBA_FRAME_META_INFO, NULL);
+
+    frame_meta->frame_id = frame->frameID;
+    frame_meta->timestamp = frame->timestamp;
+    frame_meta->receive_status = frame->receiveStatus;
+    frame_meta->image_size = frame->imageSize;
+    frame_meta->offset_x = frame->offsetX;
+    frame_meta->offset_y = frame->offsetY;
+    frame_meta->width = frame->width;
+    frame_meta->height = frame->height;
+    if (frame->ancillarySize > 0)
+    {
+        read_chunk_data(frame_meta, frame);
+    }
+
+    return frame_meta;
+}
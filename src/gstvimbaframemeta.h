@@ -0,0 +1,67 @@
+/* GStreamer
+ * Copyright (C) 2021 Allied Vision Technologies GmbH
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License version 2.0 as published by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifndef _GST_VIMBA_FRAME_META_H_
+#define _GST_VIMBA_FRAME_META_H_
+
+#include <gst/gst.h>
+
+#include <VimbaC/Include/VimbaC.h>
+
+G_BEGIN_DECLS
+
+// The API type is registered as "GstVimbaFrameMetaAPI". Applications that do not link against the plugin can find it
+// with g_type_from_name and read the meta with the struct definition below
+#define GST_VIMBA_FRAME_META_API_TYPE (gst_vimba_frame_meta_api_get_type())
+#define GST_VIMBA_FRAME_META_INFO (gst_vimba_frame_meta_get_info())
+
+#define gst_buffer_get_vimba_frame_meta(buffer) \
+    ((GstVimbaFrameMeta *)gst_buffer_get_meta((buffer), GST_VIMBA_FRAME_META_API_TYPE))
+
+// Information about the Vimba frame a buffer was created from
+typedef struct
+{
+    GstMeta meta;
+
+    guint64 frame_id;
+    // Timestamp assigned to the frame by the camera in camera ticks (see the GevTimestampTickFrequency feature)
+    guint64 timestamp;
+    // VmbFrameStatusType reported for the frame
+    gint receive_status;
+    // Size of the image data in bytes
+    guint32 image_size;
+    guint32 offset_x;
+    guint32 offset_y;
+    guint32 width;
+    guint32 height;
+
+    // Exposure time (in us) and gain (in dB) the frame was captured with. Only valid if has_chunk_data is set, which
+    // requires the camera to send chunk (ancillary) data with the frames
+    gboolean has_chunk_data;
+    gdouble exposure_time;
+    gdouble gain;
+} GstVimbaFrameMeta;
+
+GType gst_vimba_frame_meta_api_get_type(void);
+const GstMetaInfo *gst_vimba_frame_meta_get_info(void);
+
+GstVimbaFrameMeta *gst_buffer_add_vimba_frame_meta(GstBuffer *buffer, const VmbFrame_t *frame);
+
+G_END_DECLS
+
+#endif
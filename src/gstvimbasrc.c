@@ -30,9 +30,15 @@
  */
 
 #include "gstvimbasrc.h"
+#include "gstvimbaallocator.h"
+#include "gstvimbabufferpool.h"
+#include "gstvimbaframemeta.h"
+#include "framequeue.h"
 #include "helpers.h"
 #include "vimba_helpers.h"
 #include "pixelformats.h"
+#include "pixelunpack.h"
+#include "debayer.h"
 
 #ifdef HAVE_CONFIG_H
 #include "config.h"
@@ -45,6 +51,8 @@
 
 #include <VimbaC/Include/VimbaC.h>
 
+#include <string.h>
+
 // Counter variable to keep track of calls to VmbStartup() and VmbShutdown()
 static unsigned int vmb_open_count = 0;
 G_LOCK_DEFINE(vmb_open_count);
@@ -60,9 +68,14 @@ static void gst_vimbasrc_dispose(GObject *object);
 static void gst_vimbasrc_finalize(GObject *object);
 
 static GstCaps *gst_vimbasrc_get_caps(GstBaseSrc *src, GstCaps *filter);
+static GstCaps *gst_vimbasrc_fixate(GstBaseSrc *src, GstCaps *caps);
 static gboolean gst_vimbasrc_set_caps(GstBaseSrc *src, GstCaps *caps);
 static gboolean gst_vimbasrc_start(GstBaseSrc *src);
 static gboolean gst_vimbasrc_stop(GstBaseSrc *src);
+static gboolean gst_vimbasrc_decide_allocation(GstBaseSrc *src, GstQuery *query);
+static gboolean gst_vimbasrc_unlock(GstBaseSrc *src);
+static gboolean gst_vimbasrc_unlock_stop(GstBaseSrc *src);
+static gboolean gst_vimbasrc_query(GstBaseSrc *src, GstQuery *query);
 
 static GstFlowReturn gst_vimbasrc_create(GstPushSrc *src, GstBuffer **buf);
 
@@ -83,9 +96,62 @@ enum
     PROP_TRIGGERMODE,
     PROP_TRIGGERSOURCE,
     PROP_TRIGGERACTIVATION,
-    PROP_INCOMPLETE_FRAME_HANDLING
+    PROP_INCOMPLETE_FRAME_HANDLING,
+    PROP_TIMESTAMP_MODE,
+    PROP_LEAKY,
+    PROP_BIT_DEPTH_SCALING,
+    PROP_DEBAYER_METHOD,
+    PROP_DEBAYER_THREADS,
+    PROP_FORMAT_SELECTION,
+    PROP_ZEROCOPY,
+    PROP_NUM_FRAME_BUFFERS,
+    PROP_ADAPTIVE_FRAME_BUFFERS,
+    PROP_FRAME_BUFFER_MEMORY_LIMIT,
+    PROP_DELIVERED_FRAMES,
+    PROP_DROPPED_FRAMES,
+    PROP_INCOMPLETE_FRAMES,
+    PROP_STATS,
+    PROP_STATS_INTERVAL
 };
 
+// At least 1 / divisor of the announced frames (rounded up) must remain available to the camera for capturing when a
+// frame is passed downstream without copying. If fewer frames would remain, the image data is copied and the frame is
+// requeued immediately instead
+#define ZEROCOPY_MIN_QUEUED_FRAMES_DIVISOR 2
+
+// Number of consecutive frames for which at least numframebuffers frames need to remain queued before the adaptive mode
+// revokes one of the additionally announced frames again
+#define ADAPTIVE_SHRINK_IDLE_FRAMES 300
+
+// Upper limit for the number of frames announced to Vimba. The filled frame queue is sized to hold all announced frames
+#define MAX_NUM_FRAME_BUFFERS 1024
+
+// Latency changes are only posted if they exceed this fraction of the frame period (1 / divisor).
+// ExposureAuto=Continuous adjusts the exposure time for almost every frame, which would otherwise make the pipeline
+// reconfigure its latency each time
+#define LATENCY_CHANGE_FRAME_PERIOD_DIVISOR 4
+
+// Camera features whose value is used to determine the latency of the element. Changes to them are tracked with
+// invalidation callbacks. Not all cameras provide all of these features
+static const char *latency_features[] = {"ExposureTime",
+                                         "ExposureTimeAbs",
+                                         "AcquisitionFrameRate",
+                                         "AcquisitionFrameRateAbs",
+                                         "TriggerMode"};
+
+// Camera features the caps reported by get_caps are built from. The cached caps are invalidated if one of them changes.
+// Vimba also reports changes of the frame rate range, e.g. after the exposure time changed
+static const char *caps_features[] = {"Width",
+                                      "Height",
+                                      "AcquisitionFrameRate",
+                                      "AcquisitionFrameRateAbs",
+                                      "TriggerMode"};
+
+// Features reducing the resolution along each sensor axis, in the order they are preferred. Binning keeps the light of
+// all pixels while decimation skips pixels. Not all cameras provide these features
+static const char *horizontal_subsampling_features[] = {"BinningHorizontal", "DecimationHorizontal", NULL};
+static const char *vertical_subsampling_features[] = {"BinningVertical", "DecimationVertical", NULL};
+
 /* pad templates */
 static GstStaticPadTemplate gst_vimbasrc_src_template =
     GST_STATIC_PAD_TEMPLATE("src",
@@ -278,6 +344,94 @@ static GType gst_vimbasrc_incompleteframehandling_get_type(void)
     return vimbasrc_incompleteframehandling_type;
 }
 
+/* TimestampMode values */
+#define GST_ENUM_TIMESTAMPMODE_VALUES (gst_vimbasrc_timestampmode_get_type())
+static GType gst_vimbasrc_timestampmode_get_type(void)
+{
+    static GType vimbasrc_timestampmode_type = 0;
+    static const GEnumValue timestampmode_values[] = {
+        {GST_VIMBASRC_TIMESTAMP_MODE_PIPELINE, "Timestamp buffers with the pipeline running time at which they are pushed out of the element", "Pipeline"},
+        {GST_VIMBASRC_TIMESTAMP_MODE_CAMERA, "Timestamp buffers with the frame timestamp reported by the camera, mapped to the pipeline running time", "Camera"},
+        {0, NULL, NULL}};
+    if (!vimbasrc_timestampmode_type)
+    {
+        vimbasrc_timestampmode_type =
+            g_enum_register_static("GstVimbasrcTimestampModeValues", timestampmode_values);
+    }
+    return vimbasrc_timestampmode_type;
+}
+
+/* Leaky values */
+#define GST_ENUM_LEAKY_VALUES (gst_vimbasrc_leaky_get_type())
+static GType gst_vimbasrc_leaky_get_type(void)
+{
+    static GType vimbasrc_leaky_type = 0;
+    static const GEnumValue leaky_values[] = {
+        {GST_VIMBASRC_LEAKY_NONE, "Deliver all filled frames in the order they were captured", "None"},
+        {GST_VIMBASRC_LEAKY_UPSTREAM, "Drop newly filled frames while an older frame is still waiting to be delivered", "Upstream"},
+        {GST_VIMBASRC_LEAKY_DOWNSTREAM, "Always deliver the latest filled frame and drop older frames that were not delivered yet", "Downstream"},
+        {0, NULL, NULL}};
+    if (!vimbasrc_leaky_type)
+    {
+        vimbasrc_leaky_type =
+            g_enum_register_static("GstVimbasrcLeakyValues", leaky_values);
+    }
+    return vimbasrc_leaky_type;
+}
+
+/* BitDepthScaling values */
+#define GST_ENUM_BIT_DEPTH_SCALING_VALUES (gst_vimbasrc_bitdepthscaling_get_type())
+static GType gst_vimbasrc_bitdepthscaling_get_type(void)
+{
+    static GType vimbasrc_bitdepthscaling_type = 0;
+    static const GEnumValue bitdepthscaling_values[] = {
+        {GST_VIMBASRC_BIT_DEPTH_SCALING_NONE, "Keep the pixel values in the least significant bits", "None"},
+        {GST_VIMBASRC_BIT_DEPTH_SCALING_SHIFT, "Shift the pixel values into the most significant bits", "Shift"},
+        {GST_VIMBASRC_BIT_DEPTH_SCALING_SCALE, "Scale the pixel values to the full 16 bit range so that the maximum value becomes 65535", "Scale"},
+        {0, NULL, NULL}};
+    if (!vimbasrc_bitdepthscaling_type)
+    {
+        vimbasrc_bitdepthscaling_type =
+            g_enum_register_static("GstVimbasrcBitDepthScalingValues", bitdepthscaling_values);
+    }
+    return vimbasrc_bitdepthscaling_type;
+}
+
+/* DebayerMethod values */
+#define GST_ENUM_DEBAYER_METHOD_VALUES (gst_vimbasrc_debayermethod_get_type())
+static GType gst_vimbasrc_debayermethod_get_type(void)
+{
+    static GType vimbasrc_debayermethod_type = 0;
+    static const GEnumValue debayermethod_values[] = {
+        {GST_VIMBASRC_DEBAYER_METHOD_BILINEAR, "Average the nearest pixels of each missing colour", "Bilinear"},
+        {GST_VIMBASRC_DEBAYER_METHOD_EDGE_AWARE, "Interpolate missing green values along edges to avoid zipper artefacts", "EdgeAware"},
+        {0, NULL, NULL}};
+    if (!vimbasrc_debayermethod_type)
+    {
+        vimbasrc_debayermethod_type =
+            g_enum_register_static("GstVimbasrcDebayerMethodValues", debayermethod_values);
+    }
+    return vimbasrc_debayermethod_type;
+}
+
+/* FormatSelection values */
+#define GST_ENUM_FORMAT_SELECTION_VALUES (gst_vimbasrc_formatselection_get_type())
+static GType gst_vimbasrc_formatselection_get_type(void)
+{
+    static GType vimbasrc_formatselection_type = 0;
+    static const GEnumValue formatselection_values[] = {
+        {GST_VIMBASRC_FORMAT_SELECTION_FIRST, "Use the first matching format in the order the camera reports them", "First"},
+        {GST_VIMBASRC_FORMAT_SELECTION_SMALLEST_WIRE_SIZE, "Use the format with the most significant bits the link sustains at the frame rate, or the smallest one if the throughput is unknown", "SmallestWireSize"},
+        {GST_VIMBASRC_FORMAT_SELECTION_NO_CONVERSION, "Prefer formats the camera delivers without conversion in the element", "NoConversion"},
+        {0, NULL, NULL}};
+    if (!vimbasrc_formatselection_type)
+    {
+        vimbasrc_formatselection_type =
+            g_enum_register_static("GstVimbasrcFormatSelectionValues", formatselection_values);
+    }
+    return vimbasrc_formatselection_type;
+}
+
 /* class initialization */
 
 G_DEFINE_TYPE_WITH_CODE(GstVimbaSrc,
@@ -310,8 +464,13 @@ static void gst_vimbasrc_class_init(GstVimbaSrcClass *klass)
     gobject_class->finalize = gst_vimbasrc_finalize;
     base_src_class->get_caps = GST_DEBUG_FUNCPTR(gst_vimbasrc_get_caps);
     base_src_class->set_caps = GST_DEBUG_FUNCPTR(gst_vimbasrc_set_caps);
+    base_src_class->fixate = GST_DEBUG_FUNCPTR(gst_vimbasrc_fixate);
     base_src_class->start = GST_DEBUG_FUNCPTR(gst_vimbasrc_start);
     base_src_class->stop = GST_DEBUG_FUNCPTR(gst_vimbasrc_stop);
+    base_src_class->decide_allocation = GST_DEBUG_FUNCPTR(gst_vimbasrc_decide_allocation);
+    base_src_class->unlock = GST_DEBUG_FUNCPTR(gst_vimbasrc_unlock);
+    base_src_class->unlock_stop = GST_DEBUG_FUNCPTR(gst_vimbasrc_unlock_stop);
+    base_src_class->query = GST_DEBUG_FUNCPTR(gst_vimbasrc_query);
     push_src_class->create = GST_DEBUG_FUNCPTR(gst_vimbasrc_create);
 
     // Install properties
@@ -469,6 +628,160 @@ static void gst_vimbasrc_class_init(GstVimbaSrcClass *klass)
             GST_ENUM_INCOMPLETEFRAMEHANDLING_VALUES,
             GST_VIMBASRC_INCOMPLETE_FRAME_HANDLING_DROP,
             G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+    g_object_class_install_property(
+        gobject_class,
+        PROP_TIMESTAMP_MODE,
+        g_param_spec_enum(
+            "timestampmode",
+            "Timestamp mode",
+            "Determines how the timestamps of the output buffers are derived. \"Camera\" uses the timestamp the camera assigned to the frame and continuously estimates offset and drift between the camera clock and the pipeline clock. This removes the transport and scheduling delay jitter contained in \"Pipeline\" timestamps",
+            GST_ENUM_TIMESTAMPMODE_VALUES,
+            GST_VIMBASRC_TIMESTAMP_MODE_PIPELINE,
+            G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+    g_object_class_install_property(
+        gobject_class,
+        PROP_LEAKY,
+        g_param_spec_enum(
+            "leaky",
+            "Leaky",
+            "Determines which frames are dropped if downstream elements process frames slower than the camera delivers them. \"Downstream\" always delivers the latest frame, which bounds the latency to about one frame period",
+            GST_ENUM_LEAKY_VALUES,
+            GST_VIMBASRC_LEAKY_NONE,
+            G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+    g_object_class_install_property(
+        gobject_class,
+        PROP_BIT_DEPTH_SCALING,
+        g_param_spec_enum(
+            "bitdepthscaling",
+            "Bit depth scaling",
+            "Placement of the significant bits if 10, 12 or 14 bit pixel formats are output as GRAY16_LE. By default the values are kept in the least significant bits, which makes the image appear almost black in most viewers. \"Shift\" moves the values into the most significant bits, \"Scale\" additionally fills the least significant bits so that the maximum value becomes 65535",
+            GST_ENUM_BIT_DEPTH_SCALING_VALUES,
+            GST_VIMBASRC_BIT_DEPTH_SCALING_NONE,
+            G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+    g_object_class_install_property(
+        gobject_class,
+        PROP_DEBAYER_METHOD,
+        g_param_spec_enum(
+            "debayermethod",
+            "Debayer method",
+            "Interpolation used if a Bayer format of the camera is demosaiced into RGB, BGRx or GRAY8 in the element",
+            GST_ENUM_DEBAYER_METHOD_VALUES,
+            GST_VIMBASRC_DEBAYER_METHOD_BILINEAR,
+            G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+    g_object_class_install_property(
+        gobject_class,
+        PROP_DEBAYER_THREADS,
+        g_param_spec_uint(
+            "debayerthreads",
+            "Debayer threads",
+            "Number of threads demosaicing Bayer formats in the element, including the streaming thread. 0 uses one thread per CPU core. Changes are applied when the element is started the next time",
+            0,
+            G_MAXUINT16,
+            0,
+            G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+    g_object_class_install_property(
+        gobject_class,
+        PROP_FORMAT_SELECTION,
+        g_param_spec_enum(
+            "formatselection",
+            "Format selection",
+            "Determines which camera pixel format is used if several of them provide the negotiated format, e.g. Mono12, Mono12p and Mono12Packed for GRAY16_LE. \"SmallestWireSize\" compares the bandwidth each format needs at the frame rate with the link throughput of the camera and keeps as many significant bits as the link sustains",
+            GST_ENUM_FORMAT_SELECTION_VALUES,
+            GST_VIMBASRC_FORMAT_SELECTION_NO_CONVERSION,
+            G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+    g_object_class_install_property(
+        gobject_class,
+        PROP_ZEROCOPY,
+        g_param_spec_boolean(
+            "zerocopy",
+            "Zero-copy output",
+            "Pass the memory of received Vimba frames downstream without copying the image data. The frame is handed back to Vimba for capturing once the last reference to the buffer is dropped. If less than half of the frames would remain available for capturing, the image data is copied instead",
+            FALSE,
+            G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+    g_object_class_install_property(
+        gobject_class,
+        PROP_NUM_FRAME_BUFFERS,
+        g_param_spec_uint(
+            "numframebuffers",
+            "Number of frame buffers",
+            "Number of frames that are announced to Vimba for capturing. More frames allow the camera to continue capturing while downstream elements are temporarily slow, at the cost of memory. Changes are applied when the caps are negotiated the next time",
+            1,
+            MAX_NUM_FRAME_BUFFERS,
+            3,
+            G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+    g_object_class_install_property(
+        gobject_class,
+        PROP_ADAPTIVE_FRAME_BUFFERS,
+        g_param_spec_boolean(
+            "adaptiveframebuffers",
+            "Adaptive number of frame buffers",
+            "Announce additional frames while capturing whenever the camera runs out of queued frames and revoke them again once they are no longer needed. The number of frames never drops below numframebuffers and the memory of all frames is limited by framebuffermemorylimit",
+            FALSE,
+            G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+    g_object_class_install_property(
+        gobject_class,
+        PROP_FRAME_BUFFER_MEMORY_LIMIT,
+        g_param_spec_uint(
+            "framebuffermemorylimit",
+            "Frame buffer memory limit",
+            "Maximum amount of memory (in MiB) the announced frames may use if adaptiveframebuffers is enabled. At least numframebuffers frames are always announced. 0 means no memory limit, in which case at most 1024 frames are announced",
+            0,
+            G_MAXUINT,
+            256,
+            G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+    g_object_class_install_property(
+        gobject_class,
+        PROP_DELIVERED_FRAMES,
+        g_param_spec_uint64(
+            "deliveredframes",
+            "Delivered frames",
+            "Number of frames pushed downstream since the element was started",
+            0,
+            G_MAXUINT64,
+            0,
+            G_PARAM_READABLE | G_PARAM_STATIC_STRINGS));
+    g_object_class_install_property(
+        gobject_class,
+        PROP_DROPPED_FRAMES,
+        g_param_spec_uint64(
+            "droppedframes",
+            "Dropped frames",
+            "Number of frames lost since the element was started. Includes frames that never reached the element (detected by gaps in the frame IDs) and incomplete frames dropped due to \"incompleteframehandling\"",
+            0,
+            G_MAXUINT64,
+            0,
+            G_PARAM_READABLE | G_PARAM_STATIC_STRINGS));
+    g_object_class_install_property(
+        gobject_class,
+        PROP_INCOMPLETE_FRAMES,
+        g_param_spec_uint64(
+            "incompleteframes",
+            "Incomplete frames",
+            "Number of incomplete frames received since the element was started, regardless of whether they were dropped or submitted",
+            0,
+            G_MAXUINT64,
+            0,
+            G_PARAM_READABLE | G_PARAM_STATIC_STRINGS));
+    g_object_class_install_property(
+        gobject_class,
+        PROP_STATS,
+        g_param_spec_boxed(
+            "stats",
+            "Statistics",
+            "Statistics since the element was started: Frame counts, frame rate of the last second, current number of filled frames waiting to be pushed, time spent waiting for frames and a histogram of the time frames spent between being received and being pushed",
+            GST_TYPE_STRUCTURE,
+            G_PARAM_READABLE | G_PARAM_STATIC_STRINGS));
+    g_object_class_install_property(
+        gobject_class,
+        PROP_STATS_INTERVAL,
+        g_param_spec_uint(
+            "statsinterval",
+            "Statistics interval",
+            "Interval (in ms) in which the content of the \"stats\" property is posted as element message on the bus. 0 disables the messages",
+            0,
+            G_MAXUINT,
+            0,
+            G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
 }
 
 static void gst_vimbasrc_init(GstVimbaSrc *vimbasrc)
@@ -597,6 +910,70 @@ static void gst_vimbasrc_init(GstVimbaSrc *vimbasrc)
             g_object_class_find_property(
                 gobject_class,
                 "incompleteframehandling")));
+    vimbasrc->properties.timestamp_mode = g_value_get_enum(
+        g_param_spec_get_default_value(
+            g_object_class_find_property(
+                gobject_class,
+                "timestampmode")));
+    vimbasrc->properties.leaky = g_value_get_enum(
+        g_param_spec_get_default_value(
+            g_object_class_find_property(
+                gobject_class,
+                "leaky")));
+    vimbasrc->properties.bit_depth_scaling = g_value_get_enum(
+        g_param_spec_get_default_value(
+            g_object_class_find_property(
+                gobject_class,
+                "bitdepthscaling")));
+    vimbasrc->properties.debayer_method = g_value_get_enum(
+        g_param_spec_get_default_value(
+            g_object_class_find_property(
+                gobject_class,
+                "debayermethod")));
+    vimbasrc->properties.debayer_threads = g_value_get_uint(
+        g_param_spec_get_default_value(
+            g_object_class_find_property(
+                gobject_class,
+                "debayerthreads")));
+    vimbasrc->properties.format_selection = g_value_get_enum(
+        g_param_spec_get_default_value(
+            g_object_class_find_property(
+                gobject_class,
+                "formatselection")));
+    vimbasrc->properties.zerocopy = g_value_get_boolean(
+        g_param_spec_get_default_value(
+            g_object_class_find_property(
+                gobject_class,
+                "zerocopy")));
+    vimbasrc->properties.num_frame_buffers = g_value_get_uint(
+        g_param_spec_get_default_value(
+            g_object_class_find_property(
+                gobject_class,
+                "numframebuffers")));
+    vimbasrc->properties.adaptive_frame_buffers = g_value_get_boolean(
+        g_param_spec_get_default_value(
+            g_object_class_find_property(
+                gobject_class,
+                "adaptiveframebuffers")));
+    vimbasrc->properties.frame_buffer_memory_limit = g_value_get_uint(
+        g_param_spec_get_default_value(
+            g_object_class_find_property(
+                gobject_class,
+                "framebuffermemorylimit")));
+    vimbasrc->properties.stats_interval = g_value_get_uint(
+        g_param_spec_get_default_value(
+            g_object_class_find_property(
+                gobject_class,
+                "statsinterval")));
+
+    // Prepare queue for filled frames from which vimbasrc_create can take them
+    vimbasrc->filled_frame_queue = frame_queue_new(vimbasrc->properties.num_frame_buffers);
+
+    vimbasrc->latency.min = GST_CLOCK_TIME_NONE;
+    vimbasrc->latency.max = GST_CLOCK_TIME_NONE;
+
+    vimbasrc->roi.horizontal_factor = 1;
+    vimbasrc->roi.vertical_factor = 1;
 }
 
 void gst_vimbasrc_set_property(GObject *object, guint property_id, const GValue *value, GParamSpec *pspec)
@@ -623,27 +1000,55 @@ void gst_vimbasrc_set_property(GObject *object, guint property_id, const GValue
         break;
     case PROP_EXPOSURETIME:
         vimbasrc->properties.exposuretime = g_value_get_double(value);
+        // Features that can be changed while acquiring are written right away. Otherwise they are applied in start
+        if (vimbasrc->camera.is_connected)
+        {
+            apply_exposure_time(vimbasrc);
+        }
         break;
     case PROP_EXPOSUREAUTO:
         vimbasrc->properties.exposureauto = g_value_get_enum(value);
+        if (vimbasrc->camera.is_connected)
+        {
+            apply_auto_feature(vimbasrc,
+                               "ExposureAuto",
+                               GST_ENUM_EXPOSUREAUTO_MODES,
+                               vimbasrc->properties.exposureauto);
+        }
         break;
     case PROP_BALANCEWHITEAUTO:
         vimbasrc->properties.balancewhiteauto = g_value_get_enum(value);
+        if (vimbasrc->camera.is_connected)
+        {
+            apply_auto_feature(vimbasrc,
+                               "BalanceWhiteAuto",
+                               GST_ENUM_BALANCEWHITEAUTO_MODES,
+                               vimbasrc->properties.balancewhiteauto);
+        }
         break;
     case PROP_GAIN:
         vimbasrc->properties.gain = g_value_get_double(value);
+        if (vimbasrc->camera.is_connected)
+        {
+            apply_gain(vimbasrc);
+        }
         break;
     case PROP_OFFSETX:
         vimbasrc->properties.offsetx = g_value_get_int(value);
+        // Applied by the next create while acquiring. start and set_roi clear the flag when they apply the ROI anyway
+        g_atomic_int_set(&vimbasrc->roi_invalidated, 1);
         break;
     case PROP_OFFSETY:
         vimbasrc->properties.offsety = g_value_get_int(value);
+        g_atomic_int_set(&vimbasrc->roi_invalidated, 1);
         break;
     case PROP_WIDTH:
         vimbasrc->properties.width = g_value_get_int(value);
+        g_atomic_int_set(&vimbasrc->roi_invalidated, 1);
         break;
     case PROP_HEIGHT:
         vimbasrc->properties.height = g_value_get_int(value);
+        g_atomic_int_set(&vimbasrc->roi_invalidated, 1);
         break;
     case PROP_TRIGGERSELECTOR:
         vimbasrc->properties.triggerselector = g_value_get_enum(value);
@@ -660,6 +1065,44 @@ void gst_vimbasrc_set_property(GObject *object, guint property_id, const GValue
     case PROP_INCOMPLETE_FRAME_HANDLING:
         vimbasrc->properties.incomplete_frame_handling = g_value_get_enum(value);
         break;
+    case PROP_TIMESTAMP_MODE:
+        vimbasrc->properties.timestamp_mode = g_value_get_enum(value);
+        break;
+    case PROP_LEAKY:
+        vimbasrc->properties.leaky = g_value_get_enum(value);
+        // Frames are dropped in vimba_frame_callback once one filled frame is waiting to be delivered
+        frame_queue_set_max_length(vimbasrc->filled_frame_queue,
+                                   vimbasrc->properties.leaky == GST_VIMBASRC_LEAKY_UPSTREAM ? 1 : 0);
+        g_atomic_int_set(&vimbasrc->latency_invalidated, 1);
+        break;
+    case PROP_BIT_DEPTH_SCALING:
+        vimbasrc->properties.bit_depth_scaling = g_value_get_enum(value);
+        break;
+    case PROP_DEBAYER_METHOD:
+        vimbasrc->properties.debayer_method = g_value_get_enum(value);
+        break;
+    case PROP_DEBAYER_THREADS:
+        vimbasrc->properties.debayer_threads = g_value_get_uint(value);
+        break;
+    case PROP_FORMAT_SELECTION:
+        vimbasrc->properties.format_selection = g_value_get_enum(value);
+        break;
+    case PROP_ZEROCOPY:
+        vimbasrc->properties.zerocopy = g_value_get_boolean(value);
+        break;
+    case PROP_NUM_FRAME_BUFFERS:
+        vimbasrc->properties.num_frame_buffers = g_value_get_uint(value);
+        break;
+    case PROP_ADAPTIVE_FRAME_BUFFERS:
+        vimbasrc->properties.adaptive_frame_buffers = g_value_get_boolean(value);
+        break;
+    case PROP_FRAME_BUFFER_MEMORY_LIMIT:
+        vimbasrc->properties.frame_buffer_memory_limit = g_value_get_uint(value);
+        break;
+    case PROP_STATS_INTERVAL:
+        // Read by the streaming thread while it is running
+        g_atomic_int_set((gint *)&vimbasrc->properties.stats_interval, (gint)g_value_get_uint(value));
+        break;
     default:
         G_OBJECT_WARN_INVALID_PROPERTY_ID(object, property_id, pspec);
         break;
@@ -935,6 +1378,51 @@ void gst_vimbasrc_get_property(GObject *object, guint property_id, GValue *value
     case PROP_INCOMPLETE_FRAME_HANDLING:
         g_value_set_enum(value, vimbasrc->properties.incomplete_frame_handling);
         break;
+    case PROP_TIMESTAMP_MODE:
+        g_value_set_enum(value, vimbasrc->properties.timestamp_mode);
+        break;
+    case PROP_LEAKY:
+        g_value_set_enum(value, vimbasrc->properties.leaky);
+        break;
+    case PROP_BIT_DEPTH_SCALING:
+        g_value_set_enum(value, vimbasrc->properties.bit_depth_scaling);
+        break;
+    case PROP_DEBAYER_METHOD:
+        g_value_set_enum(value, vimbasrc->properties.debayer_method);
+        break;
+    case PROP_DEBAYER_THREADS:
+        g_value_set_uint(value, vimbasrc->properties.debayer_threads);
+        break;
+    case PROP_FORMAT_SELECTION:
+        g_value_set_enum(value, vimbasrc->properties.format_selection);
+        break;
+    case PROP_ZEROCOPY:
+        g_value_set_boolean(value, vimbasrc->properties.zerocopy);
+        break;
+    case PROP_NUM_FRAME_BUFFERS:
+        g_value_set_uint(value, vimbasrc->properties.num_frame_buffers);
+        break;
+    case PROP_ADAPTIVE_FRAME_BUFFERS:
+        g_value_set_boolean(value, vimbasrc->properties.adaptive_frame_buffers);
+        break;
+    case PROP_FRAME_BUFFER_MEMORY_LIMIT:
+        g_value_set_uint(value, vimbasrc->properties.frame_buffer_memory_limit);
+        break;
+    case PROP_DELIVERED_FRAMES:
+        g_value_set_uint64(value, frame_stats_get(&vimbasrc->stats.delivered_count));
+        break;
+    case PROP_DROPPED_FRAMES:
+        g_value_set_uint64(value, frame_stats_get(&vimbasrc->stats.dropped_count));
+        break;
+    case PROP_INCOMPLETE_FRAMES:
+        g_value_set_uint64(value, frame_stats_get(&vimbasrc->stats.incomplete_count));
+        break;
+    case PROP_STATS:
+        g_value_take_boxed(value, create_stats_structure(vimbasrc));
+        break;
+    case PROP_STATS_INTERVAL:
+        g_value_set_uint(value, (guint)g_atomic_int_get((gint *)&vimbasrc->properties.stats_interval));
+        break;
     default:
         G_OBJECT_WARN_INVALID_PROPERTY_ID(object, property_id, pspec);
         break;
@@ -958,8 +1446,29 @@ void gst_vimbasrc_finalize(GObject *object)
 
     GST_TRACE_OBJECT(vimbasrc, "finalize");
 
+    if (vimbasrc->allocator != NULL)
+    {
+        // Frames must be revoked while the camera is still open. Memory still used downstream is freed on release
+        gst_vimba_allocator_revoke_all(GST_VIMBA_ALLOCATOR(vimbasrc->allocator));
+    }
+    gst_clear_object(&vimbasrc->pool);
+    gst_clear_object(&vimbasrc->output_pool);
+    gst_clear_object(&vimbasrc->allocator);
+    g_clear_pointer(&vimbasrc->debayer, debayer_free);
+    gst_caps_replace(&vimbasrc->camera_caps, NULL);
+
     if (vimbasrc->camera.is_connected)
     {
+        for (size_t i = 0; i < G_N_ELEMENTS(latency_features); i++)
+        {
+            VmbFeatureInvalidationUnregister(vimbasrc->camera.handle,
+                                             latency_features[i],
+                                             &latency_feature_invalidated);
+        }
+        for (size_t i = 0; i < G_N_ELEMENTS(caps_features); i++)
+        {
+            VmbFeatureInvalidationUnregister(vimbasrc->camera.handle, caps_features[i], &caps_feature_invalidated);
+        }
         VmbError_t result = VmbCameraClose(vimbasrc->camera.handle);
         if (result == VmbErrorSuccess)
         {
@@ -987,90 +1496,95 @@ void gst_vimbasrc_finalize(GObject *object)
     }
     G_UNLOCK(vmb_open_count);
 
+    frame_queue_free(vimbasrc->filled_frame_queue);
+    g_free(vimbasrc->camera.supported_formats);
+
     G_OBJECT_CLASS(gst_vimbasrc_parent_class)->finalize(object);
 }
 
 /* get caps from subclass */
 static GstCaps *gst_vimbasrc_get_caps(GstBaseSrc *src, GstCaps *filter)
 {
-    UNUSED(filter); // enable compilation while treating warning of unused vairable as error
     GstVimbaSrc *vimbasrc = GST_vimbasrc(src);
 
     GST_TRACE_OBJECT(vimbasrc, "get_caps");
 
-    GstCaps *caps;
-    caps = gst_pad_get_pad_template_caps(GST_BASE_SRC_PAD(src));
-    caps = gst_caps_make_writable(caps);
-
-    // Query the capabilities from the camera and return sensible values. If no camera is connected the template caps
-    // are returned
-    if (vimbasrc->camera.is_connected)
+    // The caps are only queried from the camera again once one of the caps_features changed
+    GstCaps *caps = NULL;
+    GST_OBJECT_LOCK(vimbasrc);
+    if (g_atomic_int_compare_and_exchange(&vimbasrc->caps_invalidated, 1, 0))
     {
-        VmbInt64_t vmb_width, vmb_height;
-
-        VmbFeatureIntGet(vimbasrc->camera.handle, "Width", &vmb_width);
-        VmbFeatureIntGet(vimbasrc->camera.handle, "Height", &vmb_height);
-
-        GValue width = G_VALUE_INIT;
-        GValue height = G_VALUE_INIT;
-
-        g_value_init(&width, G_TYPE_INT);
-        g_value_init(&height, G_TYPE_INT);
-
-        g_value_set_int(&width, (gint)vmb_width);
-
-        g_value_set_int(&height, (gint)vmb_height);
+        gst_caps_replace(&vimbasrc->camera_caps, NULL);
+    }
+    if (vimbasrc->camera_caps != NULL)
+    {
+        caps = gst_caps_ref(vimbasrc->camera_caps);
+    }
+    GST_OBJECT_UNLOCK(vimbasrc);
 
-        GstStructure *raw_caps = gst_caps_get_structure(caps, 0);
-        GstStructure *bayer_caps = gst_caps_get_structure(caps, 1);
+    if (caps == NULL)
+    {
+        caps = query_camera_caps(vimbasrc);
+        // The template caps returned without a camera are not cached so the camera is queried once it is connected
+        if (vimbasrc->camera.is_connected)
+        {
+            GST_OBJECT_LOCK(vimbasrc);
+            gst_caps_replace(&vimbasrc->camera_caps, caps);
+            GST_OBJECT_UNLOCK(vimbasrc);
+        }
+    }
 
-        gst_structure_set_value(raw_caps, "width", &width);
-        gst_structure_set_value(raw_caps, "height", &height);
-        gst_structure_set(raw_caps,
-                          // TODO: Check if framerate should also be gotten from camera (e.g. as max-framerate here)
-                          // Mark the framerate as variable because triggering might cause variable framerate
-                          "framerate", GST_TYPE_FRACTION, 0, 1,
-                          NULL);
+    if (filter != NULL)
+    {
+        GstCaps *intersection = gst_caps_intersect_full(filter, caps, GST_CAPS_INTERSECT_FIRST);
+        gst_caps_unref(caps);
+        caps = intersection;
+    }
 
-        gst_structure_set_value(bayer_caps, "width", &width);
-        gst_structure_set_value(bayer_caps, "height", &height);
-        gst_structure_set(bayer_caps,
-                          // TODO: Check if framerate should also be gotten from camera (e.g. as max-framerate here)
-                          // Mark the framerate as variable because triggering might cause variable framerate
-                          "framerate", GST_TYPE_FRACTION, 0, 1,
-                          NULL);
+    GST_DEBUG_OBJECT(vimbasrc, "returning caps: %" GST_PTR_FORMAT, caps);
 
-        // Query supported pixel formats from camera and map them to GStreamer formats
-        GValue pixel_format_raw_list = G_VALUE_INIT;
-        g_value_init(&pixel_format_raw_list, GST_TYPE_LIST);
+    return caps;
+}
 
-        GValue pixel_format_bayer_list = G_VALUE_INIT;
-        g_value_init(&pixel_format_bayer_list, GST_TYPE_LIST);
+/* fixate the caps, keeping the current frame rate of the camera if downstream accepts it */
+static GstCaps *gst_vimbasrc_fixate(GstBaseSrc *src, GstCaps *caps)
+{
+    GstVimbaSrc *vimbasrc = GST_vimbasrc(src);
 
-        GValue pixel_format = G_VALUE_INIT;
-        g_value_init(&pixel_format, G_TYPE_STRING);
+    GST_TRACE_OBJECT(vimbasrc, "fixate");
 
-        // Add all supported GStreamer format string to the reported caps
-        for (unsigned int i = 0; i < vimbasrc->camera.supported_formats_count; i++)
+    // The default fixation would choose the smallest size of the advertised ranges instead of the full ROI
+    if (vimbasrc->camera.is_connected && vimbasrc->roi.width > 0 && vimbasrc->roi.height > 0)
+    {
+        caps = gst_caps_make_writable(caps);
+        for (guint i = 0; i < gst_caps_get_size(caps); i++)
         {
-            g_value_set_static_string(&pixel_format, vimbasrc->camera.supported_formats[i]->gst_format_name);
-            // TODO: Should this perhaps be done via a flag in vimba_gst_format_matches?
-            if (starts_with(vimbasrc->camera.supported_formats[i]->vimba_format_name, "Bayer"))
-            {
-                gst_value_list_append_value(&pixel_format_bayer_list, &pixel_format);
-            }
-            else
-            {
-                gst_value_list_append_value(&pixel_format_raw_list, &pixel_format);
-            }
+            GstStructure *structure = gst_caps_get_structure(caps, i);
+            gst_structure_fixate_field_nearest_int(structure, "width", (int)vimbasrc->roi.width);
+            gst_structure_fixate_field_nearest_int(structure, "height", (int)vimbasrc->roi.height);
         }
-        gst_structure_set_value(raw_caps, "format", &pixel_format_raw_list);
-        gst_structure_set_value(bayer_caps, "format", &pixel_format_bayer_list);
     }
 
-    GST_DEBUG_OBJECT(vimbasrc, "returning caps: %s", gst_caps_to_string(caps));
+    // The default fixation would choose the lowest frame rate of the advertised range
+    double frame_rate = 0.;
+    if (vimbasrc->camera.is_connected &&
+        (VmbFeatureFloatGet(vimbasrc->camera.handle, "AcquisitionFrameRate", &frame_rate) == VmbErrorSuccess ||
+         VmbFeatureFloatGet(vimbasrc->camera.handle, "AcquisitionFrameRateAbs", &frame_rate) == VmbErrorSuccess) &&
+        frame_rate > 0.)
+    {
+        int framerate_numerator, framerate_denominator;
+        gst_util_double_to_fraction(frame_rate, &framerate_numerator, &framerate_denominator);
+        caps = gst_caps_make_writable(caps);
+        for (guint i = 0; i < gst_caps_get_size(caps); i++)
+        {
+            gst_structure_fixate_field_nearest_fraction(gst_caps_get_structure(caps, i),
+                                                        "framerate",
+                                                        framerate_numerator,
+                                                        framerate_denominator);
+        }
+    }
 
-    return caps;
+    return GST_BASE_SRC_CLASS(gst_vimbasrc_parent_class)->fixate(src, caps);
 }
 
 /* notify the subclass of new caps */
@@ -1080,7 +1594,7 @@ static gboolean gst_vimbasrc_set_caps(GstBaseSrc *src, GstCaps *caps)
 
     GST_TRACE_OBJECT(vimbasrc, "set_caps");
 
-    GST_DEBUG_OBJECT(vimbasrc, "caps requested to be set: %s", gst_caps_to_string(caps));
+    GST_DEBUG_OBJECT(vimbasrc, "caps requested to be set: %" GST_PTR_FORMAT, caps);
 
     // TODO: save to assume that "format" is always exactly one format and not a list? gst_caps_is_fixed might otherwise
     // be a good check and gst_caps_normalize could help make sure of it
@@ -1091,17 +1605,8 @@ static gboolean gst_vimbasrc_set_caps(GstBaseSrc *src, GstCaps *caps)
                      "Looking for matching vimba pixel format to GSreamer format \"%s\"",
                      gst_format);
 
-    const char *vimba_format = NULL;
-    for (unsigned int i = 0; i < vimbasrc->camera.supported_formats_count; i++)
-    {
-        if (strcmp(gst_format, vimbasrc->camera.supported_formats[i]->gst_format_name) == 0)
-        {
-            vimba_format = vimbasrc->camera.supported_formats[i]->vimba_format_name;
-            GST_DEBUG_OBJECT(vimbasrc, "Found matching vimba pixel format \"%s\"", vimba_format);
-            break;
-        }
-    }
-    if (vimba_format == NULL)
+    const VimbaGstFormatMatch_t *format_match = select_format_match(vimbasrc, structure);
+    if (format_match == NULL)
     {
         GST_ERROR_OBJECT(vimbasrc,
                          "Could not find a matching vimba pixel format for GStreamer format \"%s\"",
@@ -1111,43 +1616,96 @@ static gboolean gst_vimbasrc_set_caps(GstBaseSrc *src, GstCaps *caps)
 
     // Apply the requested caps to appropriate camera settings
     VmbError_t result;
-    // Changing the pixel format can not be done while images are acquired
-    result = stop_image_acquisition(vimbasrc);
-
-    result = VmbFeatureEnumSet(vimbasrc->camera.handle,
-                               "PixelFormat",
-                               vimba_format);
-    if (result != VmbErrorSuccess)
-    {
-        GST_ERROR_OBJECT(vimbasrc,
-                         "Could not set \"PixelFormat\" to \"%s\". Got return code \"%s\"",
-                         vimba_format,
-                         ErrorCodeToMessage(result));
-        return FALSE;
-    }
-
-    // width and height are always the value that is already written on the camera because get_caps only reports that
-    // value. Setting it here is not necessary as the feature values are controlled via properties of the element.
-
-    // Buffer size needs to be increased if the new payload size is greater than the old one because that means the
-    // previously allocated buffers are not large enough. We simply check the size of the first buffer because they were
-    // all allocated with the same size
-    VmbInt64_t new_payload_size;
-    result = VmbFeatureIntGet(vimbasrc->camera.handle, "PayloadSize", &new_payload_size);
-    if (vimbasrc->frame_buffers[0].bufferSize < new_payload_size || result != VmbErrorSuccess)
+    // Changing the pixel format can not be done while images are acquired. If only the size changes, the frames stay
+    // queued to the capture engine since the pool buffers fit the largest ROI
+    if (vimbasrc->conversion.format_match != NULL &&
+        vimbasrc->conversion.format_match->vimba_format == format_match->vimba_format)
     {
-        // Also reallocate buffers if PayloadSize could not be read because it might have increased
-        GST_DEBUG_OBJECT(vimbasrc,
-                         "PayloadSize increased. Reallocating frame buffers to ensure enough space");
-        revoke_and_free_buffers(vimbasrc);
-        result = alloc_and_announce_buffers(vimbasrc);
+        if (vimbasrc->camera.is_acquiring)
+        {
+            result = pause_image_acquisition(vimbasrc);
+            if (result != VmbErrorSuccess)
+            {
+                GST_ERROR_OBJECT(vimbasrc,
+                                 "Could not pause the acquisition to apply the new caps. Got return code \"%s\"",
+                                 ErrorCodeToMessage(result));
+                return FALSE;
+            }
+        }
     }
-    if (result == VmbErrorSuccess)
+    else
     {
-        result = start_image_acquisition(vimbasrc);
+        if (vimbasrc->camera.is_capturing || vimbasrc->camera.is_acquiring)
+        {
+            result = stop_image_acquisition(vimbasrc);
+            if (result != VmbErrorSuccess)
+            {
+                GST_ERROR_OBJECT(vimbasrc,
+                                 "Could not stop the acquisition to change the pixel format. Got return code \"%s\"",
+                                 ErrorCodeToMessage(result));
+                return FALSE;
+            }
+        }
+
+        result = VmbFeatureEnumSet(vimbasrc->camera.handle,
+                                   "PixelFormat",
+                                   format_match->vimba_format->name);
+        if (result != VmbErrorSuccess)
+        {
+            GST_ERROR_OBJECT(vimbasrc,
+                             "Could not set \"PixelFormat\" to \"%s\". Got return code \"%s\"",
+                             format_match->vimba_format->name,
+                             ErrorCodeToMessage(result));
+            return FALSE;
+        }
     }
 
-    return result == VmbErrorSuccess ? TRUE : FALSE;
+    // Packed, Bayer and YUV formats are converted in create if the negotiated format requires it
+    vimbasrc->conversion.format_match = format_match;
+    // Only GRAY16_LE pixels with less than 16 significant bits are affected by bitdepthscaling
+    const VimbaFormatInfo_t *vimba_format = format_match->vimba_format;
+    vimbasrc->conversion.scaled_bit_depth =
+        format_match->gst_format->video_format == GST_VIDEO_FORMAT_GRAY16_LE && vimba_format->bit_depth < 16
+            ? vimba_format->bit_depth
+            : 0;
+
+    // Triggered cameras report the variable frame rate 0/1, which leaves the camera settings unchanged
+    int framerate_numerator = 0, framerate_denominator = 0;
+    if (gst_structure_get_fraction(structure, "framerate", &framerate_numerator, &framerate_denominator) &&
+        framerate_numerator > 0 && framerate_denominator > 0)
+    {
+        result = set_frame_rate(vimbasrc, (double)framerate_numerator / framerate_denominator);
+        if (result != VmbErrorSuccess)
+        {
+            GST_ERROR_OBJECT(vimbasrc,
+                             "Could not set the frame rate to %d/%d. Got return code \"%s\"",
+                             framerate_numerator,
+                             framerate_denominator,
+                             ErrorCodeToMessage(result));
+            return FALSE;
+        }
+    }
+
+    // Sizes smaller than the ROI of the width and height properties are produced on the camera
+    int width = 0, height = 0;
+    if (gst_structure_get_int(structure, "width", &width) && gst_structure_get_int(structure, "height", &height))
+    {
+        result = set_output_size(vimbasrc, width, height);
+        if (result != VmbErrorSuccess)
+        {
+            GST_ERROR_OBJECT(vimbasrc,
+                             "Could not reduce the ROI to %d x %d pixels. Got return code \"%s\"",
+                             width,
+                             height,
+                             ErrorCodeToMessage(result));
+            return FALSE;
+        }
+    }
+    vimbasrc->conversion.width = (guint)width;
+    vimbasrc->conversion.height = (guint)height;
+
+    // The acquisition is restarted in decide_allocation (or apply_roi_change) once the frames fit the new PayloadSize
+    return TRUE;
 }
 
 /* start and stop processing, ideal for opening/closing the resource */
@@ -1157,9 +1715,6 @@ static gboolean gst_vimbasrc_start(GstBaseSrc *src)
 
     GST_TRACE_OBJECT(vimbasrc, "start");
 
-    // Prepare queue for filled frames from which vimbasrc_create can take them
-    vimbasrc->filled_frame_queue = g_async_queue_new();
-
     VmbError_t result;
 
     // TODO: Error handling
@@ -1173,6 +1728,9 @@ static gboolean gst_vimbasrc_start(GstBaseSrc *src)
         }
     }
 
+    // ROI changes made while the acquisition was stopped are applied with the other properties below
+    g_atomic_int_set(&vimbasrc->roi_invalidated, 0);
+
     // Load settings from given file if a path was given (settings_file_path is not empty)
     if (strcmp(vimbasrc->properties.settings_file_path, "") != 0)
     {
@@ -1198,41 +1756,260 @@ static gboolean gst_vimbasrc_start(GstBaseSrc *src)
         result = apply_feature_settings(vimbasrc);
     }
 
-    result = alloc_and_announce_buffers(vimbasrc);
-    if (result == VmbErrorSuccess)
+    query_timestamp_frequency(vimbasrc);
+    timestamp_mapping_reset(&vimbasrc->timestamp_mapping);
+    update_latency(vimbasrc);
+
+    frame_stats_reset(&vimbasrc->stats);
+    vimbasrc->stats_window.start = gst_util_get_timestamp();
+    vimbasrc->stats_window.delivered_count = 0;
+    vimbasrc->last_stats_message = vimbasrc->stats_window.start;
+
+    // Frame memory is allocated and the acquisition is started in decide_allocation once the caps are negotiated
+    gst_base_src_start_complete(src, GST_FLOW_OK);
+
+    return TRUE;
+}
+
+static gboolean gst_vimbasrc_stop(GstBaseSrc *src)
+{
+    GstVimbaSrc *vimbasrc = GST_vimbasrc(src);
+
+    GST_TRACE_OBJECT(vimbasrc, "stop");
+
+    stop_image_acquisition(vimbasrc);
+
+    // Recreated with the current debayerthreads setting once demosaicing is needed again
+    g_clear_pointer(&vimbasrc->debayer, debayer_free);
+    // A settings file loaded on the next start may change the pixel format, so set_caps writes it again
+    vimbasrc->conversion.format_match = NULL;
+    if (vimbasrc->output_pool != NULL)
     {
-        result = start_image_acquisition(vimbasrc);
+        gst_buffer_pool_set_active(vimbasrc->output_pool, FALSE);
+        gst_clear_object(&vimbasrc->output_pool);
     }
 
-    // Is this necessary?
-    if (result == VmbErrorSuccess)
+    // The announced frame memory stays cached in the allocator until the camera is closed so that restarting the
+    // pipeline does not need to announce new frames
+
+    return TRUE;
+}
+
+/* unlock any pending access to the resource. subclasses should unlock any function ASAP. */
+static gboolean gst_vimbasrc_unlock(GstBaseSrc *src)
+{
+    GstVimbaSrc *vimbasrc = GST_vimbasrc(src);
+
+    GST_TRACE_OBJECT(vimbasrc, "unlock");
+
+    // Wakes up create if it is waiting for a filled frame
+    frame_queue_set_flushing(vimbasrc->filled_frame_queue, true);
+
+    return TRUE;
+}
+
+/* Clear any pending unlock request, as we succeeded in unlocking */
+static gboolean gst_vimbasrc_unlock_stop(GstBaseSrc *src)
+{
+    GstVimbaSrc *vimbasrc = GST_vimbasrc(src);
+
+    GST_TRACE_OBJECT(vimbasrc, "unlock_stop");
+
+    frame_queue_set_flushing(vimbasrc->filled_frame_queue, false);
+
+    return TRUE;
+}
+
+/* setup allocation query */
+static gboolean gst_vimbasrc_decide_allocation(GstBaseSrc *src, GstQuery *query)
+{
+    GstVimbaSrc *vimbasrc = GST_vimbasrc(src);
+
+    GST_TRACE_OBJECT(vimbasrc, "decide_allocation");
+
+    VmbInt64_t payload_size;
+    VmbError_t result = VmbFeatureIntGet(vimbasrc->camera.handle, "PayloadSize", &payload_size);
+    if (result != VmbErrorSuccess)
+    {
+        GST_ERROR_OBJECT(vimbasrc, "Could not read \"PayloadSize\". Got error code: %s", ErrorCodeToMessage(result));
+        return FALSE;
+    }
+    GST_DEBUG_OBJECT(vimbasrc, "Got \"PayloadSize\" of: %lld", payload_size);
+
+    GstCaps *caps;
+    gst_query_parse_allocation(query, &caps, NULL);
+
+    // PayloadSize may exceed the image data if the camera appends chunk data, but frames smaller than the negotiated
+    // image could not be output (the camera did not apply the negotiated size or format)
+    int width = 0, height = 0;
+    if (vimbasrc->conversion.format_match != NULL && caps != NULL && gst_caps_get_size(caps) > 0 &&
+        gst_structure_get_int(gst_caps_get_structure(caps, 0), "width", &width) &&
+        gst_structure_get_int(gst_caps_get_structure(caps, 0), "height", &height))
+    {
+        gsize image_size = vimba_format_payload_size(vimbasrc->conversion.format_match->vimba_format,
+                                                     (guint)width,
+                                                     (guint)height);
+        if ((gsize)payload_size < image_size)
+        {
+            GST_ERROR_OBJECT(vimbasrc,
+                             "\"PayloadSize\" of %lld bytes is smaller than the %" G_GSIZE_FORMAT " bytes of a %d x %d image of format \"%s\"",
+                             payload_size,
+                             image_size,
+                             width,
+                             height,
+                             vimbasrc->conversion.format_match->vimba_format->name);
+            return FALSE;
+        }
+    }
+
+    // The frames stay queued to the capture engine while it is checked whether the current pool still fits
+    if (vimbasrc->camera.is_acquiring)
+    {
+        pause_image_acquisition(vimbasrc);
+    }
+    vimbasrc->payload_size = (gsize)payload_size;
+    // The buffers are sized for the largest ROI so that the ROI can be changed while playing without a new pool
+    gsize pool_payload_size = query_max_payload_size(vimbasrc, payload_size);
+
+    // In adaptive mode the pool may grow up to the memory limit while capturing
+    guint min_buffers = vimbasrc->properties.num_frame_buffers;
+    guint max_buffers = min_buffers;
+    if (vimbasrc->properties.adaptive_frame_buffers)
+    {
+        max_buffers = MAX_NUM_FRAME_BUFFERS;
+        if (vimbasrc->properties.frame_buffer_memory_limit > 0)
+        {
+            guint64 limit_frames = (guint64)vimbasrc->properties.frame_buffer_memory_limit * 1024 * 1024 /
+                                   (guint64)pool_payload_size;
+            max_buffers = (guint)MIN(limit_frames, MAX_NUM_FRAME_BUFFERS);
+            if (max_buffers < min_buffers)
+            {
+                GST_WARNING_OBJECT(vimbasrc,
+                                   "\"framebuffermemorylimit\" of %u MiB is too small for %u frames of %" G_GSIZE_FORMAT " bytes. Not announcing additional frames",
+                                   vimbasrc->properties.frame_buffer_memory_limit,
+                                   min_buffers,
+                                   pool_payload_size);
+                max_buffers = min_buffers;
+            }
+        }
+    }
+
+    // Keep the current pool if its buffers are large enough. The caps of the pool are not compared since the frame
+    // memory does not depend on them, so a changed size is negotiated without queueing the frames again. A pool can not
+    // be reconfigured while buffers of it are still used downstream, so a new pool is created otherwise. The announced
+    // frame memory is reused by the allocator either way
+    if (vimbasrc->pool != NULL)
+    {
+        GstStructure *config = gst_buffer_pool_get_config(vimbasrc->pool);
+        guint pool_size, pool_min_buffers, pool_max_buffers;
+        gst_buffer_pool_config_get_params(config, NULL, &pool_size, &pool_min_buffers, &pool_max_buffers);
+        gboolean is_reusable = pool_size >= pool_payload_size && pool_min_buffers == min_buffers &&
+                               pool_max_buffers == max_buffers;
+        gst_structure_free(config);
+        if (!is_reusable)
+        {
+            // The frames of the current pool may not be used for capturing while the pool is changed
+            if (vimbasrc->camera.is_capturing)
+            {
+                stop_image_acquisition(vimbasrc);
+            }
+            gst_buffer_pool_set_active(vimbasrc->pool, FALSE);
+            gst_clear_object(&vimbasrc->pool);
+        }
+    }
+    if (vimbasrc->pool == NULL)
     {
-        gst_base_src_start_complete(src, GST_FLOW_OK);
+        GST_DEBUG_OBJECT(vimbasrc,
+                         "Creating buffer pool with %u vimba frames (at most %u)",
+                         min_buffers,
+                         max_buffers);
+        vimbasrc->pool = gst_vimba_buffer_pool_new(vimbasrc->camera.handle,
+                                                   &vimba_frame_callback,
+                                                   vimbasrc->filled_frame_queue);
+        GstStructure *config = gst_buffer_pool_get_config(vimbasrc->pool);
+        gst_buffer_pool_config_set_params(config, caps, (guint)pool_payload_size, min_buffers, max_buffers);
+        gst_buffer_pool_config_set_allocator(config, vimbasrc->allocator, NULL);
+        if (!gst_buffer_pool_set_config(vimbasrc->pool, config))
+        {
+            GST_ERROR_OBJECT(vimbasrc, "Could not configure buffer pool");
+            gst_clear_object(&vimbasrc->pool);
+            return FALSE;
+        }
+    }
+    // The queue can only be resized while it is not used by the frame callback. A reused pool has the same number of
+    // frames, so the queue is already large enough if capturing continues
+    if (!vimbasrc->camera.is_capturing)
+    {
+        frame_queue_reserve(vimbasrc->filled_frame_queue, MAX(min_buffers, max_buffers));
+    }
+
+    if (!gst_buffer_pool_set_active(vimbasrc->pool, TRUE))
+    {
+        GST_ERROR_OBJECT(vimbasrc, "Could not allocate %u vimba frames", min_buffers);
+        return FALSE;
+    }
+
+    // Always use our own pool. Buffers of other pools can not be filled by the camera
+    if (gst_query_get_n_allocation_pools(query) > 0)
+    {
+        gst_query_set_nth_allocation_pool(query,
+                                          0,
+                                          vimbasrc->pool,
+                                          (guint)pool_payload_size,
+                                          min_buffers,
+                                          max_buffers);
     }
     else
+    {
+        gst_query_add_allocation_pool(query,
+                                      vimbasrc->pool,
+                                      (guint)pool_payload_size,
+                                      min_buffers,
+                                      max_buffers);
+    }
+
+    if (!setup_output_pool(vimbasrc))
+    {
+        return FALSE;
+    }
+
+    vimbasrc->idle_frame_count = 0;
+    result = start_image_acquisition(vimbasrc);
+    if (result != VmbErrorSuccess)
     {
         GST_ERROR_OBJECT(vimbasrc, "Could not start acquisition. Experienced error: %s", ErrorCodeToMessage(result));
-        gst_base_src_start_complete(src, GST_FLOW_ERROR);
+        return FALSE;
     }
 
-    // TODO: Is this enough error handling?
-    return result == VmbErrorSuccess ? TRUE : FALSE;
+    // The maximum latency depends on the number of frames in the new pool
+    update_latency(vimbasrc);
+
+    return TRUE;
 }
 
-static gboolean gst_vimbasrc_stop(GstBaseSrc *src)
+static gboolean gst_vimbasrc_query(GstBaseSrc *src, GstQuery *query)
 {
     GstVimbaSrc *vimbasrc = GST_vimbasrc(src);
 
-    GST_TRACE_OBJECT(vimbasrc, "stop");
-
-    stop_image_acquisition(vimbasrc);
-
-    revoke_and_free_buffers(vimbasrc);
+    if (GST_QUERY_TYPE(query) == GST_QUERY_LATENCY)
+    {
+        GST_OBJECT_LOCK(vimbasrc);
+        GstClockTime min_latency = vimbasrc->latency.min;
+        GstClockTime max_latency = vimbasrc->latency.max;
+        GST_OBJECT_UNLOCK(vimbasrc);
 
-    // Unref the filled frame queue so it is deleted properly
-    g_async_queue_unref(vimbasrc->filled_frame_queue);
+        if (GST_CLOCK_TIME_IS_VALID(min_latency))
+        {
+            GST_DEBUG_OBJECT(vimbasrc,
+                             "Reporting latency min %" GST_TIME_FORMAT " max %" GST_TIME_FORMAT,
+                             GST_TIME_ARGS(min_latency),
+                             GST_TIME_ARGS(max_latency));
+            gst_query_set_latency(query, TRUE, min_latency, max_latency);
+            return TRUE;
+        }
+    }
 
-    return TRUE;
+    return GST_BASE_SRC_CLASS(gst_vimbasrc_parent_class)->query(src, query);
 }
 
 /* ask the subclass to create a buffer */
@@ -1242,35 +2019,67 @@ static GstFlowReturn gst_vimbasrc_create(GstPushSrc *src, GstBuffer **buf)
 
     GST_TRACE_OBJECT(vimbasrc, "create");
 
+    // ROI properties changed while playing are applied here so the caps can be renegotiated from the streaming thread
+    if (g_atomic_int_compare_and_exchange(&vimbasrc->roi_invalidated, 1, 0) && !apply_roi_change(vimbasrc))
+    {
+        GST_ELEMENT_ERROR(vimbasrc, CORE, NEGOTIATION, ("Could not apply the changed ROI while playing"), (NULL));
+        return GST_FLOW_NOT_NEGOTIATED;
+    }
+
     bool submit_frame = false;
     VmbFrame_t *frame;
     do
     {
-        // Wait until we can get a filled frame (added to queue in vimba_frame_callback)
-        frame = NULL;
-        GstStateChangeReturn ret;
-        GstState state;
-        do
-        {
-            // Try to get a filled frame for 10 microseconds
-            frame = g_async_queue_timeout_pop(vimbasrc->filled_frame_queue, 10);
-            // Get the current state of the element. Should return immediately since we are not doing ASYNC state changes
-            // but wait at most for 100 nanoseconds
-            ret = gst_element_get_state(GST_ELEMENT(vimbasrc), &state, NULL, 100); // timeout is given in nanoseconds
-            UNUSED(ret);
-            if (state != GST_STATE_PLAYING)
+        // Wait until we can get a filled frame (added to queue in vimba_frame_callback). The wait is interrupted by
+        // gst_vimbasrc_unlock if the element needs to stop streaming
+        GstClockTime wait_start = gst_util_get_timestamp();
+        frame = frame_queue_pop_wait(vimbasrc->filled_frame_queue);
+        frame_stats_add(&vimbasrc->stats.blocked_time, gst_util_get_timestamp() - wait_start);
+        if (frame == NULL)
+        {
+            GST_INFO_OBJECT(vimbasrc, "Element is flushing. Aborting create call.");
+            return GST_FLOW_FLUSHING;
+        }
+        track_frame_id(vimbasrc, frame);
+        if (vimbasrc->properties.leaky == GST_VIMBASRC_LEAKY_DOWNSTREAM)
+        {
+            // Only the latest filled frame is delivered. Older frames are handed back to the camera right away
+            guint64 skipped_count = 0;
+            VmbFrame_t *newer_frame;
+            while ((newer_frame = frame_queue_pop(vimbasrc->filled_frame_queue)) != NULL)
+            {
+                gst_vimba_buffer_pool_requeue_frame(GST_VIMBA_BUFFER_POOL(vimbasrc->pool), frame);
+                skipped_count++;
+                frame = newer_frame;
+                track_frame_id(vimbasrc, frame);
+            }
+            if (skipped_count > 0)
             {
-                // The src should not create any more data. Stop waiting for frame and do not fill buf
-                GST_INFO_OBJECT(vimbasrc, "Element state is no longer \"GST_STATE_PLAYING\". Aborting create call.");
-                return GST_FLOW_FLUSHING;
+                GST_DEBUG_OBJECT(vimbasrc,
+                                 "Dropping %" G_GUINT64_FORMAT " older frames in favour of frame with ID \"%llu\"",
+                                 skipped_count,
+                                 frame->frameID);
+                count_dropped_frames(vimbasrc, skipped_count);
             }
-        } while (frame == NULL);
+        }
         // We got a frame. Check receive status and handle incomplete frames according to
         // vimbasrc->properties.incomplete_frame_handling
-        if (frame->receiveStatus == VmbFrameStatusIncomplete)
+        if ((frame->receiveFlags & VmbFrameFlagsDimension) && vimbasrc->conversion.width != 0 &&
+            (frame->width != vimbasrc->conversion.width || frame->height != vimbasrc->conversion.height))
+        {
+            // Frames that were still on their way when the acquisition was paused to change the ROI
+            GST_DEBUG_OBJECT(vimbasrc,
+                             "Dropping frame with ID \"%llu\" of %u x %u pixels captured before the ROI changed",
+                             frame->frameID,
+                             frame->width,
+                             frame->height);
+            gst_vimba_buffer_pool_requeue_frame(GST_VIMBA_BUFFER_POOL(vimbasrc->pool), frame);
+        }
+        else if (frame->receiveStatus == VmbFrameStatusIncomplete)
         {
             GST_WARNING_OBJECT(vimbasrc,
                                "Received frame with ID \"%llu\" was incomplete", frame->frameID);
+            frame_stats_add(&vimbasrc->stats.incomplete_count, 1);
             if (vimbasrc->properties.incomplete_frame_handling == GST_VIMBASRC_INCOMPLETE_FRAME_HANDLING_SUBMIT)
             {
                 GST_DEBUG_OBJECT(vimbasrc,
@@ -1281,7 +2090,8 @@ static GstFlowReturn gst_vimbasrc_create(GstPushSrc *src, GstBuffer **buf)
             {
                 // frame should be dropped -> requeue vimba buffer here since image data will not be used
                 GST_DEBUG_OBJECT(vimbasrc, "Dropping incomplete frame and requeueing buffer to capture queue");
-                VmbCaptureFrameQueue(vimbasrc->camera.handle, frame, &vimba_frame_callback);
+                gst_vimba_buffer_pool_requeue_frame(GST_VIMBA_BUFFER_POOL(vimbasrc->pool), frame);
+                count_dropped_frames(vimbasrc, 1);
             }
         }
         else
@@ -1291,19 +2101,146 @@ static GstFlowReturn gst_vimbasrc_create(GstPushSrc *src, GstBuffer **buf)
         }
     } while (!submit_frame);
 
-    // Prepare output buffer that will be filled with frame data
-    GstBuffer *buffer = gst_buffer_new_and_alloc(frame->bufferSize);
+    GstVimbaBufferPool *pool = GST_VIMBA_BUFFER_POOL(vimbasrc->pool);
+    GstBuffer *buffer;
+    if (gst_vimba_buffer_pool_acquire_frame(pool, frame, &buffer) != GST_FLOW_OK)
+    {
+        GST_ELEMENT_ERROR(vimbasrc, RESOURCE, FAILED, ("Could not get buffer of received frame"), (NULL));
+        return GST_FLOW_ERROR;
+    }
+    // The frame memory is sized for the largest ROI. Only the payload of the current ROI is passed on
+    if (gst_buffer_get_size(buffer) > vimbasrc->payload_size)
+    {
+        gst_buffer_resize(buffer, 0, (gssize)vimbasrc->payload_size);
+    }
 
-    // copy over frame data into the GStreamer buffer
-    // TODO: Investigate if we can work without copying to improve performance?
-    gst_buffer_fill(
-        buffer,
-        0,
-        frame->buffer,
-        frame->bufferSize);
+    if (vimbasrc->properties.adaptive_frame_buffers)
+    {
+        adapt_frame_buffer_count(vimbasrc);
+    }
+
+    if (g_atomic_int_compare_and_exchange(&vimbasrc->latency_invalidated, 1, 0))
+    {
+        update_latency(vimbasrc);
+    }
+
+    // Must be determined before the frame is possibly requeued below
+    GstClockTime timestamp = GST_CLOCK_TIME_NONE;
+    if (vimbasrc->properties.timestamp_mode == GST_VIMBASRC_TIMESTAMP_MODE_CAMERA)
+    {
+        timestamp = get_camera_running_time(vimbasrc, frame);
+    }
+    gst_buffer_add_vimba_frame_meta(buffer, frame);
+    GstClockTime receive_time = gst_vimba_memory_from_frame(frame)->receive_time;
+
+    // The bit depth is scaled while the image data is written to the output buffer
+    BitDepthScaling_t scaling = vimbasrc->conversion.scaled_bit_depth != 0
+                                    ? (BitDepthScaling_t)vimbasrc->properties.bit_depth_scaling
+                                    : BIT_DEPTH_SCALING_NONE;
+
+    // Only pass the frame memory on if enough frames remain queued for the camera to continue capturing
+    gint remaining_frames = (gint)gst_vimba_buffer_pool_get_queued_count(pool);
+    guint buffer_count = gst_vimba_buffer_pool_get_buffer_count(pool);
+    gint min_queued_frames =
+        (gint)MAX((buffer_count + ZEROCOPY_MIN_QUEUED_FRAMES_DIVISOR - 1) / ZEROCOPY_MIN_QUEUED_FRAMES_DIVISOR, 1);
+    const VimbaGstFormatMatch_t *format_match = vimbasrc->conversion.format_match;
+    if (format_match != NULL && format_match->convert != NULL)
+    {
+        if (format_match_is_demosaiced(format_match) && vimbasrc->debayer == NULL)
+        {
+            vimbasrc->debayer = debayer_new(vimbasrc->properties.debayer_threads);
+        }
+        ConversionSettings_t settings = {scaling,
+                                         (DebayerMethod_t)vimbasrc->properties.debayer_method,
+                                         vimbasrc->debayer};
+
+        // The image is converted directly into the output buffer with the default strides and plane offsets of
+        // GstVideoInfo
+        GstBuffer *frame_buffer = buffer;
+        buffer = acquire_output_buffer(vimbasrc,
+                                       gst_format_image_size(format_match->gst_format, frame->width, frame->height));
+
+        GstMapInfo frame_map, map;
+        gst_buffer_map(frame_buffer, &frame_map, GST_MAP_READ);
+        gst_buffer_map(buffer, &map, GST_MAP_WRITE);
+        format_match->convert(format_match->vimba_format,
+                              format_match->gst_format,
+                              &settings,
+                              frame_map.data,
+                              MIN(frame_map.size, frame->imageSize),
+                              frame->width,
+                              frame->height,
+                              map.data);
+        gst_buffer_unmap(buffer, &map);
+        gst_buffer_unmap(frame_buffer, &frame_map);
+        gst_buffer_copy_into(buffer, frame_buffer, GST_BUFFER_COPY_META, 0, -1);
+
+        // The frame is requeued for Vimba right away since the converted image no longer refers to its memory
+        gst_buffer_unref(frame_buffer);
+    }
+    else if (!vimbasrc->properties.zerocopy || remaining_frames < min_queued_frames)
+    {
+        if (vimbasrc->properties.zerocopy)
+        {
+            GST_DEBUG_OBJECT(vimbasrc,
+                             "Only %d frames available for capturing. Copying image data of frame with ID \"%llu\"",
+                             remaining_frames,
+                             frame->frameID);
+        }
+        // Prepare output buffer that will be filled with frame data
+        GstBuffer *frame_buffer = buffer;
+        buffer = acquire_output_buffer(vimbasrc, gst_buffer_get_size(frame_buffer));
+
+        // copy over frame data into the GStreamer buffer
+        GstMapInfo frame_map;
+        gst_buffer_map(frame_buffer, &frame_map, GST_MAP_READ);
+        if (scaling != BIT_DEPTH_SCALING_NONE)
+        {
+            // Only the image data is scaled. Chunk data appended to it is copied unchanged
+            gsize image_size = MIN(frame_map.size, frame->imageSize) / sizeof(guint16) * sizeof(guint16);
+            GstMapInfo map;
+            gst_buffer_map(buffer, &map, GST_MAP_WRITE);
+            pixel_scale_bit_depth((const guint16 *)frame_map.data,
+                                  (guint16 *)map.data,
+                                  image_size / sizeof(guint16),
+                                  vimbasrc->conversion.scaled_bit_depth,
+                                  scaling);
+            memcpy(map.data + image_size, frame_map.data + image_size, frame_map.size - image_size);
+            gst_buffer_unmap(buffer, &map);
+        }
+        else
+        {
+            gst_buffer_fill(
+                buffer,
+                0,
+                frame_map.data,
+                frame_map.size);
+        }
+        gst_buffer_unmap(frame_buffer, &frame_map);
+        gst_buffer_copy_into(buffer, frame_buffer, GST_BUFFER_COPY_META, 0, -1);
+
+        // releasing the pool buffer after we copied the image data requeues the frame for Vimba to use again
+        gst_buffer_unref(frame_buffer);
+    }
+    else if (scaling != BIT_DEPTH_SCALING_NONE)
+    {
+        // The frame memory is only passed downstream after scaling, so it can be modified in place. Chunk data appended
+        // to the image is left unchanged
+        GstMapInfo map;
+        gst_buffer_map(buffer, &map, GST_MAP_READWRITE);
+        pixel_scale_bit_depth((const guint16 *)map.data,
+                              (guint16 *)map.data,
+                              MIN(map.size, frame->imageSize) / sizeof(guint16),
+                              vimbasrc->conversion.scaled_bit_depth,
+                              scaling);
+        gst_buffer_unmap(buffer, &map);
+    }
 
-    // requeue frame after we copied the image data for Vimba to use again
-    VmbCaptureFrameQueue(vimbasrc->camera.handle, frame, &vimba_frame_callback);
+    // Buffers without timestamp are stamped by GstBaseSrc with the current running time
+    GST_BUFFER_PTS(buffer) = timestamp;
+    GST_BUFFER_DTS(buffer) = timestamp;
+
+    count_delivered_frame(vimbasrc, receive_time);
 
     // Set filled GstBuffer as output to pass down the pipeline
     *buf = buffer;
@@ -1364,6 +2301,27 @@ VmbError_t open_camera_connection(GstVimbaSrc *vimbasrc)
         }
         vimbasrc->camera.is_connected = true;
         map_supported_pixel_formats(vimbasrc);
+        for (size_t i = 0; i < G_N_ELEMENTS(latency_features); i++)
+        {
+            // Features the camera does not provide can not be registered and are ignored
+            VmbFeatureInvalidationRegister(vimbasrc->camera.handle,
+                                           latency_features[i],
+                                           &latency_feature_invalidated,
+                                           vimbasrc);
+        }
+        for (size_t i = 0; i < G_N_ELEMENTS(caps_features); i++)
+        {
+            VmbFeatureInvalidationRegister(vimbasrc->camera.handle,
+                                           caps_features[i],
+                                           &caps_feature_invalidated,
+                                           vimbasrc);
+        }
+        // Caps cached for a previously opened camera no longer apply
+        g_atomic_int_set(&vimbasrc->caps_invalidated, 1);
+        if (vimbasrc->allocator == NULL)
+        {
+            vimbasrc->allocator = gst_vimba_allocator_new(vimbasrc->camera.handle);
+        }
     }
     else
     {
@@ -1376,6 +2334,7 @@ VmbError_t open_camera_connection(GstVimbaSrc *vimbasrc)
         // TODO: Can we signal an error to the pipeline to stop immediately?
     }
     vimbasrc->camera.is_acquiring = false;
+    vimbasrc->camera.is_capturing = false;
     return result;
 }
 
@@ -1388,15 +2347,45 @@ VmbError_t open_camera_connection(GstVimbaSrc *vimbasrc)
  */
 VmbError_t apply_feature_settings(GstVimbaSrc *vimbasrc)
 {
+    // Exposure, gain and the auto features can be changed while the camera is acquiring
+    apply_exposure_time(vimbasrc);
+    apply_auto_feature(vimbasrc, "ExposureAuto", GST_ENUM_EXPOSUREAUTO_MODES, vimbasrc->properties.exposureauto);
+    apply_auto_feature(vimbasrc,
+                       "BalanceWhiteAuto",
+                       GST_ENUM_BALANCEWHITEAUTO_MODES,
+                       vimbasrc->properties.balancewhiteauto);
+    apply_gain(vimbasrc);
+
+    // The ROI and the trigger settings are locked while the camera is acquiring
     bool was_acquiring = vimbasrc->camera.is_acquiring;
     if (vimbasrc->camera.is_acquiring)
     {
         GST_DEBUG_OBJECT(vimbasrc, "Camera was acquiring. Stopping to change feature settings");
         stop_image_acquisition(vimbasrc);
     }
-    GEnumValue *enum_entry;
 
-    // exposure time
+    VmbError_t result = set_roi(vimbasrc);
+
+    result = apply_trigger_settings(vimbasrc);
+
+    if (was_acquiring)
+    {
+        GST_DEBUG_OBJECT(vimbasrc, "Camera was acquiring before changing feature settings. Restarting.");
+        result = start_image_acquisition(vimbasrc);
+    }
+
+    return result;
+}
+
+/**
+ * @brief Sets the ExposureTime feature (or the legacy ExposureTimeAbs feature) to the exposuretime property. The
+ * feature can be changed while the camera is acquiring
+ *
+ * @param vimbasrc Provides access to the camera handle and the property value
+ * @return VmbError_t Return status indicating errors if they occurred
+ */
+VmbError_t apply_exposure_time(GstVimbaSrc *vimbasrc)
+{
     // TODO: Workaround for cameras with legacy "ExposureTimeAbs" feature should be replaced with a general legacy
     // feature name handling approach: A static table maps each property, e.g. "exposuretime", to a list of (feature
     // name, set function, get function) pairs, e.g. [("ExposureTime", setExposureTime, getExposureTime),
@@ -1435,11 +2424,19 @@ VmbError_t apply_feature_settings(GstVimbaSrc *vimbasrc)
                            vimbasrc->properties.exposuretime,
                            ErrorCodeToMessage(result));
     }
+    return result;
+}
 
-    // Exposure Auto
-    enum_entry = g_enum_get_value(g_type_class_ref(GST_ENUM_EXPOSUREAUTO_MODES), vimbasrc->properties.exposureauto);
-    GST_DEBUG_OBJECT(vimbasrc, "Setting \"ExposureAuto\" to %s", enum_entry->value_nick);
-    result = VmbFeatureEnumSet(vimbasrc->camera.handle, "ExposureAuto", enum_entry->value_nick);
+/**
+ * @brief Sets the Gain feature to the gain property. The feature can be changed while the camera is acquiring
+ *
+ * @param vimbasrc Provides access to the camera handle and the property value
+ * @return VmbError_t Return status indicating errors if they occurred
+ */
+VmbError_t apply_gain(GstVimbaSrc *vimbasrc)
+{
+    GST_DEBUG_OBJECT(vimbasrc, "Setting \"Gain\" to %f", vimbasrc->properties.gain);
+    VmbError_t result = VmbFeatureFloatSet(vimbasrc->camera.handle, "Gain", vimbasrc->properties.gain);
     if (result == VmbErrorSuccess)
     {
         GST_DEBUG_OBJECT(vimbasrc, "Setting was changed successfully");
@@ -1447,16 +2444,29 @@ VmbError_t apply_feature_settings(GstVimbaSrc *vimbasrc)
     else
     {
         GST_WARNING_OBJECT(vimbasrc,
-                           "Failed to set \"ExposureAuto\" to %s. Return code was: %s",
-                           enum_entry->value_nick,
+                           "Failed to set \"Gain\" to %f. Return code was: %s",
+                           vimbasrc->properties.gain,
                            ErrorCodeToMessage(result));
     }
+    return result;
+}
 
-    // Auto whitebalance
-    enum_entry = g_enum_get_value(g_type_class_ref(GST_ENUM_BALANCEWHITEAUTO_MODES),
-                                  vimbasrc->properties.balancewhiteauto);
-    GST_DEBUG_OBJECT(vimbasrc, "Setting \"BalanceWhiteAuto\" to %s", enum_entry->value_nick);
-    result = VmbFeatureEnumSet(vimbasrc->camera.handle, "BalanceWhiteAuto", enum_entry->value_nick);
+/**
+ * @brief Sets an "Auto" enum feature like ExposureAuto to the nick of an enum property value. These features can be
+ * changed while the camera is acquiring
+ *
+ * @param vimbasrc Provides access to the camera handle
+ * @param feature_name Name of the enum feature
+ * @param enum_type Enum type of the property whose value nicks match the feature entries
+ * @param value Value of the property
+ * @return VmbError_t Return status indicating errors if they occurred
+ */
+VmbError_t apply_auto_feature(GstVimbaSrc *vimbasrc, const char *feature_name, GType enum_type, int value)
+{
+    GEnumClass *enum_class = g_type_class_ref(enum_type);
+    GEnumValue *enum_entry = g_enum_get_value(enum_class, value);
+    GST_DEBUG_OBJECT(vimbasrc, "Setting \"%s\" to %s", feature_name, enum_entry->value_nick);
+    VmbError_t result = VmbFeatureEnumSet(vimbasrc->camera.handle, feature_name, enum_entry->value_nick);
     if (result == VmbErrorSuccess)
     {
         GST_DEBUG_OBJECT(vimbasrc, "Setting was changed successfully");
@@ -1464,36 +2474,12 @@ VmbError_t apply_feature_settings(GstVimbaSrc *vimbasrc)
     else
     {
         GST_WARNING_OBJECT(vimbasrc,
-                           "Failed to set \"BalanceWhiteAuto\" to %s. Return code was: %s",
+                           "Failed to set \"%s\" to %s. Return code was: %s",
+                           feature_name,
                            enum_entry->value_nick,
                            ErrorCodeToMessage(result));
     }
-
-    // gain
-    GST_DEBUG_OBJECT(vimbasrc, "Setting \"Gain\" to %f", vimbasrc->properties.gain);
-    result = VmbFeatureFloatSet(vimbasrc->camera.handle, "Gain", vimbasrc->properties.gain);
-    if (result == VmbErrorSuccess)
-    {
-        GST_DEBUG_OBJECT(vimbasrc, "Setting was changed successfully");
-    }
-    else
-    {
-        GST_WARNING_OBJECT(vimbasrc,
-                           "Failed to set \"Gain\" to %f. Return code was: %s",
-                           vimbasrc->properties.gain,
-                           ErrorCodeToMessage(result));
-    }
-
-    result = set_roi(vimbasrc);
-
-    result = apply_trigger_settings(vimbasrc);
-
-    if (was_acquiring)
-    {
-        GST_DEBUG_OBJECT(vimbasrc, "Camera was acquiring before changing feature settings. Restarting.");
-        result = start_image_acquisition(vimbasrc);
-    }
-
+    g_type_class_unref(enum_class);
     return result;
 }
 
@@ -1512,6 +2498,25 @@ VmbError_t set_roi(GstVimbaSrc *vimbasrc)
 {
     // TODO: Improve error handling (Perhaps more explicit allowed values are enough?) Early exit on errors?
 
+    // The current ROI properties are applied below. Properties resolved here are stored without going through
+    // set_property so that they do not flag another ROI change
+    g_atomic_int_set(&vimbasrc->roi_invalidated, 0);
+
+    // Binning or decimation applied for previously negotiated caps is undone so the ROI refers to the same sensor
+    // resolution as before
+    vimbasrc->roi.horizontal_factor = set_subsampling_factor(vimbasrc,
+                                                             horizontal_subsampling_features,
+                                                             vimbasrc->roi.initial_horizontal,
+                                                             vimbasrc->roi.horizontal_factor,
+                                                             1);
+    vimbasrc->roi.vertical_factor = set_subsampling_factor(vimbasrc,
+                                                           vertical_subsampling_features,
+                                                           vimbasrc->roi.initial_vertical,
+                                                           vimbasrc->roi.vertical_factor,
+                                                           1);
+    vimbasrc->roi.initial_horizontal = get_subsampling_value(vimbasrc, horizontal_subsampling_features);
+    vimbasrc->roi.initial_vertical = get_subsampling_value(vimbasrc, vertical_subsampling_features);
+
     // Reset OffsetX and OffsetY to 0 so that full sensor width is usable for width/height
     VmbError_t result;
     GST_DEBUG_OBJECT(vimbasrc, "Temporarily resetting \"OffsetX\" and \"OffsetY\" to 0");
@@ -1540,7 +2545,8 @@ VmbError_t set_roi(GstVimbaSrc *vimbasrc)
                          "Setting \"Width\" to full width. Got sensor width \"%lld\" (Return Code %s)",
                          vmb_width,
                          ErrorCodeToMessage(result));
-        g_object_set(vimbasrc, "width", (int)vmb_width, NULL);
+        vimbasrc->properties.width = (int)vmb_width;
+        g_object_notify(G_OBJECT(vimbasrc), "width");
     }
     GST_DEBUG_OBJECT(vimbasrc, "Setting \"Width\" to %d", vimbasrc->properties.width);
     result = VmbFeatureIntSet(vimbasrc->camera.handle, "Width", vimbasrc->properties.width);
@@ -1565,7 +2571,8 @@ VmbError_t set_roi(GstVimbaSrc *vimbasrc)
                          "Setting \"Height\" to full height. Got sensor height \"%lld\" (Return Code %s)",
                          vmb_height,
                          ErrorCodeToMessage(result));
-        g_object_set(vimbasrc, "height", (int)vmb_height, NULL);
+        vimbasrc->properties.height = (int)vmb_height;
+        g_object_notify(G_OBJECT(vimbasrc), "height");
     }
     GST_DEBUG_OBJECT(vimbasrc, "Setting \"Height\" to %d", vimbasrc->properties.height);
     result = VmbFeatureIntSet(vimbasrc->camera.handle, "Height", vimbasrc->properties.height);
@@ -1585,7 +2592,8 @@ VmbError_t set_roi(GstVimbaSrc *vimbasrc)
         VmbInt64_t vmb_offsetx = (vmb_width - vimbasrc->properties.width) >> 1;
         GST_DEBUG_OBJECT(vimbasrc, "ROI centering along x-axis requested. Calculated offsetx=%lld",
                          vmb_offsetx);
-        g_object_set(vimbasrc, "offsetx", (int) vmb_offsetx, NULL);
+        vimbasrc->properties.offsetx = (int)vmb_offsetx;
+        g_object_notify(G_OBJECT(vimbasrc), "offsetx");
     }
     GST_DEBUG_OBJECT(vimbasrc, "Setting \"OffsetX\" to %d", vimbasrc->properties.offsetx);
     result = VmbFeatureIntSet(vimbasrc->camera.handle, "OffsetX", vimbasrc->properties.offsetx);
@@ -1606,7 +2614,8 @@ VmbError_t set_roi(GstVimbaSrc *vimbasrc)
         VmbInt64_t vmb_offsety = (vmb_height - vimbasrc->properties.height) >> 1;
         GST_DEBUG_OBJECT(vimbasrc, "ROI centering along y-axis requested. Calculated offsety=%lld",
                          vmb_offsety);
-        g_object_set(vimbasrc, "offsety", (int)vmb_offsety, NULL);
+        vimbasrc->properties.offsety = (int)vmb_offsety;
+        g_object_notify(G_OBJECT(vimbasrc), "offsety");
     }
     GST_DEBUG_OBJECT(vimbasrc, "Setting \"OffsetY\" to %d", vimbasrc->properties.offsety);
     result = VmbFeatureIntSet(vimbasrc->camera.handle, "OffsetY", vimbasrc->properties.offsety);
@@ -1621,6 +2630,12 @@ VmbError_t set_roi(GstVimbaSrc *vimbasrc)
                            vimbasrc->properties.offsety,
                            ErrorCodeToMessage(result));
     }
+
+    // The applied ROI is the largest size offered in the caps
+    VmbFeatureIntGet(vimbasrc->camera.handle, "OffsetX", &vimbasrc->roi.offsetx);
+    VmbFeatureIntGet(vimbasrc->camera.handle, "OffsetY", &vimbasrc->roi.offsety);
+    VmbFeatureIntGet(vimbasrc->camera.handle, "Width", &vimbasrc->roi.width);
+    VmbFeatureIntGet(vimbasrc->camera.handle, "Height", &vimbasrc->roi.height);
     return result;
 }
 
@@ -1765,150 +2780,1205 @@ VmbError_t apply_trigger_settings(GstVimbaSrc *vimbasrc)
 }
 
 /**
- * @brief Gets the PayloadSize from the connected camera, allocates and announces frame buffers for capturing
+ * @brief Starts the capture engine, queues the frames of the buffer pool and runs the AcquisitionStart command feature.
+ * The buffer pool must be set up and active before running this function.
  *
- * @param vimbasrc Provides the camera handle used for the Vimba calls and holds the frame buffers
+ * @param vimbasrc Provides the camera handle used for the Vimba calls and access to the buffer pool holding the frames
  * @return VmbError_t Return status indicating errors if they occurred
  */
-VmbError_t alloc_and_announce_buffers(GstVimbaSrc *vimbasrc)
+VmbError_t start_image_acquisition(GstVimbaSrc *vimbasrc)
 {
-    VmbInt64_t payload_size;
-    VmbError_t result = VmbFeatureIntGet(vimbasrc->camera.handle, "PayloadSize", &payload_size);
-    if (result == VmbErrorSuccess)
+    if (vimbasrc->pool == NULL)
     {
-        GST_DEBUG_OBJECT(vimbasrc, "Got \"PayloadSize\" of: %llu", payload_size);
-        GST_DEBUG_OBJECT(vimbasrc, "Allocating and announcing %d vimba frames", NUM_VIMBA_FRAMES);
-        for (int i = 0; i < NUM_VIMBA_FRAMES; i++)
-        {
-            vimbasrc->frame_buffers[i].buffer = (unsigned char *)malloc((VmbUint32_t)payload_size);
-            if (NULL == vimbasrc->frame_buffers[i].buffer)
-            {
-                result = VmbErrorResources;
-                break;
-            }
-            vimbasrc->frame_buffers[i].bufferSize = (VmbUint32_t)payload_size;
-            vimbasrc->frame_buffers[i].context[0] = vimbasrc->filled_frame_queue;
-
-            // Announce Frame
-            result = VmbFrameAnnounce(vimbasrc->camera.handle,
-                                      &vimbasrc->frame_buffers[i],
-                                      (VmbUint32_t)sizeof(VmbFrame_t));
-            if (result != VmbErrorSuccess)
-            {
-                free(vimbasrc->frame_buffers[i].buffer);
-                memset(&vimbasrc->frame_buffers[i], 0, sizeof(VmbFrame_t));
-                break;
-            }
-        }
+        GST_ERROR_OBJECT(vimbasrc, "Can not start acquisition without a buffer pool");
+        return VmbErrorInvalidCall;
+    }
+
+    // The camera may restart counting frame IDs with the new acquisition
+    vimbasrc->has_last_frame_id = false;
+
+    // The capture engine still runs with the frames queued if the acquisition was only paused
+    VmbError_t result = VmbErrorSuccess;
+    if (!vimbasrc->camera.is_capturing)
+    {
+        // Start Capture Engine
+        GST_DEBUG_OBJECT(vimbasrc, "Starting the capture engine");
+        result = VmbCaptureStart(vimbasrc->camera.handle);
+        if (result == VmbErrorSuccess)
+        {
+            vimbasrc->camera.is_capturing = true;
+            GST_DEBUG_OBJECT(vimbasrc, "Queueing the vimba frames");
+            // Frames that are still used downstream are queued once they are released
+            result = gst_vimba_buffer_pool_start_capture(GST_VIMBA_BUFFER_POOL(vimbasrc->pool));
+        }
+    }
+    if (result == VmbErrorSuccess)
+    {
+        // Start Acquisition
+        result = run_command_feature(vimbasrc, "AcquisitionStart");
+    }
+    if (vimbasrc->camera.is_capturing)
+    {
+        vimbasrc->camera.is_acquiring = true;
     }
     return result;
 }
 
 /**
- * @brief Revokes frame buffers, frees their memory and overwrites old pointers with 0
+ * @brief Runs the AcquisitionStop command feature, stops the capture engine and flushes the capture queue
  *
- * @param vimbasrc Provides the camera handle used for the Vimba calls and the frame buffers
+ * @param vimbasrc Provides the camera handle which is used for the Vimba function calls
+ * @return VmbError_t Return status indicating errors if they occurred
  */
-void revoke_and_free_buffers(GstVimbaSrc *vimbasrc)
+VmbError_t stop_image_acquisition(GstVimbaSrc *vimbasrc)
 {
-    for (int i = 0; i < NUM_VIMBA_FRAMES; i++)
+    vimbasrc->camera.is_acquiring = false;
+    vimbasrc->camera.is_capturing = false;
+
+    // Stop Acquisition
+    VmbError_t result = run_command_feature(vimbasrc, "AcquisitionStop");
+
+    // Stop Capture Engine
+    GST_DEBUG_OBJECT(vimbasrc, "Stopping the capture engine");
+    result = VmbCaptureEnd(vimbasrc->camera.handle);
+
+    // Flush the capture queue
+    GST_DEBUG_OBJECT(vimbasrc, "Flushing the capture queue");
+    VmbCaptureQueueFlush(vimbasrc->camera.handle);
+
+    // Filled frames that were not consumed yet are queued again when the acquisition is restarted. Remove them from the
+    // queue so they are not consumed twice
+    frame_queue_clear(vimbasrc->filled_frame_queue);
+
+    // Put the frames that were handed to Vimba back into the pool. Released buffers are no longer requeued from now on
+    if (NULL != vimbasrc->pool)
     {
-        if (NULL != vimbasrc->frame_buffers[i].buffer)
+        gst_vimba_buffer_pool_stop_capture(GST_VIMBA_BUFFER_POOL(vimbasrc->pool));
+    }
+
+    return result;
+}
+
+/**
+ * @brief Runs the AcquisitionStop command feature but keeps the capture engine running with the frames queued, so
+ * start_image_acquisition only has to run AcquisitionStart again. Used to change the ROI while playing
+ *
+ * @param vimbasrc Provides the camera handle which is used for the Vimba function calls
+ * @return VmbError_t Return status indicating errors if they occurred
+ */
+VmbError_t pause_image_acquisition(GstVimbaSrc *vimbasrc)
+{
+    vimbasrc->camera.is_acquiring = false;
+
+    VmbError_t result = run_command_feature(vimbasrc, "AcquisitionStop");
+
+    // Filled frames that were not consumed yet may have the size of the previous ROI. Hand them back to Vimba
+    if (NULL != vimbasrc->pool)
+    {
+        VmbFrame_t *frame;
+        while ((frame = frame_queue_pop(vimbasrc->filled_frame_queue)) != NULL)
         {
-            VmbFrameRevoke(vimbasrc->camera.handle, &vimbasrc->frame_buffers[i]);
-            free(vimbasrc->frame_buffers[i].buffer);
-            memset(&vimbasrc->frame_buffers[i], 0, sizeof(VmbFrame_t));
+            gst_vimba_buffer_pool_requeue_frame(GST_VIMBA_BUFFER_POOL(vimbasrc->pool), frame);
         }
     }
+
+    return result;
 }
 
 /**
- * @brief Starts the capture engine, queues Vimba frames and runs the AcquisitionStart command feature. Frame buffers
- * must be allocated before running this function.
+ * @brief Runs a command feature and waits until the camera reports it as done
  *
- * @param vimbasrc Provides the camera handle used for the Vimba calls and access to the queued frame buffers
- * @return VmbError_t Return status indicating errors if they occurred
+ * @param vimbasrc Provides the camera handle which is used for the Vimba function calls
+ * @param feature_name Name of the command feature, e.g. "AcquisitionStart"
+ * @return VmbError_t Return status of running the command
  */
-VmbError_t start_image_acquisition(GstVimbaSrc *vimbasrc)
+VmbError_t run_command_feature(GstVimbaSrc *vimbasrc, const char *feature_name)
 {
-    // Start Capture Engine
-    GST_DEBUG_OBJECT(vimbasrc, "Starting the capture engine");
-    VmbError_t result = VmbCaptureStart(vimbasrc->camera.handle);
-    if (result == VmbErrorSuccess)
+    GST_DEBUG_OBJECT(vimbasrc, "Running \"%s\" feature", feature_name);
+    VmbError_t result = VmbFeatureCommandRun(vimbasrc->camera.handle, feature_name);
+    VmbBool_t is_command_done = VmbBoolFalse;
+    do
     {
-        GST_DEBUG_OBJECT(vimbasrc, "Queueing the vimba frames");
-        for (int i = 0; i < NUM_VIMBA_FRAMES; i++)
+        if (VmbErrorSuccess != VmbFeatureCommandIsDone(vimbasrc->camera.handle, feature_name, &is_command_done))
         {
-            // Queue Frame
-            result = VmbCaptureFrameQueue(vimbasrc->camera.handle, &vimbasrc->frame_buffers[i], &vimba_frame_callback);
-            if (VmbErrorSuccess != result)
+            break;
+        }
+    } while (VmbBoolFalse == is_command_done);
+
+    return result;
+}
+
+void VMB_CALL vimba_frame_callback(const VmbHandle_t camera_handle, VmbFrame_t *frame)
+{
+    UNUSED(camera_handle); // enable compilation while treating warning of unused vairable as error
+    GST_TRACE("Got Frame");
+    gst_vimba_memory_from_frame(frame)->receive_time = gst_util_get_timestamp();
+    gst_vimba_buffer_pool_frame_filled(frame);
+    // context[0] holds vimbasrc->filled_frame_queue. It is large enough for all announced frames, so this only fails if
+    // leaky=Upstream limits its length. The dropped frame is detected by the frame ID gap in vimbasrc_create
+    if (!frame_queue_push(frame->context[0], frame))
+    {
+        GST_DEBUG("Filled frame queue is full. Dropping frame with ID \"%llu\"", frame->frameID);
+        gst_vimba_buffer_pool_requeue_frame(frame->context[2], frame);
+    }
+
+    // requeueing the frame is done after it was consumed in vimbasrc_create
+}
+
+/**
+ * @brief Announces an additional frame if the camera ran out of queued frames since the last call and revokes one of
+ * the additionally announced frames once at least numframebuffers frames remained queued for a while
+ *
+ * @param vimbasrc Provides access to the buffer pool holding the frames
+ */
+void adapt_frame_buffer_count(GstVimbaSrc *vimbasrc)
+{
+    GstVimbaBufferPool *pool = GST_VIMBA_BUFFER_POOL(vimbasrc->pool);
+
+    if (gst_vimba_buffer_pool_take_starved(pool))
+    {
+        vimbasrc->idle_frame_count = 0;
+        if (gst_vimba_buffer_pool_grow(pool))
+        {
+            g_atomic_int_set(&vimbasrc->latency_invalidated, 1);
+            GST_INFO_OBJECT(vimbasrc,
+                            "Camera ran out of queued frames. Now using %u vimba frames",
+                            gst_vimba_buffer_pool_get_buffer_count(pool));
+        }
+        else
+        {
+            GST_DEBUG_OBJECT(vimbasrc, "Camera ran out of queued frames but no additional frame may be announced");
+        }
+    }
+    else if (gst_vimba_buffer_pool_get_queued_count(pool) >= vimbasrc->properties.num_frame_buffers)
+    {
+        if (++vimbasrc->idle_frame_count >= ADAPTIVE_SHRINK_IDLE_FRAMES)
+        {
+            vimbasrc->idle_frame_count = 0;
+            if (gst_vimba_buffer_pool_shrink(pool))
             {
-                break;
+                g_atomic_int_set(&vimbasrc->latency_invalidated, 1);
+                GST_INFO_OBJECT(vimbasrc, "Additional vimba frames were not needed. Revoking one frame");
             }
         }
+    }
+    else
+    {
+        vimbasrc->idle_frame_count = 0;
+    }
+}
+
+/**
+ * @brief Reads the frequency of the camera timestamp ticks. Cameras that do not report it are assumed to use
+ * nanoseconds
+ *
+ * @param vimbasrc Provides the camera handle and stores the frequency
+ */
+void query_timestamp_frequency(GstVimbaSrc *vimbasrc)
+{
+    VmbError_t result = VmbFeatureIntGet(vimbasrc->camera.handle,
+                                         "GevTimestampTickFrequency",
+                                         &vimbasrc->camera.timestamp_frequency);
+    if (result != VmbErrorSuccess || vimbasrc->camera.timestamp_frequency <= 0)
+    {
+        GST_DEBUG_OBJECT(vimbasrc,
+                         "Could not read \"GevTimestampTickFrequency\" (Return code %s). Assuming timestamps in ns",
+                         ErrorCodeToMessage(result));
+        vimbasrc->camera.timestamp_frequency = GST_SECOND;
+    }
+    GST_DEBUG_OBJECT(vimbasrc, "Camera timestamp frequency is %lld Hz", vimbasrc->camera.timestamp_frequency);
+}
+
+/**
+ * @brief Maps the timestamp the camera assigned to a frame to the running time of the pipeline. The mapping between
+ * camera clock and pipeline clock is updated with the time at which the frame was received
+ *
+ * @param vimbasrc Provides the pipeline clock and holds the timestamp mapping
+ * @param frame Filled frame whose timestamp should be mapped
+ * @return GstClockTime The running time corresponding to the camera timestamp or GST_CLOCK_TIME_NONE if the element
+ * has no clock
+ */
+GstClockTime get_camera_running_time(GstVimbaSrc *vimbasrc, VmbFrame_t *frame)
+{
+    GstClock *clock = gst_element_get_clock(GST_ELEMENT(vimbasrc));
+    if (clock == NULL)
+    {
+        return GST_CLOCK_TIME_NONE;
+    }
+
+    // The receive time was taken from the monotonic system clock. Convert it to the pipeline clock
+    GstClockTimeDiff clock_offset = GST_CLOCK_DIFF(gst_util_get_timestamp(), gst_clock_get_time(clock));
+    gst_object_unref(clock);
+    gint64 receive_time = (gint64)gst_vimba_memory_from_frame(frame)->receive_time + clock_offset;
 
-        if (VmbErrorSuccess == result)
+    guint64 camera_time = gst_util_uint64_scale(frame->timestamp,
+                                                GST_SECOND,
+                                                (guint64)vimbasrc->camera.timestamp_frequency);
+    timestamp_mapping_add_sample(&vimbasrc->timestamp_mapping, camera_time, receive_time);
+    gint64 clock_time = timestamp_mapping_to_host(&vimbasrc->timestamp_mapping, camera_time);
+
+    GstClockTime base_time = gst_element_get_base_time(GST_ELEMENT(vimbasrc));
+    GST_TRACE_OBJECT(vimbasrc,
+                     "Frame with ID \"%llu\" was received %" GST_STIME_FORMAT " after its mapped camera timestamp",
+                     frame->frameID,
+                     GST_STIME_ARGS(receive_time - clock_time));
+    return clock_time > (gint64)base_time ? (GstClockTime)clock_time - base_time : 0;
+}
+
+/**
+ * @brief Checks whether a latency differs from the previously reported one by more than threshold. Changes from or to
+ * GST_CLOCK_TIME_NONE are always significant
+ */
+static bool is_latency_change_significant(GstClockTime previous, GstClockTime latency, GstClockTime threshold)
+{
+    if (!GST_CLOCK_TIME_IS_VALID(previous) || !GST_CLOCK_TIME_IS_VALID(latency))
+    {
+        return previous != latency;
+    }
+    return (previous > latency ? previous - latency : latency - previous) > threshold;
+}
+
+/**
+ * @brief Determines the latency of the element from the current exposure time, frame rate and trigger mode of the
+ * camera and the number of frames available for capturing. Posts a latency message if the latency changed
+ *
+ * The minimum latency is 0 in both timestamp modes. With timestampmode=Pipeline buffers are timestamped when they are
+ * delivered, and camera timestamps are mapped to the earliest time frames were received, so the exposure and readout
+ * are already part of the timestamp. The maximum latency covers the time until the frames that may wait for delivery
+ * are filled. It is unlimited if frames are triggered since the frame period is unknown then. Changes smaller than a
+ * fraction of the frame period are not posted
+ *
+ * @param vimbasrc Provides the camera handle and stores the determined latency
+ */
+void update_latency(GstVimbaSrc *vimbasrc)
+{
+    double exposure_time = 0.;
+    if (VmbFeatureFloatGet(vimbasrc->camera.handle, "ExposureTime", &exposure_time) != VmbErrorSuccess &&
+        VmbFeatureFloatGet(vimbasrc->camera.handle, "ExposureTimeAbs", &exposure_time) != VmbErrorSuccess)
+    {
+        GST_DEBUG_OBJECT(vimbasrc, "Could not read exposure time. Assuming no exposure time for latency");
+        exposure_time = 0.;
+    }
+    GstClockTime exposure_duration = (GstClockTime)(exposure_time * GST_USECOND);
+
+    double frame_rate = 0.;
+    GstClockTime frame_period = exposure_duration;
+    if (VmbFeatureFloatGet(vimbasrc->camera.handle, "AcquisitionFrameRate", &frame_rate) == VmbErrorSuccess ||
+        VmbFeatureFloatGet(vimbasrc->camera.handle, "AcquisitionFrameRateAbs", &frame_rate) == VmbErrorSuccess)
+    {
+        if (frame_rate > 0.)
         {
-            // Start Acquisition
-            GST_DEBUG_OBJECT(vimbasrc, "Running \"AcquisitionStart\" feature");
-            result = VmbFeatureCommandRun(vimbasrc->camera.handle, "AcquisitionStart");
-            VmbBool_t acquisition_start_done = VmbBoolFalse;
-            do
+            frame_period = (GstClockTime)(GST_SECOND / frame_rate);
+        }
+    }
+    else
+    {
+        GST_DEBUG_OBJECT(vimbasrc, "Could not read frame rate. Assuming the frame period equals the exposure time");
+    }
+    // The camera can not deliver frames faster than it exposes them
+    frame_period = MAX(frame_period, exposure_duration);
+
+    const char *trigger_mode = NULL;
+    bool is_triggered = VmbFeatureEnumGet(vimbasrc->camera.handle, "TriggerMode", &trigger_mode) == VmbErrorSuccess &&
+                        strcmp(trigger_mode, "On") == 0;
+
+    guint frame_count = vimbasrc->pool != NULL
+                            ? gst_vimba_buffer_pool_get_buffer_count(GST_VIMBA_BUFFER_POOL(vimbasrc->pool))
+                            : vimbasrc->properties.num_frame_buffers;
+    // Without leaky mode all other frames may be filled and waiting. Otherwise at most one frame waits to be delivered
+    guint waiting_frame_count = frame_count > 0 ? frame_count - 1 : 0;
+    if (vimbasrc->properties.leaky != GST_VIMBASRC_LEAKY_NONE)
+    {
+        waiting_frame_count = MIN(waiting_frame_count, 1);
+    }
+
+    GstClockTime min_latency = 0;
+    GstClockTime max_latency = GST_CLOCK_TIME_NONE;
+    if (!is_triggered)
+    {
+        max_latency = min_latency + waiting_frame_count * frame_period;
+    }
+
+    // The reported latency stays at the last posted value until it changed significantly
+    GstClockTime threshold = frame_period / LATENCY_CHANGE_FRAME_PERIOD_DIVISOR;
+    GST_OBJECT_LOCK(vimbasrc);
+    bool is_changed = is_latency_change_significant(vimbasrc->latency.min, min_latency, threshold) ||
+                      is_latency_change_significant(vimbasrc->latency.max, max_latency, threshold);
+    if (is_changed)
+    {
+        vimbasrc->latency.min = min_latency;
+        vimbasrc->latency.max = max_latency;
+    }
+    GST_OBJECT_UNLOCK(vimbasrc);
+
+    if (is_changed)
+    {
+        GST_INFO_OBJECT(vimbasrc,
+                        "Latency changed to min %" GST_TIME_FORMAT " max %" GST_TIME_FORMAT,
+                        GST_TIME_ARGS(min_latency),
+                        GST_TIME_ARGS(max_latency));
+        gst_element_post_message(GST_ELEMENT(vimbasrc), gst_message_new_latency(GST_OBJECT(vimbasrc)));
+    }
+}
+
+/**
+ * @brief Called by Vimba if one of the latency_features changed. The latency is updated in the next create call since
+ * features should not be accessed from the callback
+ *
+ * @param camera_handle Handle of the camera whose feature changed
+ * @param name Name of the changed feature
+ * @param user_context The GstVimbaSrc the callback was registered for
+ */
+void VMB_CALL latency_feature_invalidated(const VmbHandle_t camera_handle, const char *name, void *user_context)
+{
+    UNUSED(camera_handle);
+    GstVimbaSrc *vimbasrc = GST_vimbasrc(user_context);
+    GST_TRACE_OBJECT(vimbasrc, "Feature \"%s\" affecting the latency changed", name);
+    g_atomic_int_set(&vimbasrc->latency_invalidated, 1);
+}
+
+/**
+ * @brief Called by Vimba if one of the caps_features changed. The caps are queried from the camera again on the next
+ * get_caps call
+ *
+ * @param camera_handle Handle of the camera whose feature changed
+ * @param name Name of the changed feature
+ * @param user_context The GstVimbaSrc the callback was registered for
+ */
+void VMB_CALL caps_feature_invalidated(const VmbHandle_t camera_handle, const char *name, void *user_context)
+{
+    UNUSED(camera_handle);
+    GstVimbaSrc *vimbasrc = GST_vimbasrc(user_context);
+    GST_TRACE_OBJECT(vimbasrc, "Feature \"%s\" affecting the caps changed", name);
+    g_atomic_int_set(&vimbasrc->caps_invalidated, 1);
+}
+
+/**
+ * @brief Checks whether frames were lost between the previously received frame and the given one by comparing their
+ * frame IDs. Lost frames are counted as dropped
+ *
+ * @param vimbasrc Holds the ID of the previously received frame
+ * @param frame Frame that was just taken from the filled frame queue
+ */
+void track_frame_id(GstVimbaSrc *vimbasrc, VmbFrame_t *frame)
+{
+    // Frame IDs that did not increase indicate a restart of the camera counter and are not counted as gap
+    if (vimbasrc->has_last_frame_id && frame->frameID > vimbasrc->last_frame_id + 1)
+    {
+        guint64 missing_count = frame->frameID - vimbasrc->last_frame_id - 1;
+        GST_WARNING_OBJECT(vimbasrc,
+                           "%" G_GUINT64_FORMAT " frames were lost before frame with ID \"%llu\"",
+                           missing_count,
+                           frame->frameID);
+        count_dropped_frames(vimbasrc, missing_count);
+    }
+    vimbasrc->last_frame_id = frame->frameID;
+    vimbasrc->has_last_frame_id = true;
+}
+
+/**
+ * @brief Adds to the number of dropped frames and informs the application about it with a QoS message
+ *
+ * @param vimbasrc Holds the frame counters
+ * @param dropped_count Number of frames that were dropped
+ */
+void count_dropped_frames(GstVimbaSrc *vimbasrc, guint64 dropped_count)
+{
+    frame_stats_add(&vimbasrc->stats.dropped_count, dropped_count);
+    guint64 delivered = frame_stats_get(&vimbasrc->stats.delivered_count);
+    guint64 dropped = frame_stats_get(&vimbasrc->stats.dropped_count);
+
+    // The timestamps of the dropped frames are unknown since the frames were never seen by the element
+    GstMessage *qos_message = gst_message_new_qos(GST_OBJECT(vimbasrc),
+                                                  TRUE,
+                                                  GST_CLOCK_TIME_NONE,
+                                                  GST_CLOCK_TIME_NONE,
+                                                  GST_CLOCK_TIME_NONE,
+                                                  GST_CLOCK_TIME_NONE);
+    gst_message_set_qos_stats(qos_message, GST_FORMAT_BUFFERS, delivered, dropped);
+    gst_element_post_message(GST_ELEMENT(vimbasrc), qos_message);
+}
+
+/**
+ * @brief Counts a frame that is pushed downstream. Updates the frame rate once per second and posts the stats message
+ * if statsinterval elapsed. Must only be called from the streaming thread
+ *
+ * @param vimbasrc Holds the statistics
+ * @param receive_time Monotonic time at which the frame was received in vimba_frame_callback
+ */
+void count_delivered_frame(GstVimbaSrc *vimbasrc, GstClockTime receive_time)
+{
+    GstClockTime now = gst_util_get_timestamp();
+    frame_stats_add_residence_time(&vimbasrc->stats, now - receive_time);
+    frame_stats_add(&vimbasrc->stats.delivered_count, 1);
+
+    GstClockTime window_duration = now - vimbasrc->stats_window.start;
+    if (window_duration >= GST_SECOND)
+    {
+        gsize delivered_count = frame_stats_get(&vimbasrc->stats.delivered_count);
+        guint64 frame_rate = gst_util_uint64_scale(delivered_count - vimbasrc->stats_window.delivered_count,
+                                                   1000 * GST_SECOND,
+                                                   window_duration);
+        g_atomic_int_set(&vimbasrc->stats.frame_rate, (gint)MIN(frame_rate, (guint64)G_MAXINT));
+        vimbasrc->stats_window.start = now;
+        vimbasrc->stats_window.delivered_count = delivered_count;
+    }
+
+    guint stats_interval = (guint)g_atomic_int_get((gint *)&vimbasrc->properties.stats_interval);
+    if (stats_interval > 0 && now - vimbasrc->last_stats_message >= stats_interval * GST_MSECOND)
+    {
+        vimbasrc->last_stats_message = now;
+        gst_element_post_message(GST_ELEMENT(vimbasrc),
+                                 gst_message_new_element(GST_OBJECT(vimbasrc), create_stats_structure(vimbasrc)));
+    }
+}
+
+static void append_uint64_to_array(GValue *array, guint64 value)
+{
+    GValue element = G_VALUE_INIT;
+    g_value_init(&element, G_TYPE_UINT64);
+    g_value_set_uint64(&element, value);
+    gst_value_array_append_and_take_value(array, &element);
+}
+
+/**
+ * @brief Creates a snapshot of the statistics of the element. May be called from any thread
+ *
+ * @param vimbasrc Holds the statistics
+ * @return GstStructure* Newly allocated structure holding the statistics. Free with gst_structure_free
+ */
+GstStructure *create_stats_structure(GstVimbaSrc *vimbasrc)
+{
+    FrameStats_t *stats = &vimbasrc->stats;
+
+    GValue histogram = G_VALUE_INIT;
+    GValue histogram_bounds = G_VALUE_INIT;
+    g_value_init(&histogram, GST_TYPE_ARRAY);
+    g_value_init(&histogram_bounds, GST_TYPE_ARRAY);
+    for (guint i = 0; i < FRAME_STATS_HISTOGRAM_BUCKET_COUNT; i++)
+    {
+        append_uint64_to_array(&histogram, frame_stats_get(&stats->residence_histogram[i]));
+    }
+    for (guint i = 0; i < G_N_ELEMENTS(frame_stats_histogram_bounds); i++)
+    {
+        append_uint64_to_array(&histogram_bounds, frame_stats_histogram_bounds[i]);
+    }
+
+    GstStructure *structure = gst_structure_new(
+        "application/x-vimbasrc-stats",
+        "delivered-frames", G_TYPE_UINT64, (guint64)frame_stats_get(&stats->delivered_count),
+        "dropped-frames", G_TYPE_UINT64, (guint64)frame_stats_get(&stats->dropped_count),
+        "incomplete-frames", G_TYPE_UINT64, (guint64)frame_stats_get(&stats->incomplete_count),
+        "frame-rate", G_TYPE_DOUBLE, g_atomic_int_get(&stats->frame_rate) / 1000.,
+        "queue-depth", G_TYPE_UINT, frame_queue_length(vimbasrc->filled_frame_queue),
+        "blocked-time", G_TYPE_UINT64, (guint64)frame_stats_get(&stats->blocked_time),
+        NULL);
+    // Bucket i counts frames with a residence time (in ns) below bound i (and at least bound i-1). The last bucket
+    // counts all frames exceeding the last bound
+    gst_structure_take_value(structure, "residence-histogram", &histogram);
+    gst_structure_take_value(structure, "residence-histogram-bounds", &histogram_bounds);
+
+    return structure;
+}
+
+/**
+ * @brief Builds the caps the camera can currently provide from its size and supported pixel formats
+ *
+ * @param vimbasrc Provides the camera handle and the supported formats
+ * @return The template caps restricted to the camera settings, or the unmodified template caps if no camera is
+ * connected
+ */
+GstCaps *query_camera_caps(GstVimbaSrc *vimbasrc)
+{
+    GstCaps *caps;
+    caps = gst_pad_get_pad_template_caps(GST_BASE_SRC_PAD(vimbasrc));
+    caps = gst_caps_make_writable(caps);
+
+    // Query the capabilities from the camera and return sensible values. If no camera is connected the template caps
+    // are returned
+    if (vimbasrc->camera.is_connected)
+    {
+        GValue width = G_VALUE_INIT;
+        GValue height = G_VALUE_INIT;
+        query_size_range(vimbasrc, "Width", vimbasrc->roi.width, &width);
+        query_size_range(vimbasrc, "Height", vimbasrc->roi.height, &height);
+
+        GstStructure *raw_caps = gst_caps_get_structure(caps, 0);
+        GstStructure *bayer_caps = gst_caps_get_structure(caps, 1);
+
+        GValue framerate = G_VALUE_INIT;
+        query_framerate_range(vimbasrc, &framerate);
+
+        gst_structure_set_value(raw_caps, "width", &width);
+        gst_structure_set_value(raw_caps, "height", &height);
+        gst_structure_set_value(raw_caps, "framerate", &framerate);
+
+        gst_structure_set_value(bayer_caps, "width", &width);
+        gst_structure_set_value(bayer_caps, "height", &height);
+        gst_structure_set_value(bayer_caps, "framerate", &framerate);
+        g_value_unset(&framerate);
+        g_value_unset(&width);
+        g_value_unset(&height);
+
+        // Query supported pixel formats from camera and map them to GStreamer formats
+        GValue pixel_format_raw_list = G_VALUE_INIT;
+        g_value_init(&pixel_format_raw_list, GST_TYPE_LIST);
+
+        GValue pixel_format_bayer_list = G_VALUE_INIT;
+        g_value_init(&pixel_format_bayer_list, GST_TYPE_LIST);
+
+        GValue pixel_format = G_VALUE_INIT;
+        g_value_init(&pixel_format, G_TYPE_STRING);
+
+        // Add all supported GStreamer format string to the reported caps
+        for (unsigned int i = 0; i < vimbasrc->camera.supported_formats_count; i++)
+        {
+            const VimbaGstFormatMatch_t *format_match = vimbasrc->camera.supported_formats[i];
+            const GstFormatInfo_t *gst_format = format_match->gst_format;
+            g_value_set_static_string(&pixel_format, gst_format->name);
+            // Demosaiced Bayer formats are offered as video/x-raw
+            GValue *pixel_format_list =
+                gst_format->media_type == CAPS_MEDIA_TYPE_BAYER ? &pixel_format_bayer_list : &pixel_format_raw_list;
+            // Multiple camera formats may be converted into the same GStreamer format
+            if (!value_list_contains_string(pixel_format_list, gst_format->name))
             {
-                if (VmbErrorSuccess != VmbFeatureCommandIsDone(vimbasrc->camera.handle,
-                                                               "AcquisitionStart",
-                                                               &acquisition_start_done))
-                {
-                    break;
-                }
-            } while (VmbBoolFalse == acquisition_start_done);
-            vimbasrc->camera.is_acquiring = true;
+                gst_value_list_append_value(pixel_format_list, &pixel_format);
+            }
         }
+        g_value_unset(&pixel_format);
+        gst_structure_take_value(raw_caps, "format", &pixel_format_raw_list);
+        gst_structure_take_value(bayer_caps, "format", &pixel_format_bayer_list);
     }
-    return result;
+
+    return caps;
 }
 
 /**
- * @brief Runs the AcquisitionStop command feature, stops the capture engine and flushes the capture queue
+ * @brief Determines the frame rates the camera can deliver for the caps reported by get_caps
  *
- * @param vimbasrc Provides the camera handle which is used for the Vimba function calls
- * @return VmbError_t Return status indicating errors if they occurred
+ * @param vimbasrc Provides the camera handle
+ * @param framerate Uninitialized GValue that is set to a GST_TYPE_FRACTION_RANGE of the frame rates the camera
+ * supports. If the camera is triggered or does not report its frame rate range it is set to the variable frame rate 0/1
  */
-VmbError_t stop_image_acquisition(GstVimbaSrc *vimbasrc)
+void query_framerate_range(GstVimbaSrc *vimbasrc, GValue *framerate)
 {
-    // Stop Acquisition
-    GST_DEBUG_OBJECT(vimbasrc, "Running \"AcquisitionStop\" feature");
-    VmbError_t result = VmbFeatureCommandRun(vimbasrc->camera.handle, "AcquisitionStop");
-    VmbBool_t acquisition_stop_done = VmbBoolFalse;
-    do
+    const char *trigger_mode = NULL;
+    bool is_triggered = VmbFeatureEnumGet(vimbasrc->camera.handle, "TriggerMode", &trigger_mode) == VmbErrorSuccess &&
+                        strcmp(trigger_mode, "On") == 0;
+
+    double min_frame_rate = 0., max_frame_rate = 0.;
+    VmbError_t result =
+        VmbFeatureFloatRangeQuery(vimbasrc->camera.handle, "AcquisitionFrameRate", &min_frame_rate, &max_frame_rate);
+    if (result != VmbErrorSuccess)
     {
-        if (VmbErrorSuccess != VmbFeatureCommandIsDone(vimbasrc->camera.handle,
-                                                       "AcquisitionStop",
-                                                       &acquisition_stop_done))
+        result = VmbFeatureFloatRangeQuery(vimbasrc->camera.handle,
+                                           "AcquisitionFrameRateAbs",
+                                           &min_frame_rate,
+                                           &max_frame_rate);
+    }
+    if (!is_triggered && result == VmbErrorSuccess && max_frame_rate > 0.)
+    {
+        int min_numerator, min_denominator, max_numerator, max_denominator;
+        gst_util_double_to_fraction(MAX(min_frame_rate, 0.), &min_numerator, &min_denominator);
+        gst_util_double_to_fraction(max_frame_rate, &max_numerator, &max_denominator);
+        if (gst_util_fraction_compare(min_numerator, min_denominator, max_numerator, max_denominator) < 0)
         {
-            break;
+            g_value_init(framerate, GST_TYPE_FRACTION_RANGE);
+            gst_value_set_fraction_range_full(framerate,
+                                              min_numerator,
+                                              min_denominator,
+                                              max_numerator,
+                                              max_denominator);
         }
-    } while (VmbBoolFalse == acquisition_stop_done);
-    vimbasrc->camera.is_acquiring = false;
+        else
+        {
+            g_value_init(framerate, GST_TYPE_FRACTION);
+            gst_value_set_fraction(framerate, max_numerator, max_denominator);
+        }
+        return;
+    }
 
-    // Stop Capture Engine
-    GST_DEBUG_OBJECT(vimbasrc, "Stopping the capture engine");
-    result = VmbCaptureEnd(vimbasrc->camera.handle);
+    // Mark the framerate as variable because triggering causes a variable framerate
+    g_value_init(framerate, GST_TYPE_FRACTION);
+    gst_value_set_fraction(framerate, 0, 1);
+}
 
-    // Flush the capture queue
-    GST_DEBUG_OBJECT(vimbasrc, "Flushing the capture queue");
-    VmbCaptureQueueFlush(vimbasrc->camera.handle);
+/**
+ * @brief Sets the frame rate a free running camera delivers images at
+ *
+ * @param vimbasrc Provides the camera handle
+ * @param frame_rate The frame rate in Hz. Clamped to the range the camera supports, since the fractions advertised in
+ * the caps may round its limits slightly outwards
+ * @return Error code of the last Vimba call
+ */
+VmbError_t set_frame_rate(GstVimbaSrc *vimbasrc, double frame_rate)
+{
+    // SFNC cameras like Alvium only accept AcquisitionFrameRate while AcquisitionFrameRateEnable is set. Cameras without
+    // the feature always accept it
+    VmbError_t enable_result = VmbFeatureBoolSet(vimbasrc->camera.handle, "AcquisitionFrameRateEnable", VmbBoolTrue);
+    if (enable_result != VmbErrorSuccess && enable_result != VmbErrorNotFound)
+    {
+        GST_WARNING_OBJECT(vimbasrc,
+                           "Could not set \"AcquisitionFrameRateEnable\". Got error code: %s",
+                           ErrorCodeToMessage(enable_result));
+    }
 
+    const char *feature_name = "AcquisitionFrameRate";
+    double min_frame_rate = 0., max_frame_rate = 0.;
+    VmbError_t result =
+        VmbFeatureFloatRangeQuery(vimbasrc->camera.handle, feature_name, &min_frame_rate, &max_frame_rate);
+    if (result != VmbErrorSuccess)
+    {
+        feature_name = "AcquisitionFrameRateAbs";
+        result = VmbFeatureFloatRangeQuery(vimbasrc->camera.handle, feature_name, &min_frame_rate, &max_frame_rate);
+    }
+    if (result == VmbErrorSuccess)
+    {
+        frame_rate = CLAMP(frame_rate, min_frame_rate, max_frame_rate);
+        result = VmbFeatureFloatSet(vimbasrc->camera.handle, feature_name, frame_rate);
+    }
+
+    if (result == VmbErrorSuccess)
+    {
+        GST_INFO_OBJECT(vimbasrc, "Set \"%s\" to %f", feature_name, frame_rate);
+    }
     return result;
 }
 
-void VMB_CALL vimba_frame_callback(const VmbHandle_t camera_handle, VmbFrame_t *frame)
+/**
+ * @brief Determines the sizes along one axis offered in the caps reported by get_caps
+ *
+ * @param vimbasrc Provides the camera handle
+ * @param feature_name "Width" or "Height"
+ * @param roi_size Size of the ROI applied by set_roi along the axis. 0 if set_roi did not run yet
+ * @param size Uninitialized GValue that is set to a GST_TYPE_INT_RANGE from the smallest size the camera supports up to
+ * roi_size, since set_caps produces smaller sizes on the camera. The range steps by the increment of the feature. Set
+ * to the current feature value if roi_size is 0
+ */
+void query_size_range(GstVimbaSrc *vimbasrc, const char *feature_name, VmbInt64_t roi_size, GValue *size)
 {
-    UNUSED(camera_handle); // enable compilation while treating warning of unused vairable as error
-    GST_TRACE("Got Frame");
-    g_async_queue_push(frame->context[0], frame); // context[0] holds vimbasrc->filled_frame_queue
+    VmbInt64_t min_size = 0;
+    VmbError_t result = VmbFeatureIntRangeQuery(vimbasrc->camera.handle, feature_name, &min_size, NULL);
+    // Sizes that are not a multiple of the increment would be rejected by the camera in set_caps
+    VmbInt64_t increment = 1;
+    if (VmbFeatureIntIncrementQuery(vimbasrc->camera.handle, feature_name, &increment) != VmbErrorSuccess ||
+        increment < 1)
+    {
+        increment = 1;
+    }
+    // GStreamer requires both limits of a stepped range to be multiples of the step
+    min_size = (min_size + increment - 1) / increment * increment;
+    VmbInt64_t max_size = roi_size / increment * increment;
+    if (roi_size > 0 && result == VmbErrorSuccess && min_size > 0 && min_size < max_size)
+    {
+        g_value_init(size, GST_TYPE_INT_RANGE);
+        gst_value_set_int_range_step(size, (gint)min_size, (gint)max_size, (gint)increment);
+        return;
+    }
 
-    // requeueing the frame is done after it was consumed in vimbasrc_create
+    VmbInt64_t current_size = roi_size;
+    if (roi_size <= 0)
+    {
+        VmbFeatureIntGet(vimbasrc->camera.handle, feature_name, &current_size);
+    }
+    g_value_init(size, G_TYPE_INT);
+    g_value_set_int(size, (gint)current_size);
+}
+
+/**
+ * @brief Reads the binning or decimation value of one sensor axis
+ *
+ * @param vimbasrc Provides the camera handle
+ * @param features NULL terminated names of the features reducing the resolution along the axis in order of preference
+ * @return The value of the first feature the camera provides or 1 if it provides none
+ */
+VmbInt64_t get_subsampling_value(GstVimbaSrc *vimbasrc, const char *const *features)
+{
+    for (size_t i = 0; features[i] != NULL; i++)
+    {
+        VmbInt64_t value;
+        if (VmbFeatureIntGet(vimbasrc->camera.handle, features[i], &value) == VmbErrorSuccess)
+        {
+            return MAX(value, 1);
+        }
+    }
+    return 1;
+}
+
+/**
+ * @brief Reduces the resolution along one sensor axis by a factor with binning or decimation
+ *
+ * @param vimbasrc Provides the camera handle
+ * @param features NULL terminated names of the features reducing the resolution along the axis in order of preference
+ * @param initial_value Value of the feature before the element changed it. The factor is applied on top of it
+ * @param current_factor Factor that is currently applied. The feature is not written if the factor does not change
+ * @param factor The desired factor. Limited to the largest factor the camera supports
+ * @return The factor applied after the call. 1 if the camera provides none of the features
+ */
+VmbInt64_t set_subsampling_factor(GstVimbaSrc *vimbasrc,
+                                  const char *const *features,
+                                  VmbInt64_t initial_value,
+                                  VmbInt64_t current_factor,
+                                  VmbInt64_t factor)
+{
+    for (size_t i = 0; features[i] != NULL; i++)
+    {
+        VmbInt64_t max_value = 0;
+        if (VmbFeatureIntRangeQuery(vimbasrc->camera.handle, features[i], NULL, &max_value) != VmbErrorSuccess)
+        {
+            continue;
+        }
+        factor = CLAMP(factor, 1, MAX(max_value / MAX(initial_value, 1), 1));
+        if (factor == current_factor)
+        {
+            return current_factor;
+        }
+        VmbError_t result = VmbFeatureIntSet(vimbasrc->camera.handle, features[i], initial_value * factor);
+        if (result != VmbErrorSuccess)
+        {
+            GST_WARNING_OBJECT(vimbasrc,
+                               "Failed to set \"%s\" to %lld. Return code was: %s",
+                               features[i],
+                               initial_value * factor,
+                               ErrorCodeToMessage(result));
+            return current_factor;
+        }
+        GST_DEBUG_OBJECT(vimbasrc, "Set \"%s\" to %lld", features[i], initial_value * factor);
+        return factor;
+    }
+    return 1;
+}
+
+/**
+ * @brief Produces the negotiated image size from the ROI applied by set_roi
+ *
+ * The ROI is reduced by the largest binning or decimation factor that keeps it at least as large as the negotiated
+ * size. Remaining differences are cropped evenly from the borders of the reduced ROI
+ *
+ * @param vimbasrc Provides the camera handle and the applied ROI
+ * @param width The negotiated width
+ * @param height The negotiated height
+ * @return Error code of setting Width or Height
+ */
+VmbError_t set_output_size(GstVimbaSrc *vimbasrc, int width, int height)
+{
+    if (vimbasrc->roi.width <= 0 || vimbasrc->roi.height <= 0 || width <= 0 || height <= 0)
+    {
+        return VmbErrorSuccess;
+    }
+
+    // The offsets are reset first so the position of the previous ROI does not limit the new size
+    VmbFeatureIntSet(vimbasrc->camera.handle, "OffsetX", 0);
+    VmbFeatureIntSet(vimbasrc->camera.handle, "OffsetY", 0);
+
+    vimbasrc->roi.horizontal_factor = set_subsampling_factor(vimbasrc,
+                                                             horizontal_subsampling_features,
+                                                             vimbasrc->roi.initial_horizontal,
+                                                             vimbasrc->roi.horizontal_factor,
+                                                             vimbasrc->roi.width / width);
+    vimbasrc->roi.vertical_factor = set_subsampling_factor(vimbasrc,
+                                                           vertical_subsampling_features,
+                                                           vimbasrc->roi.initial_vertical,
+                                                           vimbasrc->roi.vertical_factor,
+                                                           vimbasrc->roi.height / height);
+    VmbInt64_t horizontal_factor = vimbasrc->roi.horizontal_factor;
+    VmbInt64_t vertical_factor = vimbasrc->roi.vertical_factor;
+
+    VmbError_t result = VmbFeatureIntSet(vimbasrc->camera.handle, "Width", width);
+    if (result != VmbErrorSuccess)
+    {
+        return result;
+    }
+    result = VmbFeatureIntSet(vimbasrc->camera.handle, "Height", height);
+    if (result != VmbErrorSuccess)
+    {
+        return result;
+    }
+
+    // The offsets of the ROI are given in pixels of the reduced resolution
+    VmbInt64_t offsetx =
+        vimbasrc->roi.offsetx / horizontal_factor + (vimbasrc->roi.width / horizontal_factor - width) / 2;
+    VmbInt64_t offsety = vimbasrc->roi.offsety / vertical_factor + (vimbasrc->roi.height / vertical_factor - height) / 2;
+    if (VmbFeatureIntSet(vimbasrc->camera.handle, "OffsetX", MAX(offsetx, 0)) != VmbErrorSuccess ||
+        VmbFeatureIntSet(vimbasrc->camera.handle, "OffsetY", MAX(offsety, 0)) != VmbErrorSuccess)
+    {
+        GST_WARNING_OBJECT(vimbasrc, "Could not center the reduced ROI at offset %lld, %lld", offsetx, offsety);
+    }
+
+    GST_INFO_OBJECT(vimbasrc,
+                    "Reduced %lld x %lld ROI to %d x %d pixels with binning or decimation factors %lld x %lld",
+                    vimbasrc->roi.width,
+                    vimbasrc->roi.height,
+                    width,
+                    height,
+                    horizontal_factor,
+                    vertical_factor);
+    return VmbErrorSuccess;
+}
+
+/**
+ * @brief Applies ROI properties that were changed while acquiring
+ *
+ * If only the offsets changed, they are written to the camera right away, which works on cameras that allow moving
+ * the ROI during the acquisition. Otherwise the acquisition is paused while set_roi applies the new ROI and the caps
+ * are renegotiated. The frames stay queued to the capture engine since the pool buffers fit the largest ROI
+ *
+ * @param vimbasrc Provides the camera handle, the ROI properties and the buffer pool
+ * @return true if the acquisition continues with the new ROI
+ */
+bool apply_roi_change(GstVimbaSrc *vimbasrc)
+{
+    // The offset properties refer to the ROI before binning or decimation was applied for the negotiated size
+    VmbInt64_t width = 0, height = 0;
+    VmbFeatureIntGet(vimbasrc->camera.handle, "Width", &width);
+    VmbFeatureIntGet(vimbasrc->camera.handle, "Height", &height);
+    if (vimbasrc->properties.width == vimbasrc->roi.width && vimbasrc->properties.height == vimbasrc->roi.height &&
+        vimbasrc->properties.offsetx >= 0 && vimbasrc->properties.offsety >= 0)
+    {
+        VmbInt64_t horizontal_factor = vimbasrc->roi.horizontal_factor;
+        VmbInt64_t vertical_factor = vimbasrc->roi.vertical_factor;
+        VmbInt64_t offsetx =
+            vimbasrc->properties.offsetx / horizontal_factor + (vimbasrc->roi.width / horizontal_factor - width) / 2;
+        VmbInt64_t offsety =
+            vimbasrc->properties.offsety / vertical_factor + (vimbasrc->roi.height / vertical_factor - height) / 2;
+        if (VmbFeatureIntSet(vimbasrc->camera.handle, "OffsetX", offsetx) == VmbErrorSuccess &&
+            VmbFeatureIntSet(vimbasrc->camera.handle, "OffsetY", offsety) == VmbErrorSuccess)
+        {
+            GST_DEBUG_OBJECT(vimbasrc, "Moved the ROI to offset %lld, %lld while acquiring", offsetx, offsety);
+            vimbasrc->roi.offsetx = vimbasrc->properties.offsetx;
+            vimbasrc->roi.offsety = vimbasrc->properties.offsety;
+            return true;
+        }
+        GST_DEBUG_OBJECT(vimbasrc, "Camera does not allow changing the offsets while acquiring");
+    }
+
+    GST_DEBUG_OBJECT(vimbasrc, "Pausing the acquisition to change the ROI");
+    pause_image_acquisition(vimbasrc);
+    set_roi(vimbasrc);
+    g_atomic_int_set(&vimbasrc->caps_invalidated, 1);
+
+    // The default negotiation calls set_caps if the caps changed, but not decide_allocation. The current pool is kept
+    GstBaseSrc *src = GST_BASE_SRC(vimbasrc);
+    if (!GST_BASE_SRC_GET_CLASS(src)->negotiate(src))
+    {
+        GST_ERROR_OBJECT(vimbasrc, "Could not negotiate caps for the changed ROI");
+        return false;
+    }
+
+    VmbInt64_t payload_size;
+    VmbError_t result = VmbFeatureIntGet(vimbasrc->camera.handle, "PayloadSize", &payload_size);
+    guint pool_size = GST_VIMBA_BUFFER_POOL(vimbasrc->pool)->payload_size;
+    if (result != VmbErrorSuccess || payload_size > (VmbInt64_t)pool_size)
+    {
+        GST_ERROR_OBJECT(vimbasrc,
+                         "Frames of %u bytes do not fit the \"PayloadSize\" of %lld bytes of the changed ROI",
+                         pool_size,
+                         payload_size);
+        return false;
+    }
+    vimbasrc->payload_size = (gsize)payload_size;
+    if (!setup_output_pool(vimbasrc))
+    {
+        return false;
+    }
+
+    result = start_image_acquisition(vimbasrc);
+    if (result != VmbErrorSuccess)
+    {
+        GST_ERROR_OBJECT(vimbasrc, "Could not restart acquisition. Experienced error: %s", ErrorCodeToMessage(result));
+        return false;
+    }
+    return true;
+}
+
+/**
+ * @brief Determines the PayloadSize of the current pixel format for the largest ROI the camera allows
+ *
+ * Chunk data appended to the image is assumed to keep its size
+ *
+ * @param vimbasrc Provides the camera handle and the negotiated format
+ * @param payload_size PayloadSize of the current ROI
+ * @return gsize The PayloadSize of the largest ROI, or payload_size if it could not be determined
+ */
+gsize query_max_payload_size(GstVimbaSrc *vimbasrc, VmbInt64_t payload_size)
+{
+    const VimbaGstFormatMatch_t *format_match = vimbasrc->conversion.format_match;
+    VmbInt64_t width, height, max_width, max_height;
+    if (format_match == NULL ||
+        VmbFeatureIntGet(vimbasrc->camera.handle, "Width", &width) != VmbErrorSuccess ||
+        VmbFeatureIntGet(vimbasrc->camera.handle, "Height", &height) != VmbErrorSuccess)
+    {
+        return (gsize)payload_size;
+    }
+    // WidthMax and HeightMax do not depend on the offsets, but not every camera provides them
+    if ((VmbFeatureIntGet(vimbasrc->camera.handle, "WidthMax", &max_width) != VmbErrorSuccess &&
+         VmbFeatureIntRangeQuery(vimbasrc->camera.handle, "Width", NULL, &max_width) != VmbErrorSuccess) ||
+        (VmbFeatureIntGet(vimbasrc->camera.handle, "HeightMax", &max_height) != VmbErrorSuccess &&
+         VmbFeatureIntRangeQuery(vimbasrc->camera.handle, "Height", NULL, &max_height) != VmbErrorSuccess))
+    {
+        return (gsize)payload_size;
+    }
+    // Binning or decimation applied for the negotiated size is undone when the ROI changes
+    max_width *= vimbasrc->roi.horizontal_factor;
+    max_height *= vimbasrc->roi.vertical_factor;
+
+    gsize image_size = vimba_format_payload_size(format_match->vimba_format, (guint)width, (guint)height);
+    gsize max_image_size = vimba_format_payload_size(format_match->vimba_format, (guint)max_width, (guint)max_height);
+    if (image_size > (gsize)payload_size || max_image_size <= image_size)
+    {
+        return (gsize)payload_size;
+    }
+    return (gsize)payload_size - image_size + max_image_size;
+}
+
+/**
+ * @brief Sets up the pool providing the buffers that frames are converted or copied into for the negotiated format and
+ * the current PayloadSize. The current pool is kept if its buffers already have the required size
+ *
+ * @param vimbasrc Provides the negotiated conversion and the PayloadSize
+ * @return true if the pool is active
+ */
+bool setup_output_pool(GstVimbaSrc *vimbasrc)
+{
+    // Converted images are written with the default strides of the negotiated format. Copied frames keep chunk data
+    // appended to the image
+    const VimbaGstFormatMatch_t *format_match = vimbasrc->conversion.format_match;
+    gsize size = format_match != NULL && format_match->convert != NULL
+                     ? gst_format_image_size(format_match->gst_format,
+                                             vimbasrc->conversion.width,
+                                             vimbasrc->conversion.height)
+                     : vimbasrc->payload_size;
+    if (vimbasrc->output_pool != NULL && vimbasrc->output_size == size)
+    {
+        return true;
+    }
+    if (vimbasrc->output_pool != NULL)
+    {
+        // Buffers of the previous pool that are still used downstream are freed once they are released
+        gst_buffer_pool_set_active(vimbasrc->output_pool, FALSE);
+        gst_clear_object(&vimbasrc->output_pool);
+    }
+    vimbasrc->output_size = 0;
+
+    // Buffers are allocated as downstream holds on to them and are reused once released, so large images do not cause
+    // an allocation for every frame
+    GST_DEBUG_OBJECT(vimbasrc, "Creating output buffer pool with buffers of %" G_GSIZE_FORMAT " bytes", size);
+    GstBufferPool *pool = gst_buffer_pool_new();
+    GstStructure *config = gst_buffer_pool_get_config(pool);
+    gst_buffer_pool_config_set_params(config, NULL, (guint)size, 0, 0);
+    if (!gst_buffer_pool_set_config(pool, config) || !gst_buffer_pool_set_active(pool, TRUE))
+    {
+        GST_ERROR_OBJECT(vimbasrc, "Could not activate output buffer pool");
+        gst_object_unref(pool);
+        return false;
+    }
+    vimbasrc->output_pool = pool;
+    vimbasrc->output_size = size;
+
+    return true;
+}
+
+/**
+ * @brief Gets a buffer that a frame can be converted or copied into
+ *
+ * @param vimbasrc Provides the output buffer pool
+ * @param size Required size of the buffer
+ * @return GstBuffer* A buffer of the output pool, or a newly allocated buffer if the pool buffers do not have the
+ * required size
+ */
+GstBuffer *acquire_output_buffer(GstVimbaSrc *vimbasrc, gsize size)
+{
+    GstBuffer *buffer = NULL;
+    if (vimbasrc->output_pool != NULL && vimbasrc->output_size == size &&
+        gst_buffer_pool_acquire_buffer(vimbasrc->output_pool, &buffer, NULL) == GST_FLOW_OK)
+    {
+        return buffer;
+    }
+    GST_DEBUG_OBJECT(vimbasrc, "No output buffer of %" G_GSIZE_FORMAT " bytes in the pool. Allocating one", size);
+    return gst_buffer_new_and_alloc(size);
+}
+
+/**
+ * @brief Checks whether a GST_TYPE_LIST of strings holds a given string
+ *
+ * @param list The list to search
+ * @param string The string to search for
+ * @return true if one of the list entries equals string
+ */
+bool value_list_contains_string(const GValue *list, const char *string)
+{
+    for (guint i = 0; i < gst_value_list_get_size(list); i++)
+    {
+        if (strcmp(g_value_get_string(gst_value_list_get_value(list, i)), string) == 0)
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+/**
+ * @brief Determines how many bytes per second the link between camera and host transfers
+ *
+ * The throughput limit configured on the camera is used if it is active. Otherwise the link speed is the bound
+ *
+ * @param vimbasrc Provides the camera handle
+ * @return The link throughput in bytes per second or 0 if the camera does not report it
+ */
+VmbInt64_t get_link_throughput(GstVimbaSrc *vimbasrc)
+{
+    VmbInt64_t throughput = 0;
+    const char *limit_mode = NULL;
+    // Cameras without DeviceLinkThroughputLimitMode always apply their limit
+    bool is_limited = VmbFeatureEnumGet(vimbasrc->camera.handle, "DeviceLinkThroughputLimitMode", &limit_mode) !=
+                          VmbErrorSuccess ||
+                      strcmp(limit_mode, "On") == 0;
+    if (is_limited &&
+        (VmbFeatureIntGet(vimbasrc->camera.handle, "DeviceLinkThroughputLimit", &throughput) == VmbErrorSuccess ||
+         VmbFeatureIntGet(vimbasrc->camera.handle, "StreamBytesPerSecond", &throughput) == VmbErrorSuccess) &&
+        throughput > 0)
+    {
+        return throughput;
+    }
+    if (VmbFeatureIntGet(vimbasrc->camera.handle, "DeviceLinkSpeed", &throughput) == VmbErrorSuccess && throughput > 0)
+    {
+        return throughput;
+    }
+    return 0;
+}
+
+/**
+ * @brief Chooses the Vimba pixel format providing the format of the negotiated caps according to the formatselection
+ * property
+ *
+ * With "SmallestWireSize" the bandwidth each candidate needs at the negotiated frame rate (or the frame rate of the
+ * camera if the caps do not fix one) is compared with the link throughput. Among the formats the link sustains the one
+ * with the most significant bits is used. If the throughput or the frame rate is unknown or no format is sustained,
+ * the format with the smallest wire size is used. Remaining ties prefer formats that are not converted in the element
+ *
+ * @param vimbasrc Provides the camera handle, the supported formats and the selection policy
+ * @param structure The structure of the negotiated caps holding the format, size and frame rate
+ * @return The selected format or NULL if the camera supports no format matching the negotiated one
+ */
+const VimbaGstFormatMatch_t *select_format_match(GstVimbaSrc *vimbasrc, const GstStructure *structure)
+{
+    const char *gst_format = gst_structure_get_string(structure, "format");
+    const GstFormatInfo_t *gst_format_info = gst_format != NULL ? gst_format_from_name(gst_format) : NULL;
+    if (gst_format_info == NULL)
+    {
+        return NULL;
+    }
+
+    // Bytes per second the link transfers and frames per second the camera delivers. 0 if unknown
+    double link_throughput = 0.;
+    double frame_rate = 0.;
+    int width = 0, height = 0;
+    if (vimbasrc->properties.format_selection == GST_VIMBASRC_FORMAT_SELECTION_SMALLEST_WIRE_SIZE)
+    {
+        link_throughput = (double)get_link_throughput(vimbasrc);
+
+        int framerate_numerator = 0, framerate_denominator = 0;
+        gst_structure_get_int(structure, "width", &width);
+        gst_structure_get_int(structure, "height", &height);
+        if (gst_structure_get_fraction(structure, "framerate", &framerate_numerator, &framerate_denominator) &&
+            framerate_numerator > 0 && framerate_denominator > 0)
+        {
+            frame_rate = (double)framerate_numerator / framerate_denominator;
+        }
+        else if (VmbFeatureFloatGet(vimbasrc->camera.handle, "AcquisitionFrameRate", &frame_rate) != VmbErrorSuccess &&
+                 VmbFeatureFloatGet(vimbasrc->camera.handle, "AcquisitionFrameRateAbs", &frame_rate) != VmbErrorSuccess)
+        {
+            frame_rate = 0.;
+        }
+        frame_rate = MAX(frame_rate, 0.);
+        GST_DEBUG_OBJECT(vimbasrc,
+                         "Selecting format for %d x %d pixels at %.3f fps over a link with %.0f bytes per second",
+                         width,
+                         height,
+                         frame_rate,
+                         link_throughput);
+    }
+
+    const VimbaGstFormatMatch_t *format_match = NULL;
+    bool is_sustained = false;
+    for (unsigned int i = 0; i < vimbasrc->camera.supported_formats_count; i++)
+    {
+        const VimbaGstFormatMatch_t *candidate = vimbasrc->camera.supported_formats[i];
+        if (candidate->gst_format != gst_format_info)
+        {
+            continue;
+        }
+        const VimbaFormatInfo_t *vimba_format = candidate->vimba_format;
+        guint wire_bits = vimba_format->bits_per_pixel;
+        double bandwidth =
+            frame_rate * (double)vimba_format_payload_size(vimba_format, (guint)MAX(width, 0), (guint)MAX(height, 0));
+        bool candidate_is_sustained = link_throughput > 0. && bandwidth > 0. && bandwidth <= link_throughput;
+        GST_DEBUG_OBJECT(vimbasrc,
+                         "Found matching vimba pixel format \"%s\" with %u bits per pixel on the wire",
+                         vimba_format->name,
+                         wire_bits);
+
+        bool is_preferred = format_match == NULL;
+        if (!is_preferred)
+        {
+            switch (vimbasrc->properties.format_selection)
+            {
+            case GST_VIMBASRC_FORMAT_SELECTION_SMALLEST_WIRE_SIZE:
+            {
+                guint selected_wire_bits = format_match->vimba_format->bits_per_pixel;
+                guint selected_bit_depth = format_match->vimba_format->bit_depth;
+                if (candidate_is_sustained != is_sustained)
+                {
+                    is_preferred = candidate_is_sustained;
+                }
+                else if (is_sustained && vimba_format->bit_depth != selected_bit_depth)
+                {
+                    is_preferred = vimba_format->bit_depth > selected_bit_depth;
+                }
+                else if (wire_bits != selected_wire_bits)
+                {
+                    is_preferred = wire_bits < selected_wire_bits;
+                }
+                else if (vimba_format->bit_depth != selected_bit_depth)
+                {
+                    is_preferred = vimba_format->bit_depth > selected_bit_depth;
+                }
+                else
+                {
+                    is_preferred = format_match_is_converted(format_match) && !format_match_is_converted(candidate);
+                }
+                break;
+            }
+            case GST_VIMBASRC_FORMAT_SELECTION_NO_CONVERSION:
+                is_preferred = format_match_is_converted(format_match) && !format_match_is_converted(candidate);
+                break;
+            default:
+                break;
+            }
+        }
+        if (is_preferred)
+        {
+            format_match = candidate;
+            is_sustained = candidate_is_sustained;
+        }
+    }
+
+    if (format_match != NULL)
+    {
+        GST_INFO_OBJECT(vimbasrc,
+                        "Selected vimba pixel format \"%s\" for GStreamer format \"%s\"",
+                        format_match->vimba_format->name,
+                        gst_format);
+        if (link_throughput > 0. && frame_rate > 0. && !is_sustained)
+        {
+            GST_WARNING_OBJECT(vimbasrc,
+                               "No pixel format for \"%s\" fits the link throughput of %.0f bytes per second at the "
+                               "frame rate. The camera will deliver fewer frames",
+                               gst_format,
+                               link_throughput);
+        }
+    }
+    return format_match;
 }
 
 /**
@@ -1938,23 +4008,27 @@ void map_supported_pixel_formats(GstVimbaSrc *vimbasrc)
         NULL);
 
     GST_DEBUG_OBJECT(vimbasrc, "Camera returned %d supported formats", camera_format_count);
+    GPtrArray *format_match_array = g_ptr_array_new();
     VmbBool_t is_available;
     for (unsigned int i = 0; i < camera_format_count; i++)
     {
         VmbFeatureEnumIsAvailable(vimbasrc->camera.handle, "PixelFormat", supported_formats[i], &is_available);
         if (is_available)
         {
-            const VimbaGstFormatMatch_t *format_map = gst_format_from_vimba_format(supported_formats[i]);
-            if (format_map != NULL)
+            // Most formats may be converted into more than one GStreamer format
+            const VimbaFormatInfo_t *vimba_format = vimba_format_from_name(supported_formats[i]);
+            guint match_count = 0;
+            const VimbaGstFormatMatch_t *const *format_matches =
+                vimba_format != NULL ? vimba_format_get_matches(vimba_format, &match_count) : NULL;
+            for (unsigned int j = 0; j < match_count; j++)
             {
                 GST_DEBUG_OBJECT(vimbasrc,
                                  "Vimba format \"%s\" corresponds to GStreamer format \"%s\"",
                                  supported_formats[i],
-                                 format_map->gst_format_name);
-                vimbasrc->camera.supported_formats[vimbasrc->camera.supported_formats_count] = format_map;
-                vimbasrc->camera.supported_formats_count++;
+                                 format_matches[j]->gst_format->name);
+                g_ptr_array_add(format_match_array, (gpointer)format_matches[j]);
             }
-            else
+            if (match_count == 0)
             {
                 GST_DEBUG_OBJECT(vimbasrc,
                                  "No corresponding GStreamer format found for vimba format \"%s\"",
@@ -1967,6 +4041,11 @@ void map_supported_pixel_formats(GstVimbaSrc *vimbasrc)
         }
     }
     free((void *)supported_formats);
+
+    // Only as many entries are kept as the camera actually supports
+    g_free(vimbasrc->camera.supported_formats);
+    vimbasrc->camera.supported_formats_count = format_match_array->len;
+    vimbasrc->camera.supported_formats = (const VimbaGstFormatMatch_t **)g_ptr_array_free(format_match_array, FALSE);
 }
 
 void log_available_enum_entries(GstVimbaSrc *vimbasrc, const char *feat_name)
@@ -20,6 +20,9 @@
 #define _GST_vimbasrc_H_
 
 #include "pixelformats.h"
+#include "framequeue.h"
+#include "framestats.h"
+#include "timestampmapping.h"
 
 #include <gst/base/gstpushsrc.h>
 #include <glib.h>
@@ -137,11 +140,47 @@ typedef enum
     GST_VIMBASRC_INCOMPLETE_FRAME_HANDLING_SUBMIT
 } GstVimbasrcIncompleteFrameHandlingValue;
 
+// Sources for the timestamps of the output buffers
+typedef enum
+{
+    GST_VIMBASRC_TIMESTAMP_MODE_PIPELINE,
+    GST_VIMBASRC_TIMESTAMP_MODE_CAMERA
+} GstVimbasrcTimestampModeValue;
+
+// Policies for dropping frames if the streaming thread falls behind the camera
+typedef enum
+{
+    GST_VIMBASRC_LEAKY_NONE,
+    GST_VIMBASRC_LEAKY_UPSTREAM,
+    GST_VIMBASRC_LEAKY_DOWNSTREAM
+} GstVimbasrcLeakyValue;
+
+// Placement of the significant bits of GRAY16_LE pixels from formats with less than 16 bits
+typedef enum
+{
+    GST_VIMBASRC_BIT_DEPTH_SCALING_NONE = BIT_DEPTH_SCALING_NONE,
+    GST_VIMBASRC_BIT_DEPTH_SCALING_SHIFT = BIT_DEPTH_SCALING_SHIFT,
+    GST_VIMBASRC_BIT_DEPTH_SCALING_SCALE = BIT_DEPTH_SCALING_SCALE
+} GstVimbasrcBitDepthScalingValue;
+
+// Interpolation methods for demosaicing Bayer formats in the element
+typedef enum
+{
+    GST_VIMBASRC_DEBAYER_METHOD_BILINEAR = DEBAYER_METHOD_BILINEAR,
+    GST_VIMBASRC_DEBAYER_METHOD_EDGE_AWARE = DEBAYER_METHOD_EDGE_AWARE
+} GstVimbasrcDebayerMethodValue;
+
+// Policies for choosing between the Vimba formats that provide the same GStreamer format
+typedef enum
+{
+    GST_VIMBASRC_FORMAT_SELECTION_FIRST,
+    GST_VIMBASRC_FORMAT_SELECTION_SMALLEST_WIRE_SIZE,
+    GST_VIMBASRC_FORMAT_SELECTION_NO_CONVERSION
+} GstVimbasrcFormatSelectionValue;
+
 typedef struct _GstVimbaSrc GstVimbaSrc;
 typedef struct _GstVimbaSrcClass GstVimbaSrcClass;
 
-#define NUM_VIMBA_FRAMES 3
-
 struct _GstVimbaSrc
 {
     GstPushSrc base_vimbasrc;
@@ -151,11 +190,17 @@ struct _GstVimbaSrc
         char *id;
         VmbHandle_t handle;
         VmbUint32_t supported_formats_count;
-        // TODO: This overallocates since no camera will actually support all possible format matches. Allocate and fill
-        // at runtime?
-        const VimbaGstFormatMatch_t *supported_formats[NUM_FORMAT_MATCHES];
+        // Format matches of the formats the camera provides. Allocated by map_supported_pixel_formats to hold exactly
+        // supported_formats_count entries
+        const VimbaGstFormatMatch_t **supported_formats;
         bool is_connected;
+        // Set while the capture engine runs with the frames of the pool queued to it
+        bool is_capturing;
+        // Set while the camera runs the acquisition. Cleared by pause_image_acquisition while the capture engine keeps
+        // running
         bool is_acquiring;
+        // Frequency (in Hz) of the ticks in which the camera reports frame timestamps
+        VmbInt64_t timestamp_frequency;
     } camera;
     struct
     {
@@ -173,12 +218,99 @@ struct _GstVimbaSrc
         int triggersource;
         int triggeractivation;
         int incomplete_frame_handling;
+        int timestamp_mode;
+        int leaky;
+        int bit_depth_scaling;
+        int debayer_method;
+        guint debayer_threads;
+        int format_selection;
+        bool zerocopy;
+        guint num_frame_buffers;
+        bool adaptive_frame_buffers;
+        guint frame_buffer_memory_limit;
+        guint stats_interval;
     } properties;
 
-    VmbFrame_t frame_buffers[NUM_VIMBA_FRAMES];
+    // Sensor region applied by set_roi from the width, height and offset properties. Smaller negotiated sizes are
+    // produced from it by set_caps with binning or decimation and cropping. width and height are 0 until set_roi ran
+    struct
+    {
+        VmbInt64_t offsetx;
+        VmbInt64_t offsety;
+        VmbInt64_t width;
+        VmbInt64_t height;
+        // Binning or decimation values found on the camera by set_roi
+        VmbInt64_t initial_horizontal;
+        VmbInt64_t initial_vertical;
+        // Factors set_caps applied on top of the initial values. 1 if the features are left unchanged
+        VmbInt64_t horizontal_factor;
+        VmbInt64_t vertical_factor;
+    } roi;
+
+    // Conversion of the image data in create required by the format negotiated in set_caps
+    struct
+    {
+        // NULL until caps are negotiated
+        const VimbaGstFormatMatch_t *format_match;
+        // Significant bits of GRAY16_LE pixels that are placed according to the bitdepthscaling property. 0 if the
+        // pixels already use 16 bits or the output format is not GRAY16_LE
+        guint scaled_bit_depth;
+        // Negotiated size. Frames of another size were captured before the ROI changed and are dropped
+        guint width;
+        guint height;
+    } conversion;
+    // Distributes demosaicing over multiple threads. Created in create once a Bayer format is demosaiced
+    Debayer_t *debayer;
+
+    // Allocates the frame memory and keeps it announced to Vimba for as long as the camera is open
+    GstAllocator *allocator;
+    // Pool of buffers holding the Vimba frames. Proposed to GstBaseSrc in decide_allocation
+    GstBufferPool *pool;
+    // PayloadSize of the current ROI. The pool buffers are sized for the largest ROI and resized to it in create
+    gsize payload_size;
+    // Pool of the buffers that frames are converted or copied into in create. Set up in decide_allocation and again
+    // when the ROI changed while playing
+    GstBufferPool *output_pool;
+    // Size of the output_pool buffers
+    gsize output_size;
+    // Number of consecutive frames for which at least numframebuffers frames were queued for capturing. Used to shrink
+    // the pool if adaptiveframebuffers is enabled
+    guint idle_frame_count;
     // queue in which filled Vimba frames are placed in the vimba_frame_callback (attached to each queued frame at
     // frame->context[0])
-    GAsyncQueue *filled_frame_queue;
+    FrameQueue_t *filled_frame_queue;
+    // Maps camera frame timestamps to pipeline clock times if timestampmode is Camera
+    TimestampMapping_t timestamp_mapping;
+    // Latency reported in the LATENCY query (protected by the object lock). min is GST_CLOCK_TIME_NONE until it was
+    // determined from the camera features
+    struct
+    {
+        GstClockTime min;
+        GstClockTime max;
+    } latency;
+    // Set (atomically) if a camera feature or the number of frames affecting the latency changed
+    gint latency_invalidated;
+    // Caps built from the camera settings by get_caps. Protected by the object lock. NULL until the caps are first
+    // queried with a connected camera
+    GstCaps *camera_caps;
+    // Set (atomically) if a camera feature the caps are built from changed
+    gint caps_invalidated;
+    // Set (atomically) if the ROI properties changed since they were applied. The new ROI is applied in create
+    gint roi_invalidated;
+    // Statistics since the element was started. Exposed via the read-only stats and frame count properties
+    FrameStats_t stats;
+    // Monotonic time and number of delivered frames at the start of the current frame rate measurement window. Only
+    // accessed by the streaming thread
+    struct
+    {
+        GstClockTime start;
+        gsize delivered_count;
+    } stats_window;
+    // Monotonic time at which the last stats message was posted
+    GstClockTime last_stats_message;
+    // ID of the last frame that reached create. Gaps in the frame IDs indicate frames that were lost on the way
+    VmbUint64_t last_frame_id;
+    bool has_last_frame_id;
 };
 
 struct _GstVimbaSrcClass
@@ -192,13 +324,44 @@ G_END_DECLS
 
 VmbError_t open_camera_connection(GstVimbaSrc *vimbasrc);
 VmbError_t apply_feature_settings(GstVimbaSrc *vimbasrc);
+VmbError_t apply_exposure_time(GstVimbaSrc *vimbasrc);
+VmbError_t apply_gain(GstVimbaSrc *vimbasrc);
+VmbError_t apply_auto_feature(GstVimbaSrc *vimbasrc, const char *feature_name, GType enum_type, int value);
 VmbError_t set_roi(GstVimbaSrc *vimbasrc);
 VmbError_t apply_trigger_settings(GstVimbaSrc *vimbasrc);
-VmbError_t alloc_and_announce_buffers(GstVimbaSrc *vimbasrc);
-void revoke_and_free_buffers(GstVimbaSrc *vimbasrc);
 VmbError_t start_image_acquisition(GstVimbaSrc *vimbasrc);
 VmbError_t stop_image_acquisition(GstVimbaSrc *vimbasrc);
+VmbError_t pause_image_acquisition(GstVimbaSrc *vimbasrc);
+VmbError_t run_command_feature(GstVimbaSrc *vimbasrc, const char *feature_name);
+bool apply_roi_change(GstVimbaSrc *vimbasrc);
+gsize query_max_payload_size(GstVimbaSrc *vimbasrc, VmbInt64_t payload_size);
+bool setup_output_pool(GstVimbaSrc *vimbasrc);
+GstBuffer *acquire_output_buffer(GstVimbaSrc *vimbasrc, gsize size);
 void VMB_CALL vimba_frame_callback(const VmbHandle_t cameraHandle, VmbFrame_t *pFrame);
+void adapt_frame_buffer_count(GstVimbaSrc *vimbasrc);
+void query_timestamp_frequency(GstVimbaSrc *vimbasrc);
+GstClockTime get_camera_running_time(GstVimbaSrc *vimbasrc, VmbFrame_t *frame);
+void update_latency(GstVimbaSrc *vimbasrc);
+void track_frame_id(GstVimbaSrc *vimbasrc, VmbFrame_t *frame);
+void count_dropped_frames(GstVimbaSrc *vimbasrc, guint64 dropped_count);
+void count_delivered_frame(GstVimbaSrc *vimbasrc, GstClockTime receive_time);
+GstStructure *create_stats_structure(GstVimbaSrc *vimbasrc);
+void VMB_CALL latency_feature_invalidated(const VmbHandle_t camera_handle, const char *name, void *user_context);
+void VMB_CALL caps_feature_invalidated(const VmbHandle_t camera_handle, const char *name, void *user_context);
+GstCaps *query_camera_caps(GstVimbaSrc *vimbasrc);
+void query_framerate_range(GstVimbaSrc *vimbasrc, GValue *framerate);
+VmbError_t set_frame_rate(GstVimbaSrc *vimbasrc, double frame_rate);
+void query_size_range(GstVimbaSrc *vimbasrc, const char *feature_name, VmbInt64_t roi_size, GValue *size);
+VmbInt64_t get_subsampling_value(GstVimbaSrc *vimbasrc, const char *const *features);
+VmbInt64_t set_subsampling_factor(GstVimbaSrc *vimbasrc,
+                                  const char *const *features,
+                                  VmbInt64_t initial_value,
+                                  VmbInt64_t current_factor,
+                                  VmbInt64_t factor);
+VmbError_t set_output_size(GstVimbaSrc *vimbasrc, int width, int height);
+bool value_list_contains_string(const GValue *list, const char *string);
+VmbInt64_t get_link_throughput(GstVimbaSrc *vimbasrc);
+const VimbaGstFormatMatch_t *select_format_match(GstVimbaSrc *vimbasrc, const GstStructure *structure);
 void map_supported_pixel_formats(GstVimbaSrc *vimbasrc);
 void log_available_enum_entries(GstVimbaSrc *vimbasrc, const char *feat_name);
 
@@ -7,7 +7,7 @@
 // Dummy use for currently unused objects to allow compilation while treating warnings as errors
 #define UNUSED(x) (void)(x)
 
-bool starts_with(const char *str, const char *prefix)
+static inline bool starts_with(const char *str, const char *prefix)
 {
     return strncmp(str, prefix, strlen(prefix)) == 0;
 }
@@ -1,29 +1,371 @@
 #include "pixelformats.h"
-#include <stddef.h>
-#include <string.h>
 
-const VimbaGstFormatMatch_t *gst_format_from_vimba_format(const char *vimba_format)
+// TODO: Check if same capitalization as below for the vimba capabilities is guaranteed
+const VimbaFormatInfo_t vimba_formats[NUM_VIMBA_FORMATS] = {
+    [VIMBA_FORMAT_MONO8] = {"Mono8", 8, 8, PACKED_FORMAT_NONE, BAYER_PATTERN_NONE, YUV_PACKING_NONE},
+    [VIMBA_FORMAT_MONO10] = {"Mono10", 16, 10, PACKED_FORMAT_NONE, BAYER_PATTERN_NONE, YUV_PACKING_NONE},
+    [VIMBA_FORMAT_MONO12] = {"Mono12", 16, 12, PACKED_FORMAT_NONE, BAYER_PATTERN_NONE, YUV_PACKING_NONE},
+    [VIMBA_FORMAT_MONO14] = {"Mono14", 16, 14, PACKED_FORMAT_NONE, BAYER_PATTERN_NONE, YUV_PACKING_NONE},
+    [VIMBA_FORMAT_MONO16] = {"Mono16", 16, 16, PACKED_FORMAT_NONE, BAYER_PATTERN_NONE, YUV_PACKING_NONE},
+    [VIMBA_FORMAT_MONO10P] = {"Mono10p", 10, 10, PACKED_FORMAT_MONO10P, BAYER_PATTERN_NONE, YUV_PACKING_NONE},
+    [VIMBA_FORMAT_MONO12P] = {"Mono12p", 12, 12, PACKED_FORMAT_MONO12P, BAYER_PATTERN_NONE, YUV_PACKING_NONE},
+    [VIMBA_FORMAT_MONO12PACKED] = {"Mono12Packed", 12, 12, PACKED_FORMAT_MONO12PACKED, BAYER_PATTERN_NONE, YUV_PACKING_NONE},
+    [VIMBA_FORMAT_RGB8] = {"RGB8", 24, 8, PACKED_FORMAT_NONE, BAYER_PATTERN_NONE, YUV_PACKING_NONE},
+    [VIMBA_FORMAT_RGB8PACKED] = {"RGB8Packed", 24, 8, PACKED_FORMAT_NONE, BAYER_PATTERN_NONE, YUV_PACKING_NONE},
+    [VIMBA_FORMAT_BGR8] = {"BGR8", 24, 8, PACKED_FORMAT_NONE, BAYER_PATTERN_NONE, YUV_PACKING_NONE},
+    [VIMBA_FORMAT_BGR8PACKED] = {"BGR8Packed", 24, 8, PACKED_FORMAT_NONE, BAYER_PATTERN_NONE, YUV_PACKING_NONE},
+    [VIMBA_FORMAT_ARGB8] = {"Argb8", 32, 8, PACKED_FORMAT_NONE, BAYER_PATTERN_NONE, YUV_PACKING_NONE},
+    [VIMBA_FORMAT_RGBA8] = {"Rgba8", 32, 8, PACKED_FORMAT_NONE, BAYER_PATTERN_NONE, YUV_PACKING_NONE},
+    [VIMBA_FORMAT_BGRA8] = {"Bgra8", 32, 8, PACKED_FORMAT_NONE, BAYER_PATTERN_NONE, YUV_PACKING_NONE},
+    [VIMBA_FORMAT_YUV411] = {"Yuv411", 12, 8, PACKED_FORMAT_NONE, BAYER_PATTERN_NONE, YUV_PACKING_411},
+    [VIMBA_FORMAT_YUV411PACKED] = {"YUV411Packed", 12, 8, PACKED_FORMAT_NONE, BAYER_PATTERN_NONE, YUV_PACKING_411},
+    [VIMBA_FORMAT_YCBCR411_8_CBYYCRYY] = {"YCbCr411_8_CbYYCrYY", 12, 8, PACKED_FORMAT_NONE, BAYER_PATTERN_NONE, YUV_PACKING_411},
+    [VIMBA_FORMAT_YUV422] = {"Yuv422", 16, 8, PACKED_FORMAT_NONE, BAYER_PATTERN_NONE, YUV_PACKING_422},
+    [VIMBA_FORMAT_YUV422PACKED] = {"YUV422Packed", 16, 8, PACKED_FORMAT_NONE, BAYER_PATTERN_NONE, YUV_PACKING_422},
+    [VIMBA_FORMAT_YCBCR422_8_CBYCRY] = {"YCbCr422_8_CbYCrY", 16, 8, PACKED_FORMAT_NONE, BAYER_PATTERN_NONE, YUV_PACKING_422},
+    [VIMBA_FORMAT_YUV444] = {"Yuv444", 24, 8, PACKED_FORMAT_NONE, BAYER_PATTERN_NONE, YUV_PACKING_NONE},
+    [VIMBA_FORMAT_YUV444PACKED] = {"YUV444Packed", 24, 8, PACKED_FORMAT_NONE, BAYER_PATTERN_NONE, YUV_PACKING_NONE},
+    [VIMBA_FORMAT_YCBCR8_CBYCR] = {"YCbCr8_CbYCr", 24, 8, PACKED_FORMAT_NONE, BAYER_PATTERN_NONE, YUV_PACKING_NONE},
+    [VIMBA_FORMAT_BAYERGR8] = {"BayerGR8", 8, 8, PACKED_FORMAT_NONE, BAYER_PATTERN_GRBG, YUV_PACKING_NONE},
+    [VIMBA_FORMAT_BAYERRG8] = {"BayerRG8", 8, 8, PACKED_FORMAT_NONE, BAYER_PATTERN_RGGB, YUV_PACKING_NONE},
+    [VIMBA_FORMAT_BAYERGB8] = {"BayerGB8", 8, 8, PACKED_FORMAT_NONE, BAYER_PATTERN_GBRG, YUV_PACKING_NONE},
+    [VIMBA_FORMAT_BAYERBG8] = {"BayerBG8", 8, 8, PACKED_FORMAT_NONE, BAYER_PATTERN_BGGR, YUV_PACKING_NONE},
+    [VIMBA_FORMAT_BAYERGR10] = {"BayerGR10", 16, 10, PACKED_FORMAT_NONE, BAYER_PATTERN_GRBG, YUV_PACKING_NONE},
+    [VIMBA_FORMAT_BAYERRG10] = {"BayerRG10", 16, 10, PACKED_FORMAT_NONE, BAYER_PATTERN_RGGB, YUV_PACKING_NONE},
+    [VIMBA_FORMAT_BAYERGB10] = {"BayerGB10", 16, 10, PACKED_FORMAT_NONE, BAYER_PATTERN_GBRG, YUV_PACKING_NONE},
+    [VIMBA_FORMAT_BAYERBG10] = {"BayerBG10", 16, 10, PACKED_FORMAT_NONE, BAYER_PATTERN_BGGR, YUV_PACKING_NONE},
+    [VIMBA_FORMAT_BAYERGR10P] = {"BayerGR10p", 10, 10, PACKED_FORMAT_MONO10P, BAYER_PATTERN_GRBG, YUV_PACKING_NONE},
+    [VIMBA_FORMAT_BAYERRG10P] = {"BayerRG10p", 10, 10, PACKED_FORMAT_MONO10P, BAYER_PATTERN_RGGB, YUV_PACKING_NONE},
+    [VIMBA_FORMAT_BAYERGB10P] = {"BayerGB10p", 10, 10, PACKED_FORMAT_MONO10P, BAYER_PATTERN_GBRG, YUV_PACKING_NONE},
+    [VIMBA_FORMAT_BAYERBG10P] = {"BayerBG10p", 10, 10, PACKED_FORMAT_MONO10P, BAYER_PATTERN_BGGR, YUV_PACKING_NONE},
+    [VIMBA_FORMAT_BAYERGR12] = {"BayerGR12", 16, 12, PACKED_FORMAT_NONE, BAYER_PATTERN_GRBG, YUV_PACKING_NONE},
+    [VIMBA_FORMAT_BAYERRG12] = {"BayerRG12", 16, 12, PACKED_FORMAT_NONE, BAYER_PATTERN_RGGB, YUV_PACKING_NONE},
+    [VIMBA_FORMAT_BAYERGB12] = {"BayerGB12", 16, 12, PACKED_FORMAT_NONE, BAYER_PATTERN_GBRG, YUV_PACKING_NONE},
+    [VIMBA_FORMAT_BAYERBG12] = {"BayerBG12", 16, 12, PACKED_FORMAT_NONE, BAYER_PATTERN_BGGR, YUV_PACKING_NONE},
+    [VIMBA_FORMAT_BAYERGR12P] = {"BayerGR12p", 12, 12, PACKED_FORMAT_MONO12P, BAYER_PATTERN_GRBG, YUV_PACKING_NONE},
+    [VIMBA_FORMAT_BAYERRG12P] = {"BayerRG12p", 12, 12, PACKED_FORMAT_MONO12P, BAYER_PATTERN_RGGB, YUV_PACKING_NONE},
+    [VIMBA_FORMAT_BAYERGB12P] = {"BayerGB12p", 12, 12, PACKED_FORMAT_MONO12P, BAYER_PATTERN_GBRG, YUV_PACKING_NONE},
+    [VIMBA_FORMAT_BAYERBG12P] = {"BayerBG12p", 12, 12, PACKED_FORMAT_MONO12P, BAYER_PATTERN_BGGR, YUV_PACKING_NONE},
+    [VIMBA_FORMAT_BAYERGR12PACKED] = {"BayerGR12Packed", 12, 12, PACKED_FORMAT_MONO12PACKED, BAYER_PATTERN_GRBG, YUV_PACKING_NONE},
+    [VIMBA_FORMAT_BAYERRG12PACKED] = {"BayerRG12Packed", 12, 12, PACKED_FORMAT_MONO12PACKED, BAYER_PATTERN_RGGB, YUV_PACKING_NONE},
+    [VIMBA_FORMAT_BAYERGB12PACKED] = {"BayerGB12Packed", 12, 12, PACKED_FORMAT_MONO12PACKED, BAYER_PATTERN_GBRG, YUV_PACKING_NONE},
+    [VIMBA_FORMAT_BAYERBG12PACKED] = {"BayerBG12Packed", 12, 12, PACKED_FORMAT_MONO12PACKED, BAYER_PATTERN_BGGR, YUV_PACKING_NONE},
+    [VIMBA_FORMAT_BAYERGR16] = {"BayerGR16", 16, 16, PACKED_FORMAT_NONE, BAYER_PATTERN_GRBG, YUV_PACKING_NONE},
+    [VIMBA_FORMAT_BAYERRG16] = {"BayerRG16", 16, 16, PACKED_FORMAT_NONE, BAYER_PATTERN_RGGB, YUV_PACKING_NONE},
+    [VIMBA_FORMAT_BAYERGB16] = {"BayerGB16", 16, 16, PACKED_FORMAT_NONE, BAYER_PATTERN_GBRG, YUV_PACKING_NONE},
+    [VIMBA_FORMAT_BAYERBG16] = {"BayerBG16", 16, 16, PACKED_FORMAT_NONE, BAYER_PATTERN_BGGR, YUV_PACKING_NONE},
+};
+
+const GstFormatInfo_t gst_formats[NUM_OUTPUT_FORMATS] = {
+    [OUTPUT_FORMAT_GRAY8] = {"GRAY8", CAPS_MEDIA_TYPE_RAW, GST_VIDEO_FORMAT_GRAY8, PLANE_LAYOUT_PACKED, 8},
+    [OUTPUT_FORMAT_GRAY16_LE] = {"GRAY16_LE", CAPS_MEDIA_TYPE_RAW, GST_VIDEO_FORMAT_GRAY16_LE, PLANE_LAYOUT_PACKED, 16},
+    [OUTPUT_FORMAT_RGB] = {"RGB", CAPS_MEDIA_TYPE_RAW, GST_VIDEO_FORMAT_RGB, PLANE_LAYOUT_PACKED, 24},
+    [OUTPUT_FORMAT_BGR] = {"BGR", CAPS_MEDIA_TYPE_RAW, GST_VIDEO_FORMAT_BGR, PLANE_LAYOUT_PACKED, 24},
+    [OUTPUT_FORMAT_BGRX] = {"BGRx", CAPS_MEDIA_TYPE_RAW, GST_VIDEO_FORMAT_BGRx, PLANE_LAYOUT_PACKED, 32},
+    [OUTPUT_FORMAT_ARGB] = {"ARGB", CAPS_MEDIA_TYPE_RAW, GST_VIDEO_FORMAT_ARGB, PLANE_LAYOUT_PACKED, 32},
+    [OUTPUT_FORMAT_RGBA] = {"RGBA", CAPS_MEDIA_TYPE_RAW, GST_VIDEO_FORMAT_RGBA, PLANE_LAYOUT_PACKED, 32},
+    [OUTPUT_FORMAT_BGRA] = {"BGRA", CAPS_MEDIA_TYPE_RAW, GST_VIDEO_FORMAT_BGRA, PLANE_LAYOUT_PACKED, 32},
+    [OUTPUT_FORMAT_IYU1] = {"IYU1", CAPS_MEDIA_TYPE_RAW, GST_VIDEO_FORMAT_IYU1, PLANE_LAYOUT_PACKED, 12},
+    [OUTPUT_FORMAT_UYVY] = {"UYVY", CAPS_MEDIA_TYPE_RAW, GST_VIDEO_FORMAT_UYVY, PLANE_LAYOUT_PACKED, 16},
+    [OUTPUT_FORMAT_IYU2] = {"IYU2", CAPS_MEDIA_TYPE_RAW, GST_VIDEO_FORMAT_IYU2, PLANE_LAYOUT_PACKED, 24},
+    [OUTPUT_FORMAT_I420] = {"I420", CAPS_MEDIA_TYPE_RAW, GST_VIDEO_FORMAT_I420, PLANE_LAYOUT_I420, 12},
+    [OUTPUT_FORMAT_NV12] = {"NV12", CAPS_MEDIA_TYPE_RAW, GST_VIDEO_FORMAT_NV12, PLANE_LAYOUT_NV12, 12},
+    [OUTPUT_FORMAT_GRBG] = {"grbg", CAPS_MEDIA_TYPE_BAYER, GST_VIDEO_FORMAT_UNKNOWN, PLANE_LAYOUT_PACKED, 8},
+    [OUTPUT_FORMAT_RGGB] = {"rggb", CAPS_MEDIA_TYPE_BAYER, GST_VIDEO_FORMAT_UNKNOWN, PLANE_LAYOUT_PACKED, 8},
+    [OUTPUT_FORMAT_GBRG] = {"gbrg", CAPS_MEDIA_TYPE_BAYER, GST_VIDEO_FORMAT_UNKNOWN, PLANE_LAYOUT_PACKED, 8},
+    [OUTPUT_FORMAT_BGGR] = {"bggr", CAPS_MEDIA_TYPE_BAYER, GST_VIDEO_FORMAT_UNKNOWN, PLANE_LAYOUT_PACKED, 8},
+    [OUTPUT_FORMAT_GRBG10LE] = {"grbg10le", CAPS_MEDIA_TYPE_BAYER, GST_VIDEO_FORMAT_UNKNOWN, PLANE_LAYOUT_PACKED, 16},
+    [OUTPUT_FORMAT_RGGB10LE] = {"rggb10le", CAPS_MEDIA_TYPE_BAYER, GST_VIDEO_FORMAT_UNKNOWN, PLANE_LAYOUT_PACKED, 16},
+    [OUTPUT_FORMAT_GBRG10LE] = {"gbrg10le", CAPS_MEDIA_TYPE_BAYER, GST_VIDEO_FORMAT_UNKNOWN, PLANE_LAYOUT_PACKED, 16},
+    [OUTPUT_FORMAT_BGGR10LE] = {"bggr10le", CAPS_MEDIA_TYPE_BAYER, GST_VIDEO_FORMAT_UNKNOWN, PLANE_LAYOUT_PACKED, 16},
+    [OUTPUT_FORMAT_GRBG12LE] = {"grbg12le", CAPS_MEDIA_TYPE_BAYER, GST_VIDEO_FORMAT_UNKNOWN, PLANE_LAYOUT_PACKED, 16},
+    [OUTPUT_FORMAT_RGGB12LE] = {"rggb12le", CAPS_MEDIA_TYPE_BAYER, GST_VIDEO_FORMAT_UNKNOWN, PLANE_LAYOUT_PACKED, 16},
+    [OUTPUT_FORMAT_GBRG12LE] = {"gbrg12le", CAPS_MEDIA_TYPE_BAYER, GST_VIDEO_FORMAT_UNKNOWN, PLANE_LAYOUT_PACKED, 16},
+    [OUTPUT_FORMAT_BGGR12LE] = {"bggr12le", CAPS_MEDIA_TYPE_BAYER, GST_VIDEO_FORMAT_UNKNOWN, PLANE_LAYOUT_PACKED, 16},
+    [OUTPUT_FORMAT_GRBG16LE] = {"grbg16le", CAPS_MEDIA_TYPE_BAYER, GST_VIDEO_FORMAT_UNKNOWN, PLANE_LAYOUT_PACKED, 16},
+    [OUTPUT_FORMAT_RGGB16LE] = {"rggb16le", CAPS_MEDIA_TYPE_BAYER, GST_VIDEO_FORMAT_UNKNOWN, PLANE_LAYOUT_PACKED, 16},
+    [OUTPUT_FORMAT_GBRG16LE] = {"gbrg16le", CAPS_MEDIA_TYPE_BAYER, GST_VIDEO_FORMAT_UNKNOWN, PLANE_LAYOUT_PACKED, 16},
+    [OUTPUT_FORMAT_BGGR16LE] = {"bggr16le", CAPS_MEDIA_TYPE_BAYER, GST_VIDEO_FORMAT_UNKNOWN, PLANE_LAYOUT_PACKED, 16},
+};
+
+// Rows of the GStreamer gray, Bayer and packed colour formats are padded to 4 bytes like the default stride of
+// GstVideoInfo
+static gsize packed_row_stride(guint bits_per_pixel, guint width)
+{
+    return GST_ROUND_UP_4(((gsize)width * bits_per_pixel + 7) / 8);
+}
+
+static void convert_unpack(const VimbaFormatInfo_t *vimba_format,
+                           const GstFormatInfo_t *gst_format,
+                           const ConversionSettings_t *settings,
+                           const guint8 *src,
+                           gsize src_size,
+                           guint width,
+                           guint height,
+                           guint8 *dst)
+{
+    pixel_unpack_image(vimba_format->packed_format,
+                       src,
+                       src_size,
+                       width,
+                       height,
+                       dst,
+                       packed_row_stride(gst_format->bits_per_pixel, width),
+                       gst_format->bits_per_pixel,
+                       settings->scaling);
+}
+
+// Narrowing replaces the copy of the image data, so no additional pass over the image is needed
+static void convert_narrow(const VimbaFormatInfo_t *vimba_format,
+                           const GstFormatInfo_t *gst_format,
+                           const ConversionSettings_t *settings,
+                           const guint8 *src,
+                           gsize src_size,
+                           guint width,
+                           guint height,
+                           guint8 *dst)
+{
+    (void)settings;
+    pixel_narrow_image((const guint16 *)src,
+                       src_size,
+                       width,
+                       height,
+                       vimba_format->bit_depth,
+                       dst,
+                       packed_row_stride(gst_format->bits_per_pixel, width));
+}
+
+static void convert_demosaic(const VimbaFormatInfo_t *vimba_format,
+                             const GstFormatInfo_t *gst_format,
+                             const ConversionSettings_t *settings,
+                             const guint8 *src,
+                             gsize src_size,
+                             guint width,
+                             guint height,
+                             guint8 *dst)
 {
-    for (unsigned int i = 0; i < NUM_FORMAT_MATCHES; i++)
+    DebayerOutput_t output = gst_format->video_format == GST_VIDEO_FORMAT_RGB    ? DEBAYER_OUTPUT_RGB
+                             : gst_format->video_format == GST_VIDEO_FORMAT_BGRx ? DEBAYER_OUTPUT_BGRX
+                                                                                 : DEBAYER_OUTPUT_GRAY8;
+    debayer_image(settings->debayer,
+                  vimba_format->bayer_pattern,
+                  settings->debayer_method,
+                  output,
+                  src,
+                  src_size,
+                  width,
+                  height,
+                  dst,
+                  packed_row_stride(gst_format->bits_per_pixel, width));
+}
+
+static void convert_yuv(const VimbaFormatInfo_t *vimba_format,
+                        const GstFormatInfo_t *gst_format,
+                        const ConversionSettings_t *settings,
+                        const guint8 *src,
+                        gsize src_size,
+                        guint width,
+                        guint height,
+                        guint8 *dst)
+{
+    (void)settings;
+    yuv_repack_image(vimba_format->yuv_packing,
+                     gst_format->plane_layout == PLANE_LAYOUT_NV12 ? YUV_OUTPUT_NV12 : YUV_OUTPUT_I420,
+                     src,
+                     src_size,
+                     width,
+                     height,
+                     dst);
+}
+
+// All GStreamer formats a Vimba format can be output as. The formats that are passed on unconverted are listed first
+// for each Vimba format
+static const VimbaGstFormatMatch_t vimba_gst_format_matches[] = {
+    {&vimba_formats[VIMBA_FORMAT_MONO8], &gst_formats[OUTPUT_FORMAT_GRAY8], NULL},
+    {&vimba_formats[VIMBA_FORMAT_MONO10], &gst_formats[OUTPUT_FORMAT_GRAY16_LE], NULL},
+    {&vimba_formats[VIMBA_FORMAT_MONO12], &gst_formats[OUTPUT_FORMAT_GRAY16_LE], NULL},
+    {&vimba_formats[VIMBA_FORMAT_MONO14], &gst_formats[OUTPUT_FORMAT_GRAY16_LE], NULL},
+    {&vimba_formats[VIMBA_FORMAT_MONO16], &gst_formats[OUTPUT_FORMAT_GRAY16_LE], NULL},
+    {&vimba_formats[VIMBA_FORMAT_MONO10P], &gst_formats[OUTPUT_FORMAT_GRAY16_LE], convert_unpack},
+    {&vimba_formats[VIMBA_FORMAT_MONO10P], &gst_formats[OUTPUT_FORMAT_GRAY8], convert_unpack},
+    {&vimba_formats[VIMBA_FORMAT_MONO12P], &gst_formats[OUTPUT_FORMAT_GRAY16_LE], convert_unpack},
+    {&vimba_formats[VIMBA_FORMAT_MONO12P], &gst_formats[OUTPUT_FORMAT_GRAY8], convert_unpack},
+    {&vimba_formats[VIMBA_FORMAT_MONO12PACKED], &gst_formats[OUTPUT_FORMAT_GRAY16_LE], convert_unpack},
+    {&vimba_formats[VIMBA_FORMAT_MONO12PACKED], &gst_formats[OUTPUT_FORMAT_GRAY8], convert_unpack},
+    {&vimba_formats[VIMBA_FORMAT_RGB8], &gst_formats[OUTPUT_FORMAT_RGB], NULL},
+    {&vimba_formats[VIMBA_FORMAT_RGB8PACKED], &gst_formats[OUTPUT_FORMAT_RGB], NULL},
+    {&vimba_formats[VIMBA_FORMAT_BGR8], &gst_formats[OUTPUT_FORMAT_BGR], NULL},
+    {&vimba_formats[VIMBA_FORMAT_BGR8PACKED], &gst_formats[OUTPUT_FORMAT_BGR], NULL},
+    {&vimba_formats[VIMBA_FORMAT_ARGB8], &gst_formats[OUTPUT_FORMAT_ARGB], NULL},
+    {&vimba_formats[VIMBA_FORMAT_RGBA8], &gst_formats[OUTPUT_FORMAT_RGBA], NULL},
+    {&vimba_formats[VIMBA_FORMAT_BGRA8], &gst_formats[OUTPUT_FORMAT_BGRA], NULL},
+    {&vimba_formats[VIMBA_FORMAT_YUV411], &gst_formats[OUTPUT_FORMAT_IYU1], NULL},
+    {&vimba_formats[VIMBA_FORMAT_YUV411], &gst_formats[OUTPUT_FORMAT_I420], convert_yuv},
+    {&vimba_formats[VIMBA_FORMAT_YUV411], &gst_formats[OUTPUT_FORMAT_NV12], convert_yuv},
+    {&vimba_formats[VIMBA_FORMAT_YUV411PACKED], &gst_formats[OUTPUT_FORMAT_IYU1], NULL},
+    {&vimba_formats[VIMBA_FORMAT_YUV411PACKED], &gst_formats[OUTPUT_FORMAT_I420], convert_yuv},
+    {&vimba_formats[VIMBA_FORMAT_YUV411PACKED], &gst_formats[OUTPUT_FORMAT_NV12], convert_yuv},
+    {&vimba_formats[VIMBA_FORMAT_YCBCR411_8_CBYYCRYY], &gst_formats[OUTPUT_FORMAT_IYU1], NULL},
+    {&vimba_formats[VIMBA_FORMAT_YCBCR411_8_CBYYCRYY], &gst_formats[OUTPUT_FORMAT_I420], convert_yuv},
+    {&vimba_formats[VIMBA_FORMAT_YCBCR411_8_CBYYCRYY], &gst_formats[OUTPUT_FORMAT_NV12], convert_yuv},
+    {&vimba_formats[VIMBA_FORMAT_YUV422], &gst_formats[OUTPUT_FORMAT_UYVY], NULL},
+    {&vimba_formats[VIMBA_FORMAT_YUV422], &gst_formats[OUTPUT_FORMAT_I420], convert_yuv},
+    {&vimba_formats[VIMBA_FORMAT_YUV422], &gst_formats[OUTPUT_FORMAT_NV12], convert_yuv},
+    {&vimba_formats[VIMBA_FORMAT_YUV422PACKED], &gst_formats[OUTPUT_FORMAT_UYVY], NULL},
+    {&vimba_formats[VIMBA_FORMAT_YUV422PACKED], &gst_formats[OUTPUT_FORMAT_I420], convert_yuv},
+    {&vimba_formats[VIMBA_FORMAT_YUV422PACKED], &gst_formats[OUTPUT_FORMAT_NV12], convert_yuv},
+    {&vimba_formats[VIMBA_FORMAT_YCBCR422_8_CBYCRY], &gst_formats[OUTPUT_FORMAT_UYVY], NULL},
+    {&vimba_formats[VIMBA_FORMAT_YCBCR422_8_CBYCRY], &gst_formats[OUTPUT_FORMAT_I420], convert_yuv},
+    {&vimba_formats[VIMBA_FORMAT_YCBCR422_8_CBYCRY], &gst_formats[OUTPUT_FORMAT_NV12], convert_yuv},
+    {&vimba_formats[VIMBA_FORMAT_YUV444], &gst_formats[OUTPUT_FORMAT_IYU2], NULL},
+    {&vimba_formats[VIMBA_FORMAT_YUV444PACKED], &gst_formats[OUTPUT_FORMAT_IYU2], NULL},
+    {&vimba_formats[VIMBA_FORMAT_YCBCR8_CBYCR], &gst_formats[OUTPUT_FORMAT_IYU2], NULL},
+    {&vimba_formats[VIMBA_FORMAT_BAYERGR8], &gst_formats[OUTPUT_FORMAT_GRBG], NULL},
+    {&vimba_formats[VIMBA_FORMAT_BAYERGR8], &gst_formats[OUTPUT_FORMAT_RGB], convert_demosaic},
+    {&vimba_formats[VIMBA_FORMAT_BAYERGR8], &gst_formats[OUTPUT_FORMAT_BGRX], convert_demosaic},
+    {&vimba_formats[VIMBA_FORMAT_BAYERGR8], &gst_formats[OUTPUT_FORMAT_GRAY8], convert_demosaic},
+    {&vimba_formats[VIMBA_FORMAT_BAYERRG8], &gst_formats[OUTPUT_FORMAT_RGGB], NULL},
+    {&vimba_formats[VIMBA_FORMAT_BAYERRG8], &gst_formats[OUTPUT_FORMAT_RGB], convert_demosaic},
+    {&vimba_formats[VIMBA_FORMAT_BAYERRG8], &gst_formats[OUTPUT_FORMAT_BGRX], convert_demosaic},
+    {&vimba_formats[VIMBA_FORMAT_BAYERRG8], &gst_formats[OUTPUT_FORMAT_GRAY8], convert_demosaic},
+    {&vimba_formats[VIMBA_FORMAT_BAYERGB8], &gst_formats[OUTPUT_FORMAT_GBRG], NULL},
+    {&vimba_formats[VIMBA_FORMAT_BAYERGB8], &gst_formats[OUTPUT_FORMAT_RGB], convert_demosaic},
+    {&vimba_formats[VIMBA_FORMAT_BAYERGB8], &gst_formats[OUTPUT_FORMAT_BGRX], convert_demosaic},
+    {&vimba_formats[VIMBA_FORMAT_BAYERGB8], &gst_formats[OUTPUT_FORMAT_GRAY8], convert_demosaic},
+    {&vimba_formats[VIMBA_FORMAT_BAYERBG8], &gst_formats[OUTPUT_FORMAT_BGGR], NULL},
+    {&vimba_formats[VIMBA_FORMAT_BAYERBG8], &gst_formats[OUTPUT_FORMAT_RGB], convert_demosaic},
+    {&vimba_formats[VIMBA_FORMAT_BAYERBG8], &gst_formats[OUTPUT_FORMAT_BGRX], convert_demosaic},
+    {&vimba_formats[VIMBA_FORMAT_BAYERBG8], &gst_formats[OUTPUT_FORMAT_GRAY8], convert_demosaic},
+    {&vimba_formats[VIMBA_FORMAT_BAYERGR10], &gst_formats[OUTPUT_FORMAT_GRBG10LE], NULL},
+    {&vimba_formats[VIMBA_FORMAT_BAYERGR10], &gst_formats[OUTPUT_FORMAT_GRBG], convert_narrow},
+    {&vimba_formats[VIMBA_FORMAT_BAYERRG10], &gst_formats[OUTPUT_FORMAT_RGGB10LE], NULL},
+    {&vimba_formats[VIMBA_FORMAT_BAYERRG10], &gst_formats[OUTPUT_FORMAT_RGGB], convert_narrow},
+    {&vimba_formats[VIMBA_FORMAT_BAYERGB10], &gst_formats[OUTPUT_FORMAT_GBRG10LE], NULL},
+    {&vimba_formats[VIMBA_FORMAT_BAYERGB10], &gst_formats[OUTPUT_FORMAT_GBRG], convert_narrow},
+    {&vimba_formats[VIMBA_FORMAT_BAYERBG10], &gst_formats[OUTPUT_FORMAT_BGGR10LE], NULL},
+    {&vimba_formats[VIMBA_FORMAT_BAYERBG10], &gst_formats[OUTPUT_FORMAT_BGGR], convert_narrow},
+    {&vimba_formats[VIMBA_FORMAT_BAYERGR10P], &gst_formats[OUTPUT_FORMAT_GRBG10LE], convert_unpack},
+    {&vimba_formats[VIMBA_FORMAT_BAYERGR10P], &gst_formats[OUTPUT_FORMAT_GRBG], convert_unpack},
+    {&vimba_formats[VIMBA_FORMAT_BAYERRG10P], &gst_formats[OUTPUT_FORMAT_RGGB10LE], convert_unpack},
+    {&vimba_formats[VIMBA_FORMAT_BAYERRG10P], &gst_formats[OUTPUT_FORMAT_RGGB], convert_unpack},
+    {&vimba_formats[VIMBA_FORMAT_BAYERGB10P], &gst_formats[OUTPUT_FORMAT_GBRG10LE], convert_unpack},
+    {&vimba_formats[VIMBA_FORMAT_BAYERGB10P], &gst_formats[OUTPUT_FORMAT_GBRG], convert_unpack},
+    {&vimba_formats[VIMBA_FORMAT_BAYERBG10P], &gst_formats[OUTPUT_FORMAT_BGGR10LE], convert_unpack},
+    {&vimba_formats[VIMBA_FORMAT_BAYERBG10P], &gst_formats[OUTPUT_FORMAT_BGGR], convert_unpack},
+    {&vimba_formats[VIMBA_FORMAT_BAYERGR12], &gst_formats[OUTPUT_FORMAT_GRBG12LE], NULL},
+    {&vimba_formats[VIMBA_FORMAT_BAYERGR12], &gst_formats[OUTPUT_FORMAT_GRBG], convert_narrow},
+    {&vimba_formats[VIMBA_FORMAT_BAYERRG12], &gst_formats[OUTPUT_FORMAT_RGGB12LE], NULL},
+    {&vimba_formats[VIMBA_FORMAT_BAYERRG12], &gst_formats[OUTPUT_FORMAT_RGGB], convert_narrow},
+    {&vimba_formats[VIMBA_FORMAT_BAYERGB12], &gst_formats[OUTPUT_FORMAT_GBRG12LE], NULL},
+    {&vimba_formats[VIMBA_FORMAT_BAYERGB12], &gst_formats[OUTPUT_FORMAT_GBRG], convert_narrow},
+    {&vimba_formats[VIMBA_FORMAT_BAYERBG12], &gst_formats[OUTPUT_FORMAT_BGGR12LE], NULL},
+    {&vimba_formats[VIMBA_FORMAT_BAYERBG12], &gst_formats[OUTPUT_FORMAT_BGGR], convert_narrow},
+    {&vimba_formats[VIMBA_FORMAT_BAYERGR12P], &gst_formats[OUTPUT_FORMAT_GRBG12LE], convert_unpack},
+    {&vimba_formats[VIMBA_FORMAT_BAYERGR12P], &gst_formats[OUTPUT_FORMAT_GRBG], convert_unpack},
+    {&vimba_formats[VIMBA_FORMAT_BAYERRG12P], &gst_formats[OUTPUT_FORMAT_RGGB12LE], convert_unpack},
+    {&vimba_formats[VIMBA_FORMAT_BAYERRG12P], &gst_formats[OUTPUT_FORMAT_RGGB], convert_unpack},
+    {&vimba_formats[VIMBA_FORMAT_BAYERGB12P], &gst_formats[OUTPUT_FORMAT_GBRG12LE], convert_unpack},
+    {&vimba_formats[VIMBA_FORMAT_BAYERGB12P], &gst_formats[OUTPUT_FORMAT_GBRG], convert_unpack},
+    {&vimba_formats[VIMBA_FORMAT_BAYERBG12P], &gst_formats[OUTPUT_FORMAT_BGGR12LE], convert_unpack},
+    {&vimba_formats[VIMBA_FORMAT_BAYERBG12P], &gst_formats[OUTPUT_FORMAT_BGGR], convert_unpack},
+    {&vimba_formats[VIMBA_FORMAT_BAYERGR12PACKED], &gst_formats[OUTPUT_FORMAT_GRBG12LE], convert_unpack},
+    {&vimba_formats[VIMBA_FORMAT_BAYERGR12PACKED], &gst_formats[OUTPUT_FORMAT_GRBG], convert_unpack},
+    {&vimba_formats[VIMBA_FORMAT_BAYERRG12PACKED], &gst_formats[OUTPUT_FORMAT_RGGB12LE], convert_unpack},
+    {&vimba_formats[VIMBA_FORMAT_BAYERRG12PACKED], &gst_formats[OUTPUT_FORMAT_RGGB], convert_unpack},
+    {&vimba_formats[VIMBA_FORMAT_BAYERGB12PACKED], &gst_formats[OUTPUT_FORMAT_GBRG12LE], convert_unpack},
+    {&vimba_formats[VIMBA_FORMAT_BAYERGB12PACKED], &gst_formats[OUTPUT_FORMAT_GBRG], convert_unpack},
+    {&vimba_formats[VIMBA_FORMAT_BAYERBG12PACKED], &gst_formats[OUTPUT_FORMAT_BGGR12LE], convert_unpack},
+    {&vimba_formats[VIMBA_FORMAT_BAYERBG12PACKED], &gst_formats[OUTPUT_FORMAT_BGGR], convert_unpack},
+    {&vimba_formats[VIMBA_FORMAT_BAYERGR16], &gst_formats[OUTPUT_FORMAT_GRBG16LE], NULL},
+    {&vimba_formats[VIMBA_FORMAT_BAYERGR16], &gst_formats[OUTPUT_FORMAT_GRBG], convert_narrow},
+    {&vimba_formats[VIMBA_FORMAT_BAYERRG16], &gst_formats[OUTPUT_FORMAT_RGGB16LE], NULL},
+    {&vimba_formats[VIMBA_FORMAT_BAYERRG16], &gst_formats[OUTPUT_FORMAT_RGGB], convert_narrow},
+    {&vimba_formats[VIMBA_FORMAT_BAYERGB16], &gst_formats[OUTPUT_FORMAT_GBRG16LE], NULL},
+    {&vimba_formats[VIMBA_FORMAT_BAYERGB16], &gst_formats[OUTPUT_FORMAT_GBRG], convert_narrow},
+    {&vimba_formats[VIMBA_FORMAT_BAYERBG16], &gst_formats[OUTPUT_FORMAT_BGGR16LE], NULL},
+    {&vimba_formats[VIMBA_FORMAT_BAYERBG16], &gst_formats[OUTPUT_FORMAT_BGGR], convert_narrow},
+};
+
+// Lookup tables built from the descriptor tables on first use
+static GHashTable *vimba_formats_by_name;
+static GHashTable *gst_formats_by_name;
+static const VimbaGstFormatMatch_t *matches_by_vimba_format[NUM_VIMBA_FORMATS][MAX_MATCHES_PER_VIMBA_FORMAT];
+static guint match_counts[NUM_VIMBA_FORMATS];
+
+static void init_lookup_tables(void)
+{
+    static gsize initialized = 0;
+    if (!g_once_init_enter(&initialized))
+    {
+        return;
+    }
+
+    vimba_formats_by_name = g_hash_table_new(g_str_hash, g_str_equal);
+    for (unsigned int i = 0; i < NUM_VIMBA_FORMATS; i++)
+    {
+        g_hash_table_insert(vimba_formats_by_name, (gpointer)vimba_formats[i].name, (gpointer)&vimba_formats[i]);
+    }
+    gst_formats_by_name = g_hash_table_new(g_str_hash, g_str_equal);
+    for (unsigned int i = 0; i < NUM_OUTPUT_FORMATS; i++)
+    {
+        g_hash_table_insert(gst_formats_by_name, (gpointer)gst_formats[i].name, (gpointer)&gst_formats[i]);
+    }
+    for (unsigned int i = 0; i < G_N_ELEMENTS(vimba_gst_format_matches); i++)
     {
-        if (strcmp(vimba_format, vimba_gst_format_matches[i].vimba_format_name) == 0)
-        {
-            return &vimba_gst_format_matches[i];
-        }
+        const VimbaGstFormatMatch_t *format_match = &vimba_gst_format_matches[i];
+        gsize index = (gsize)(format_match->vimba_format - vimba_formats);
+        g_assert(match_counts[index] < MAX_MATCHES_PER_VIMBA_FORMAT);
+        matches_by_vimba_format[index][match_counts[index]++] = format_match;
     }
-    return NULL;
+
+    g_once_init_leave(&initialized, 1);
+}
+
+const VimbaFormatInfo_t *vimba_format_from_name(const char *vimba_format)
+{
+    init_lookup_tables();
+    return g_hash_table_lookup(vimba_formats_by_name, vimba_format);
+}
+
+const GstFormatInfo_t *gst_format_from_name(const char *gst_format)
+{
+    init_lookup_tables();
+    return g_hash_table_lookup(gst_formats_by_name, gst_format);
 }
 
-// TODO: There may be multiple vimba format entries for the same gst_format. How to handle this? Currently the first hit
-// for the gst_format is returned and the rest ignored.
-const VimbaGstFormatMatch_t *vimba_format_from_gst_format(const char *gst_format)
+const VimbaGstFormatMatch_t *const *vimba_format_get_matches(const VimbaFormatInfo_t *vimba_format, guint *count)
 {
-    for (unsigned int i = 0; i < NUM_FORMAT_MATCHES; i++)
+    init_lookup_tables();
+    gsize index = (gsize)(vimba_format - vimba_formats);
+    *count = match_counts[index];
+    return matches_by_vimba_format[index];
+}
+
+gsize vimba_format_payload_size(const VimbaFormatInfo_t *vimba_format, guint width, guint height)
+{
+    return ((gsize)width * height * vimba_format->bits_per_pixel + 7) / 8;
+}
+
+gsize gst_format_image_size(const GstFormatInfo_t *gst_format, guint width, guint height)
+{
+    switch (gst_format->plane_layout)
     {
-        if (strcmp(gst_format, vimba_gst_format_matches[i].gst_format_name) == 0)
-        {
-            return &vimba_gst_format_matches[i];
-        }
+    case PLANE_LAYOUT_I420:
+        return yuv_repack_output_size(YUV_OUTPUT_I420, width, height);
+    case PLANE_LAYOUT_NV12:
+        return yuv_repack_output_size(YUV_OUTPUT_NV12, width, height);
+    default:
+        return packed_row_stride(gst_format->bits_per_pixel, width) * height;
     }
-    return NULL;
-}
\ No newline at end of file
+}
+
+bool format_match_is_converted(const VimbaGstFormatMatch_t *format_match)
+{
+    return format_match->convert != NULL;
+}
+
+bool format_match_is_demosaiced(const VimbaGstFormatMatch_t *format_match)
+{
+    return format_match->vimba_format->bayer_pattern != BAYER_PATTERN_NONE &&
+           format_match->gst_format->media_type == CAPS_MEDIA_TYPE_RAW;
+}
@@ -1,10 +1,20 @@
 #ifndef PIXELFORMATS_H_
 #define PIXELFORMATS_H_
 
-#include <VimbaC/Include/VmbCommonTypes.h>
+#include "debayer.h"
+#include "pixelunpack.h"
+#include "yuvrepack.h"
 
-// Helper as GStreamer only provides these macros for x-raw formats
-#define GST_BAYER_FORMATS_ALL "{ bggr, grbg, gbrg, rggb }"
+#include <gst/gst.h>
+#include <gst/video/video-format.h>
+
+#include <stdbool.h>
+
+// Helper as GStreamer only provides these macros for x-raw formats. The formats with more than 8 bits hold the value in
+// the least significant bits of 16 bit little endian pixels
+#define GST_BAYER_FORMATS_ALL                                                                                          \
+    "{ bggr, grbg, gbrg, rggb, bggr10le, grbg10le, gbrg10le, rggb10le, bggr12le, grbg12le, gbrg12le, rggb12le, "       \
+    "bggr16le, grbg16le, gbrg16le, rggb16le }"
 
 #define GST_BAYER_CAPS_MAKE(format)       \
     "video/x-bayer, "                     \
@@ -13,45 +23,192 @@
     "height = " GST_VIDEO_SIZE_RANGE ", " \
     "framerate = " GST_VIDEO_FPS_RANGE
 
+// Most Vimba formats can be converted into more than one GStreamer format
+#define MAX_MATCHES_PER_VIMBA_FORMAT 4
+
+// Pixel formats the camera may deliver
+typedef enum
+{
+    VIMBA_FORMAT_MONO8,
+    VIMBA_FORMAT_MONO10,
+    VIMBA_FORMAT_MONO12,
+    VIMBA_FORMAT_MONO14,
+    VIMBA_FORMAT_MONO16,
+    VIMBA_FORMAT_MONO10P,
+    VIMBA_FORMAT_MONO12P,
+    VIMBA_FORMAT_MONO12PACKED,
+    VIMBA_FORMAT_RGB8,
+    VIMBA_FORMAT_RGB8PACKED,
+    VIMBA_FORMAT_BGR8,
+    VIMBA_FORMAT_BGR8PACKED,
+    VIMBA_FORMAT_ARGB8,
+    VIMBA_FORMAT_RGBA8,
+    VIMBA_FORMAT_BGRA8,
+    VIMBA_FORMAT_YUV411,
+    VIMBA_FORMAT_YUV411PACKED,
+    VIMBA_FORMAT_YCBCR411_8_CBYYCRYY,
+    VIMBA_FORMAT_YUV422,
+    VIMBA_FORMAT_YUV422PACKED,
+    VIMBA_FORMAT_YCBCR422_8_CBYCRY,
+    VIMBA_FORMAT_YUV444,
+    VIMBA_FORMAT_YUV444PACKED,
+    VIMBA_FORMAT_YCBCR8_CBYCR,
+    VIMBA_FORMAT_BAYERGR8,
+    VIMBA_FORMAT_BAYERRG8,
+    VIMBA_FORMAT_BAYERGB8,
+    VIMBA_FORMAT_BAYERBG8,
+    VIMBA_FORMAT_BAYERGR10,
+    VIMBA_FORMAT_BAYERRG10,
+    VIMBA_FORMAT_BAYERGB10,
+    VIMBA_FORMAT_BAYERBG10,
+    VIMBA_FORMAT_BAYERGR10P,
+    VIMBA_FORMAT_BAYERRG10P,
+    VIMBA_FORMAT_BAYERGB10P,
+    VIMBA_FORMAT_BAYERBG10P,
+    VIMBA_FORMAT_BAYERGR12,
+    VIMBA_FORMAT_BAYERRG12,
+    VIMBA_FORMAT_BAYERGB12,
+    VIMBA_FORMAT_BAYERBG12,
+    VIMBA_FORMAT_BAYERGR12P,
+    VIMBA_FORMAT_BAYERRG12P,
+    VIMBA_FORMAT_BAYERGB12P,
+    VIMBA_FORMAT_BAYERBG12P,
+    VIMBA_FORMAT_BAYERGR12PACKED,
+    VIMBA_FORMAT_BAYERRG12PACKED,
+    VIMBA_FORMAT_BAYERGB12PACKED,
+    VIMBA_FORMAT_BAYERBG12PACKED,
+    VIMBA_FORMAT_BAYERGR16,
+    VIMBA_FORMAT_BAYERRG16,
+    VIMBA_FORMAT_BAYERGB16,
+    VIMBA_FORMAT_BAYERBG16,
+    NUM_VIMBA_FORMATS
+} VimbaFormat_t;
+
+// Formats the element may output
+typedef enum
+{
+    OUTPUT_FORMAT_GRAY8,
+    OUTPUT_FORMAT_GRAY16_LE,
+    OUTPUT_FORMAT_RGB,
+    OUTPUT_FORMAT_BGR,
+    OUTPUT_FORMAT_BGRX,
+    OUTPUT_FORMAT_ARGB,
+    OUTPUT_FORMAT_RGBA,
+    OUTPUT_FORMAT_BGRA,
+    OUTPUT_FORMAT_IYU1,
+    OUTPUT_FORMAT_UYVY,
+    OUTPUT_FORMAT_IYU2,
+    OUTPUT_FORMAT_I420,
+    OUTPUT_FORMAT_NV12,
+    OUTPUT_FORMAT_GRBG,
+    OUTPUT_FORMAT_RGGB,
+    OUTPUT_FORMAT_GBRG,
+    OUTPUT_FORMAT_BGGR,
+    OUTPUT_FORMAT_GRBG10LE,
+    OUTPUT_FORMAT_RGGB10LE,
+    OUTPUT_FORMAT_GBRG10LE,
+    OUTPUT_FORMAT_BGGR10LE,
+    OUTPUT_FORMAT_GRBG12LE,
+    OUTPUT_FORMAT_RGGB12LE,
+    OUTPUT_FORMAT_GBRG12LE,
+    OUTPUT_FORMAT_BGGR12LE,
+    OUTPUT_FORMAT_GRBG16LE,
+    OUTPUT_FORMAT_RGGB16LE,
+    OUTPUT_FORMAT_GBRG16LE,
+    OUTPUT_FORMAT_BGGR16LE,
+    NUM_OUTPUT_FORMATS
+} OutputFormat_t;
+
+// Caps structure a GStreamer format is reported in
+typedef enum
+{
+    CAPS_MEDIA_TYPE_RAW,
+    CAPS_MEDIA_TYPE_BAYER
+} CapsMediaType_t;
+
+// Arrangement of the image data of GStreamer formats
+typedef enum
+{
+    // All values of a pixel are stored together in rows padded to 4 bytes
+    PLANE_LAYOUT_PACKED,
+    PLANE_LAYOUT_I420,
+    PLANE_LAYOUT_NV12
+} PlaneLayout_t;
+
+typedef struct
+{
+    const char *name;
+    // Bits each pixel occupies in the frame, and thus on the link between camera and host
+    guint bits_per_pixel;
+    // Number of significant bits per pixel value
+    guint bit_depth;
+    // Set if the pixel values are packed without padding
+    PackedFormat_t packed_format;
+    // Set for all Bayer formats
+    BayerPattern_t bayer_pattern;
+    // Set for the 4:1:1 and 4:2:2 YUV formats
+    YuvPacking_t yuv_packing;
+} VimbaFormatInfo_t;
+
 typedef struct
 {
-    const char *vimba_format_name;
-    const char *gst_format_name;
+    const char *name;
+    CapsMediaType_t media_type;
+    // GST_VIDEO_FORMAT_UNKNOWN for the video/x-bayer formats
+    GstVideoFormat video_format;
+    PlaneLayout_t plane_layout;
+    // Size of the pixels. Only used for formats with PLANE_LAYOUT_PACKED
+    guint bits_per_pixel;
+} GstFormatInfo_t;
+
+// Settings of the element that affect the conversions in create
+typedef struct
+{
+    // Placement of the pixel values if packed formats are unpacked into 16 bit pixels
+    BitDepthScaling_t scaling;
+    DebayerMethod_t debayer_method;
+    // Distributes demosaicing over multiple threads. May be NULL
+    Debayer_t *debayer;
+} ConversionSettings_t;
+
+// Converts an image of a Vimba format into a GStreamer format. dst holds gst_format_image_size bytes
+typedef void (*ConvertImage_t)(const VimbaFormatInfo_t *vimba_format,
+                               const GstFormatInfo_t *gst_format,
+                               const ConversionSettings_t *settings,
+                               const guint8 *src,
+                               gsize src_size,
+                               guint width,
+                               guint height,
+                               guint8 *dst);
+
+typedef struct
+{
+    const VimbaFormatInfo_t *vimba_format;
+    const GstFormatInfo_t *gst_format;
+    // Converts the image data in the element. NULL if the frames are passed on as delivered by the camera
+    ConvertImage_t convert;
 } VimbaGstFormatMatch_t;
 
-// TODO: Check if same capitalization as below for the vimba capabilities is guaranteed
-static VimbaGstFormatMatch_t vimba_gst_format_matches[] = {
-    {"Mono8", "GRAY8"},
-    {"Mono10", "GRAY16_LE"},
-    {"Mono12", "GRAY16_LE"},
-    {"Mono14", "GRAY16_LE"},
-    {"Mono16", "GRAY16_LE"},
-    {"RGB8", "RGB"},
-    {"RGB8Packed", "RGB"},
-    {"BGR8", "BGR"},
-    {"BGR8Packed", "BGR"},
-    {"Argb8", "ARGB"},
-    {"Rgba8", "RGBA"},
-    {"Bgra8", "BGRA"},
-    {"Yuv411", "IYU1"},
-    {"YUV411Packed", "IYU1"},
-    {"YCbCr411_8_CbYYCrYY", "IYU1"},
-    {"Yuv422", "UYVY"},
-    {"YUV422Packed", "UYVY"},
-    {"YCbCr422_8_CbYCrY", "UYVY"},
-    {"Yuv444", "IYU2"},
-    {"YUV444Packed", "IYU2"},
-    {"YCbCr8_CbYCr", "IYU2"},
-    {"BayerGR8", "grbg"},
-    {"BayerRG8", "rggb"},
-    {"BayerGB8", "gbrg"},
-    {"BayerBG8", "bggr"}};
-#define NUM_FORMAT_MATCHES (sizeof(vimba_gst_format_matches) / sizeof(vimba_gst_format_matches[0]))
-
-// lookup supported gst cap by format string from camera
-const VimbaGstFormatMatch_t *gst_format_from_vimba_format(const char *vimba_format);
-
-// lookup camera format string by negotiated gst cap
-const VimbaGstFormatMatch_t *vimba_format_from_gst_format(const char *gst_format);
-
-#endif // PIXELFORMATS_H_
\ No newline at end of file
+extern const VimbaFormatInfo_t vimba_formats[NUM_VIMBA_FORMATS];
+extern const GstFormatInfo_t gst_formats[NUM_OUTPUT_FORMATS];
+
+// lookup of the descriptors by the format names of Vimba and GStreamer. NULL for unknown formats
+const VimbaFormatInfo_t *vimba_format_from_name(const char *vimba_format);
+const GstFormatInfo_t *gst_format_from_name(const char *gst_format);
+
+// GStreamer formats the Vimba format can be output as
+const VimbaGstFormatMatch_t *const *vimba_format_get_matches(const VimbaFormatInfo_t *vimba_format, guint *count);
+
+// size of the image data the camera delivers per frame, not including chunk data
+gsize vimba_format_payload_size(const VimbaFormatInfo_t *vimba_format, guint width, guint height);
+
+// size of images of a GStreamer format with the default strides and plane offsets of GstVideoInfo
+gsize gst_format_image_size(const GstFormatInfo_t *gst_format, guint width, guint height);
+
+// check if the image data is converted in the element instead of being passed on as delivered by the camera
+bool format_match_is_converted(const VimbaGstFormatMatch_t *format_match);
+
+// check if a Bayer format is demosaiced into a video/x-raw format
+bool format_match_is_demosaiced(const VimbaGstFormatMatch_t *format_match);
+
+#endif // PIXELFORMATS_H_
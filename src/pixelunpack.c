@@ -0,0 +1,740 @@
+#include "pixelunpack.h"
+
+#include <string.h>
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#define PIXEL_UNPACK_X86
+#include <immintrin.h>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+#endif
+
+#if defined(__ARM_NEON) || defined(__aarch64__) || defined(_M_ARM64)
+#define PIXEL_UNPACK_NEON
+#include <arm_neon.h>
+#endif
+
+// x86 kernels are compiled for their extension independent of the target flags of the build. They are only called if
+// the CPU supports the extension. MSVC allows the intrinsics without further flags
+#if defined(__GNUC__)
+#define TARGET_SSE2 __attribute__((target("sse2")))
+#define TARGET_AVX2 __attribute__((target("avx2")))
+#else
+#define TARGET_SSE2
+#define TARGET_AVX2
+#endif
+
+// Pixels are unpacked in quads of 4. A quad starts at a byte boundary in all supported packed formats
+#define QUAD_PIXELS 4
+#define QUAD_TERMS 4
+
+// Describes how the packed bytes of a quad (loaded as little endian 64 bit value) are spread into 4 little endian 16
+// bit pixels. Each term moves one group of bits to its place: ((packed << shift_left) >> shift_right) & mask
+typedef struct
+{
+    gsize quad_bytes;
+    guint shift_left[QUAD_TERMS];
+    guint shift_right[QUAD_TERMS];
+    guint64 mask[QUAD_TERMS];
+} QuadLayout_t;
+
+static const QuadLayout_t mono10p_layout = {
+    5,
+    {0, 6, 12, 18},
+    {0, 0, 0, 0},
+    {G_GUINT64_CONSTANT(0x3FF),
+     G_GUINT64_CONSTANT(0x3FF) << 16,
+     G_GUINT64_CONSTANT(0x3FF) << 32,
+     G_GUINT64_CONSTANT(0x3FF) << 48}};
+
+static const QuadLayout_t mono12p_layout = {
+    6,
+    {0, 4, 8, 12},
+    {0, 0, 0, 0},
+    {G_GUINT64_CONSTANT(0xFFF),
+     G_GUINT64_CONSTANT(0xFFF) << 16,
+     G_GUINT64_CONSTANT(0xFFF) << 32,
+     G_GUINT64_CONSTANT(0xFFF) << 48}};
+
+// The upper 8 bits of the even pixel come from the first byte, those of the odd pixel from the third byte. The middle
+// byte holds the lower 4 bits of the even (low nibble) and odd (high nibble) pixel
+static const QuadLayout_t mono12packed_layout = {
+    6,
+    {4, 0, 12, 0},
+    {0, 8, 0, 0},
+    {G_GUINT64_CONSTANT(0x0FFF0FF0),
+     G_GUINT64_CONSTANT(0xF),
+     G_GUINT64_CONSTANT(0x0FFF0FF0) << 32,
+     G_GUINT64_CONSTANT(0xF) << 32}};
+
+// Places the significant bits in 16 bit pixels: (pixel << shift_left) | (pixel >> shift_right). A shift_right of 16
+// discards the second term. The masks remove the bits that shifting 64 bit values (holding 4 pixels) moves into the
+// neighbouring pixel
+typedef struct
+{
+    guint shift_left;
+    guint shift_right;
+    guint64 mask_left;
+    guint64 mask_right;
+} BitShift_t;
+
+typedef void (*UnpackQuadsKernel_t)(const QuadLayout_t *layout,
+                                    const BitShift_t *shift,
+                                    const guint8 *src,
+                                    guint16 *dst,
+                                    gsize quad_count);
+typedef void (*NarrowKernel_t)(const guint16 *src, guint8 *dst, gsize count, guint shift);
+typedef void (*ShiftKernel_t)(const BitShift_t *shift, const guint16 *src, guint16 *dst, gsize count);
+
+// Best supported instruction set. -1 until it was detected
+static gint selected_isa = -1;
+
+guint packed_format_bits_per_pixel(PackedFormat_t format)
+{
+    switch (format)
+    {
+    case PACKED_FORMAT_MONO10P:
+        return 10;
+    case PACKED_FORMAT_MONO12P:
+    case PACKED_FORMAT_MONO12PACKED:
+        return 12;
+    default:
+        return 16;
+    }
+}
+
+static const QuadLayout_t *get_quad_layout(PackedFormat_t format)
+{
+    switch (format)
+    {
+    case PACKED_FORMAT_MONO10P:
+        return &mono10p_layout;
+    case PACKED_FORMAT_MONO12P:
+        return &mono12p_layout;
+    default:
+        return &mono12packed_layout;
+    }
+}
+
+static BitShift_t get_bit_shift(guint bit_depth, BitDepthScaling_t scaling)
+{
+    bit_depth = CLAMP(bit_depth, 8, 16);
+    BitShift_t shift = {0, 16, 0, 0};
+    if (scaling != BIT_DEPTH_SCALING_NONE)
+    {
+        shift.shift_left = 16 - bit_depth;
+    }
+    if (scaling == BIT_DEPTH_SCALING_SCALE)
+    {
+        // Fills the bits freed by the left shift with the most significant bits of the value
+        shift.shift_right = bit_depth - shift.shift_left;
+    }
+    guint64 pixel_mask_left = (G_GUINT64_CONSTANT(0xFFFF) << shift.shift_left) & 0xFFFF;
+    guint64 pixel_mask_right = G_GUINT64_CONSTANT(0xFFFF) >> shift.shift_right;
+    shift.mask_left = pixel_mask_left * G_GUINT64_CONSTANT(0x0001000100010001);
+    shift.mask_right = pixel_mask_right * G_GUINT64_CONSTANT(0x0001000100010001);
+    return shift;
+}
+
+static guint64 shift_quad(const BitShift_t *shift, guint64 pixels)
+{
+    return ((pixels << shift->shift_left) & shift->mask_left) | ((pixels >> shift->shift_right) & shift->mask_right);
+}
+
+static guint64 spread_quad(const QuadLayout_t *layout, guint64 packed)
+{
+    guint64 unpacked = 0;
+    for (guint i = 0; i < QUAD_TERMS; i++)
+    {
+        unpacked |= ((packed << layout->shift_left[i]) >> layout->shift_right[i]) & layout->mask[i];
+    }
+    return unpacked;
+}
+
+static void unpack_quads_scalar(const QuadLayout_t *layout,
+                                const BitShift_t *shift,
+                                const guint8 *src,
+                                guint16 *dst,
+                                gsize quad_count)
+{
+    for (gsize i = 0; i < quad_count; i++)
+    {
+        // 8 bytes are loaded at once, which reaches into the next quad. The last quad is read byte exact to not read
+        // past the end of the source
+        guint64 packed = 0;
+        memcpy(&packed, src + i * layout->quad_bytes, i + 1 < quad_count ? sizeof(packed) : layout->quad_bytes);
+        guint64 unpacked = GUINT64_TO_LE(shift_quad(shift, spread_quad(layout, GUINT64_FROM_LE(packed))));
+        memcpy(dst + i * QUAD_PIXELS, &unpacked, sizeof(unpacked));
+    }
+}
+
+static void narrow_scalar(const guint16 *src, guint8 *dst, gsize count, guint shift)
+{
+    for (gsize i = 0; i < count; i++)
+    {
+        dst[i] = (guint8)(GUINT16_FROM_LE(src[i]) >> shift);
+    }
+}
+
+static void shift_scalar(const BitShift_t *shift, const guint16 *src, guint16 *dst, gsize count)
+{
+    for (gsize i = 0; i < count; i++)
+    {
+        guint pixel = GUINT16_FROM_LE(src[i]);
+        dst[i] = GUINT16_TO_LE((guint16)((pixel << shift->shift_left) | (pixel >> shift->shift_right)));
+    }
+}
+
+#ifdef PIXEL_UNPACK_X86
+#if defined(_MSC_VER)
+static bool cpu_supports_sse2(void)
+{
+    int info[4];
+    __cpuid(info, 1);
+    return (info[3] & (1 << 26)) != 0;
+}
+
+static bool cpu_supports_avx2(void)
+{
+    int info[4];
+    __cpuid(info, 0);
+    if (info[0] < 7)
+    {
+        return false;
+    }
+    // The OS must save the YMM registers on context switches (OSXSAVE and AVX set, XMM and YMM state enabled in XCR0)
+    __cpuid(info, 1);
+    if ((info[2] & (1 << 27)) == 0 || (info[2] & (1 << 28)) == 0 || (_xgetbv(0) & 6) != 6)
+    {
+        return false;
+    }
+    __cpuidex(info, 7, 0);
+    return (info[1] & (1 << 5)) != 0;
+}
+#else
+static bool cpu_supports_sse2(void)
+{
+    __builtin_cpu_init();
+    return __builtin_cpu_supports("sse2");
+}
+
+static bool cpu_supports_avx2(void)
+{
+    __builtin_cpu_init();
+    return __builtin_cpu_supports("avx2");
+}
+#endif
+
+TARGET_SSE2 static void unpack_quads_sse2(const QuadLayout_t *layout,
+                                          const BitShift_t *shift,
+                                          const guint8 *src,
+                                          guint16 *dst,
+                                          gsize quad_count)
+{
+    __m128i pixel_shift_left = _mm_cvtsi32_si128((int)shift->shift_left);
+    __m128i pixel_shift_right = _mm_cvtsi32_si128((int)shift->shift_right);
+    __m128i shift_left[QUAD_TERMS], shift_right[QUAD_TERMS], mask[QUAD_TERMS];
+    for (guint t = 0; t < QUAD_TERMS; t++)
+    {
+        shift_left[t] = _mm_cvtsi32_si128((int)layout->shift_left[t]);
+        shift_right[t] = _mm_cvtsi32_si128((int)layout->shift_right[t]);
+        mask[t] = _mm_set1_epi64x((long long)layout->mask[t]);
+    }
+
+    // Two quads per iteration, each loaded with 8 bytes into one 64 bit lane. The load of the second quad reaches into
+    // the following quad, which therefore has to exist
+    gsize i = 0;
+    for (; i + 2 < quad_count; i += 2)
+    {
+        const guint8 *quads = src + i * layout->quad_bytes;
+        __m128i packed = _mm_unpacklo_epi64(_mm_loadl_epi64((const __m128i *)quads),
+                                            _mm_loadl_epi64((const __m128i *)(quads + layout->quad_bytes)));
+        __m128i unpacked = _mm_setzero_si128();
+        for (guint t = 0; t < QUAD_TERMS; t++)
+        {
+            __m128i term = _mm_srl_epi64(_mm_sll_epi64(packed, shift_left[t]), shift_right[t]);
+            unpacked = _mm_or_si128(unpacked, _mm_and_si128(term, mask[t]));
+        }
+        unpacked = _mm_or_si128(_mm_sll_epi16(unpacked, pixel_shift_left), _mm_srl_epi16(unpacked, pixel_shift_right));
+        _mm_storeu_si128((__m128i *)(dst + i * QUAD_PIXELS), unpacked);
+    }
+    unpack_quads_scalar(layout, shift, src + i * layout->quad_bytes, dst + i * QUAD_PIXELS, quad_count - i);
+}
+
+TARGET_SSE2 static void narrow_sse2(const guint16 *src, guint8 *dst, gsize count, guint shift)
+{
+    __m128i shift_count = _mm_cvtsi32_si128((int)shift);
+    gsize i = 0;
+    for (; i + 16 <= count; i += 16)
+    {
+        __m128i low = _mm_srl_epi16(_mm_loadu_si128((const __m128i *)(src + i)), shift_count);
+        __m128i high = _mm_srl_epi16(_mm_loadu_si128((const __m128i *)(src + i + 8)), shift_count);
+        _mm_storeu_si128((__m128i *)(dst + i), _mm_packus_epi16(low, high));
+    }
+    narrow_scalar(src + i, dst + i, count - i, shift);
+}
+
+TARGET_SSE2 static void shift_sse2(const BitShift_t *shift, const guint16 *src, guint16 *dst, gsize count)
+{
+    __m128i shift_left = _mm_cvtsi32_si128((int)shift->shift_left);
+    __m128i shift_right = _mm_cvtsi32_si128((int)shift->shift_right);
+    gsize i = 0;
+    for (; i + 8 <= count; i += 8)
+    {
+        __m128i pixels = _mm_loadu_si128((const __m128i *)(src + i));
+        pixels = _mm_or_si128(_mm_sll_epi16(pixels, shift_left), _mm_srl_epi16(pixels, shift_right));
+        _mm_storeu_si128((__m128i *)(dst + i), pixels);
+    }
+    shift_scalar(shift, src + i, dst + i, count - i);
+}
+
+TARGET_AVX2 static void unpack_quads_avx2(const QuadLayout_t *layout,
+                                          const BitShift_t *shift,
+                                          const guint8 *src,
+                                          guint16 *dst,
+                                          gsize quad_count)
+{
+    __m128i pixel_shift_left = _mm_cvtsi32_si128((int)shift->shift_left);
+    __m128i pixel_shift_right = _mm_cvtsi32_si128((int)shift->shift_right);
+    __m128i shift_left[QUAD_TERMS], shift_right[QUAD_TERMS];
+    __m256i mask[QUAD_TERMS];
+    for (guint t = 0; t < QUAD_TERMS; t++)
+    {
+        shift_left[t] = _mm_cvtsi32_si128((int)layout->shift_left[t]);
+        shift_right[t] = _mm_cvtsi32_si128((int)layout->shift_right[t]);
+        mask[t] = _mm256_set1_epi64x((long long)layout->mask[t]);
+    }
+    // Moves the second quad of each 128 bit lane from directly behind the first one to the upper 64 bits of the lane
+    guint8 shuffle_bytes[32];
+    for (guint lane = 0; lane < 2; lane++)
+    {
+        for (guint byte = 0; byte < 8; byte++)
+        {
+            bool is_used = byte < layout->quad_bytes;
+            shuffle_bytes[lane * 16 + byte] = is_used ? (guint8)byte : 0x80;
+            shuffle_bytes[lane * 16 + 8 + byte] = is_used ? (guint8)(layout->quad_bytes + byte) : 0x80;
+        }
+    }
+    __m256i shuffle = _mm256_loadu_si256((const __m256i *)shuffle_bytes);
+
+    // Four quads per iteration. Each 128 bit lane is loaded with two quads. The 16 byte load of the second lane reaches
+    // past the fourth quad, which limits the loop to the quads for which enough source data follows
+    gsize quad_bytes = layout->quad_bytes;
+    gsize i = 0;
+    for (; (i + 2) * quad_bytes + 16 <= quad_count * quad_bytes; i += 4)
+    {
+        const guint8 *quads = src + i * quad_bytes;
+        __m256i packed = _mm256_inserti128_si256(_mm256_castsi128_si256(_mm_loadu_si128((const __m128i *)quads)),
+                                                 _mm_loadu_si128((const __m128i *)(quads + 2 * quad_bytes)),
+                                                 1);
+        packed = _mm256_shuffle_epi8(packed, shuffle);
+        __m256i unpacked = _mm256_setzero_si256();
+        for (guint t = 0; t < QUAD_TERMS; t++)
+        {
+            __m256i term = _mm256_srl_epi64(_mm256_sll_epi64(packed, shift_left[t]), shift_right[t]);
+            unpacked = _mm256_or_si256(unpacked, _mm256_and_si256(term, mask[t]));
+        }
+        unpacked = _mm256_or_si256(_mm256_sll_epi16(unpacked, pixel_shift_left),
+                                   _mm256_srl_epi16(unpacked, pixel_shift_right));
+        _mm256_storeu_si256((__m256i *)(dst + i * QUAD_PIXELS), unpacked);
+    }
+    unpack_quads_scalar(layout, shift, src + i * quad_bytes, dst + i * QUAD_PIXELS, quad_count - i);
+}
+
+TARGET_AVX2 static void narrow_avx2(const guint16 *src, guint8 *dst, gsize count, guint shift)
+{
+    __m128i shift_count = _mm_cvtsi32_si128((int)shift);
+    gsize i = 0;
+    for (; i + 32 <= count; i += 32)
+    {
+        __m256i low = _mm256_srl_epi16(_mm256_loadu_si256((const __m256i *)(src + i)), shift_count);
+        __m256i high = _mm256_srl_epi16(_mm256_loadu_si256((const __m256i *)(src + i + 16)), shift_count);
+        // Packing works per 128 bit lane, which interleaves the 64 bit blocks of low and high
+        __m256i packed = _mm256_permute4x64_epi64(_mm256_packus_epi16(low, high), 0xD8);
+        _mm256_storeu_si256((__m256i *)(dst + i), packed);
+    }
+    narrow_scalar(src + i, dst + i, count - i, shift);
+}
+
+TARGET_AVX2 static void shift_avx2(const BitShift_t *shift, const guint16 *src, guint16 *dst, gsize count)
+{
+    __m128i shift_left = _mm_cvtsi32_si128((int)shift->shift_left);
+    __m128i shift_right = _mm_cvtsi32_si128((int)shift->shift_right);
+    gsize i = 0;
+    for (; i + 16 <= count; i += 16)
+    {
+        __m256i pixels = _mm256_loadu_si256((const __m256i *)(src + i));
+        pixels = _mm256_or_si256(_mm256_sll_epi16(pixels, shift_left), _mm256_srl_epi16(pixels, shift_right));
+        _mm256_storeu_si256((__m256i *)(dst + i), pixels);
+    }
+    shift_scalar(shift, src + i, dst + i, count - i);
+}
+#endif
+
+#ifdef PIXEL_UNPACK_NEON
+static void unpack_quads_neon(const QuadLayout_t *layout,
+                              const BitShift_t *shift,
+                              const guint8 *src,
+                              guint16 *dst,
+                              gsize quad_count)
+{
+    int16x8_t pixel_shift_left = vdupq_n_s16((int16_t)shift->shift_left);
+    int16x8_t pixel_shift_right = vdupq_n_s16(-(int16_t)shift->shift_right);
+    int64x2_t shift_left[QUAD_TERMS], shift_right[QUAD_TERMS];
+    uint64x2_t mask[QUAD_TERMS];
+    for (guint t = 0; t < QUAD_TERMS; t++)
+    {
+        shift_left[t] = vdupq_n_s64((int64_t)layout->shift_left[t]);
+        // NEON shifts right by shifting left with a negative count
+        shift_right[t] = vdupq_n_s64(-(int64_t)layout->shift_right[t]);
+        mask[t] = vdupq_n_u64(layout->mask[t]);
+    }
+
+    // Same scheme as the SSE2 kernel: two quads per iteration, each loaded with 8 bytes into one 64 bit lane
+    gsize i = 0;
+    for (; i + 2 < quad_count; i += 2)
+    {
+        const guint8 *quads = src + i * layout->quad_bytes;
+        uint64x2_t packed = vreinterpretq_u64_u8(vcombine_u8(vld1_u8(quads), vld1_u8(quads + layout->quad_bytes)));
+        uint64x2_t unpacked = vdupq_n_u64(0);
+        for (guint t = 0; t < QUAD_TERMS; t++)
+        {
+            uint64x2_t term = vshlq_u64(vshlq_u64(packed, shift_left[t]), shift_right[t]);
+            unpacked = vorrq_u64(unpacked, vandq_u64(term, mask[t]));
+        }
+        uint16x8_t pixels = vreinterpretq_u16_u64(unpacked);
+        pixels = vorrq_u16(vshlq_u16(pixels, pixel_shift_left), vshlq_u16(pixels, pixel_shift_right));
+        vst1q_u16(dst + i * QUAD_PIXELS, pixels);
+    }
+    unpack_quads_scalar(layout, shift, src + i * layout->quad_bytes, dst + i * QUAD_PIXELS, quad_count - i);
+}
+
+static void narrow_neon(const guint16 *src, guint8 *dst, gsize count, guint shift)
+{
+    int16x8_t shift_count = vdupq_n_s16(-(int16_t)shift);
+    gsize i = 0;
+    for (; i + 8 <= count; i += 8)
+    {
+        vst1_u8(dst + i, vmovn_u16(vshlq_u16(vld1q_u16(src + i), shift_count)));
+    }
+    narrow_scalar(src + i, dst + i, count - i, shift);
+}
+
+static void shift_neon(const BitShift_t *shift, const guint16 *src, guint16 *dst, gsize count)
+{
+    int16x8_t shift_left = vdupq_n_s16((int16_t)shift->shift_left);
+    // Shifting by 16 or more clears the pixels, like the x86 shifts do
+    int16x8_t shift_right = vdupq_n_s16(-(int16_t)shift->shift_right);
+    gsize i = 0;
+    for (; i + 8 <= count; i += 8)
+    {
+        uint16x8_t pixels = vld1q_u16(src + i);
+        vst1q_u16(dst + i, vorrq_u16(vshlq_u16(pixels, shift_left), vshlq_u16(pixels, shift_right)));
+    }
+    shift_scalar(shift, src + i, dst + i, count - i);
+}
+#endif
+
+/**
+ * @brief Checks whether the unpacking kernels for an instruction set are compiled in and supported by the CPU
+ */
+bool pixel_unpack_isa_supported(PixelUnpackIsa_t isa)
+{
+    switch (isa)
+    {
+    case PIXEL_UNPACK_ISA_SCALAR:
+        return true;
+#ifdef PIXEL_UNPACK_X86
+    case PIXEL_UNPACK_ISA_SSE2:
+        return cpu_supports_sse2();
+    case PIXEL_UNPACK_ISA_AVX2:
+        return cpu_supports_avx2();
+#endif
+#ifdef PIXEL_UNPACK_NEON
+    case PIXEL_UNPACK_ISA_NEON:
+        return true;
+#endif
+    default:
+        return false;
+    }
+}
+
+/**
+ * @brief Gets the instruction set used for unpacking. Unless set with pixel_unpack_set_isa this is the best one the
+ * CPU supports
+ */
+PixelUnpackIsa_t pixel_unpack_get_isa(void)
+{
+    gint isa = g_atomic_int_get(&selected_isa);
+    if (isa < 0)
+    {
+        // Detection may run concurrently in multiple threads, which all come to the same result
+        isa = PIXEL_UNPACK_ISA_SCALAR;
+        const PixelUnpackIsa_t preferred_isas[] = {PIXEL_UNPACK_ISA_AVX2, PIXEL_UNPACK_ISA_NEON, PIXEL_UNPACK_ISA_SSE2};
+        for (gsize i = 0; i < G_N_ELEMENTS(preferred_isas); i++)
+        {
+            if (pixel_unpack_isa_supported(preferred_isas[i]))
+            {
+                isa = preferred_isas[i];
+                break;
+            }
+        }
+        g_atomic_int_set(&selected_isa, isa);
+    }
+    return (PixelUnpackIsa_t)isa;
+}
+
+/**
+ * @brief Forces the instruction set used for unpacking, e.g. to compare the kernels in benchmarks. Ignored if the
+ * instruction set is not supported
+ */
+void pixel_unpack_set_isa(PixelUnpackIsa_t isa)
+{
+    if (pixel_unpack_isa_supported(isa))
+    {
+        g_atomic_int_set(&selected_isa, (gint)isa);
+    }
+}
+
+const char *pixel_unpack_isa_name(PixelUnpackIsa_t isa)
+{
+    switch (isa)
+    {
+    case PIXEL_UNPACK_ISA_SSE2:
+        return "SSE2";
+    case PIXEL_UNPACK_ISA_AVX2:
+        return "AVX2";
+    case PIXEL_UNPACK_ISA_NEON:
+        return "NEON";
+    default:
+        return "scalar";
+    }
+}
+
+static UnpackQuadsKernel_t get_unpack_quads_kernel(PixelUnpackIsa_t isa)
+{
+    switch (isa)
+    {
+#ifdef PIXEL_UNPACK_X86
+    case PIXEL_UNPACK_ISA_SSE2:
+        return unpack_quads_sse2;
+    case PIXEL_UNPACK_ISA_AVX2:
+        return unpack_quads_avx2;
+#endif
+#ifdef PIXEL_UNPACK_NEON
+    case PIXEL_UNPACK_ISA_NEON:
+        return unpack_quads_neon;
+#endif
+    default:
+        return unpack_quads_scalar;
+    }
+}
+
+static NarrowKernel_t get_narrow_kernel(PixelUnpackIsa_t isa)
+{
+    switch (isa)
+    {
+#ifdef PIXEL_UNPACK_X86
+    case PIXEL_UNPACK_ISA_SSE2:
+        return narrow_sse2;
+    case PIXEL_UNPACK_ISA_AVX2:
+        return narrow_avx2;
+#endif
+#ifdef PIXEL_UNPACK_NEON
+    case PIXEL_UNPACK_ISA_NEON:
+        return narrow_neon;
+#endif
+    default:
+        return narrow_scalar;
+    }
+}
+
+static ShiftKernel_t get_shift_kernel(PixelUnpackIsa_t isa)
+{
+    switch (isa)
+    {
+#ifdef PIXEL_UNPACK_X86
+    case PIXEL_UNPACK_ISA_SSE2:
+        return shift_sse2;
+    case PIXEL_UNPACK_ISA_AVX2:
+        return shift_avx2;
+#endif
+#ifdef PIXEL_UNPACK_NEON
+    case PIXEL_UNPACK_ISA_NEON:
+        return shift_neon;
+#endif
+    default:
+        return shift_scalar;
+    }
+}
+
+static guint16 unpack_single_pixel(PackedFormat_t format, const guint8 *src, gsize pixel)
+{
+    if (format == PACKED_FORMAT_MONO12PACKED)
+    {
+        const guint8 *group = src + pixel / 2 * 3;
+        return pixel % 2 == 0 ? (guint16)((group[0] << 4) | (group[1] & 0xF))
+                              : (guint16)((group[2] << 4) | (group[1] >> 4));
+    }
+    // In the bit stream formats every pixel is spread over exactly two bytes
+    guint bits = packed_format_bits_per_pixel(format);
+    gsize bit_offset = pixel * bits;
+    const guint8 *bytes = src + bit_offset / 8;
+    guint window = (guint)bytes[0] | ((guint)bytes[1] << 8);
+    return (guint16)((window >> (bit_offset % 8)) & ((1u << bits) - 1));
+}
+
+/**
+ * @brief Unpacks consecutive pixels of a packed image into little endian 16 bit values
+ *
+ * @param format Packed format of src
+ * @param src Start of the packed image
+ * @param first_pixel Index of the first pixel to unpack, counted from the start of the image
+ * @param pixel_count Number of pixels to unpack. The packed data of all of them must be contained in src
+ * @param scaling Placement of the pixel value in the 16 bits
+ * @param dst Receives pixel_count unpacked pixels
+ */
+void pixel_unpack(PackedFormat_t format,
+                  const guint8 *src,
+                  gsize first_pixel,
+                  gsize pixel_count,
+                  BitDepthScaling_t scaling,
+                  guint16 *dst)
+{
+    const QuadLayout_t *layout = get_quad_layout(format);
+    BitShift_t shift = get_bit_shift(packed_format_bits_per_pixel(format), scaling);
+    gsize pixel = first_pixel;
+    gsize end = first_pixel + pixel_count;
+    // Pixels before the first quad boundary, e.g. at the start of rows with a width that is not a multiple of 4
+    for (; pixel < end && pixel % QUAD_PIXELS != 0; pixel++)
+    {
+        guint16 value = GUINT16_TO_LE(unpack_single_pixel(format, src, pixel));
+        shift_scalar(&shift, &value, dst++, 1);
+    }
+
+    gsize quad_count = (end - pixel) / QUAD_PIXELS;
+    UnpackQuadsKernel_t unpack_quads = get_unpack_quads_kernel(pixel_unpack_get_isa());
+    unpack_quads(layout, &shift, src + pixel / QUAD_PIXELS * layout->quad_bytes, dst, quad_count);
+    dst += quad_count * QUAD_PIXELS;
+    pixel += quad_count * QUAD_PIXELS;
+
+    for (; pixel < end; pixel++)
+    {
+        guint16 value = GUINT16_TO_LE(unpack_single_pixel(format, src, pixel));
+        shift_scalar(&shift, &value, dst++, 1);
+    }
+}
+
+/**
+ * @brief Unpacks a packed image into rows of 8 or 16 bit pixels. 16 bit pixels are written little endian with the
+ * pixel value placed according to scaling. 8 bit pixels receive the most significant 8 bits of the pixel value.
+ * Pixels for which src holds no data (e.g. in incomplete frames) are set to 0
+ *
+ * @param format Packed format of src
+ * @param src Packed image data without padding between rows
+ * @param src_size Number of valid bytes in src
+ * @param width Width of the image in pixels
+ * @param height Height of the image in pixels
+ * @param dst Receives the unpacked image. Must hold height rows of dst_stride bytes
+ * @param dst_stride Distance between the starts of two rows in dst in bytes
+ * @param dst_bits_per_pixel 8 or 16
+ * @param scaling Placement of the pixel value in 16 bit pixels. Ignored for 8 bit pixels
+ */
+void pixel_unpack_image(PackedFormat_t format,
+                        const guint8 *src,
+                        gsize src_size,
+                        guint width,
+                        guint height,
+                        guint8 *dst,
+                        gsize dst_stride,
+                        guint dst_bits_per_pixel,
+                        BitDepthScaling_t scaling)
+{
+    guint bits_per_pixel = packed_format_bits_per_pixel(format);
+    gsize available_pixels = src_size * 8 / bits_per_pixel;
+    gsize dst_bytes_per_pixel = dst_bits_per_pixel / 8;
+    NarrowKernel_t narrow = get_narrow_kernel(pixel_unpack_get_isa());
+    // 8 bit rows are unpacked into this buffer before they are narrowed
+    guint16 *row_buffer = dst_bytes_per_pixel == 1 ? g_new(guint16, width) : NULL;
+
+    for (guint y = 0; y < height; y++)
+    {
+        guint8 *dst_row = dst + y * dst_stride;
+        gsize first_pixel = (gsize)y * width;
+        gsize pixel_count = first_pixel < available_pixels ? MIN(width, available_pixels - first_pixel) : 0;
+        if (row_buffer != NULL)
+        {
+            pixel_unpack(format, src, first_pixel, pixel_count, BIT_DEPTH_SCALING_NONE, row_buffer);
+            narrow(row_buffer, dst_row, pixel_count, bits_per_pixel - 8);
+        }
+        else
+        {
+            pixel_unpack(format, src, first_pixel, pixel_count, scaling, (guint16 *)dst_row);
+        }
+        memset(dst_row + pixel_count * dst_bytes_per_pixel, 0, dst_stride - pixel_count * dst_bytes_per_pixel);
+    }
+    g_free(row_buffer);
+}
+
+/**
+ * @brief Reduces an image of little endian 16 bit pixels to 8 bit pixels by keeping the 8 most significant of their
+ * significant bits
+ *
+ * @param src Pixels of the image without padding between the rows
+ * @param src_size Size of src in bytes. Pixels missing in incomplete images are 0 in dst
+ * @param width Width of the image in pixels
+ * @param height Height of the image in pixels
+ * @param bit_depth Number of significant bits of the pixel values in src
+ * @param dst Receives the 8 bit pixels. Padding at the end of the rows is cleared
+ * @param dst_stride Distance in bytes between the starts of two rows in dst
+ */
+void pixel_narrow_image(const guint16 *src,
+                        gsize src_size,
+                        guint width,
+                        guint height,
+                        guint bit_depth,
+                        guint8 *dst,
+                        gsize dst_stride)
+{
+    gsize available_pixels = src_size / sizeof(guint16);
+    guint shift = CLAMP(bit_depth, 8, 16) - 8;
+    NarrowKernel_t narrow = get_narrow_kernel(pixel_unpack_get_isa());
+
+    for (guint y = 0; y < height; y++)
+    {
+        guint8 *dst_row = dst + y * dst_stride;
+        gsize first_pixel = (gsize)y * width;
+        gsize pixel_count = first_pixel < available_pixels ? MIN(width, available_pixels - first_pixel) : 0;
+        narrow(src + first_pixel, dst_row, pixel_count, shift);
+        memset(dst_row + pixel_count, 0, dst_stride - pixel_count);
+    }
+}
+
+/**
+ * @brief Moves the significant bits of little endian 16 bit pixels holding their value in the least significant bits
+ * according to scaling
+ *
+ * @param src Pixels to scale
+ * @param dst Receives the scaled pixels. May be the same as src to scale in place
+ * @param pixel_count Number of pixels in src and dst
+ * @param bit_depth Number of significant bits of the pixel values in src
+ * @param scaling Placement of the pixel value in the 16 bits of dst
+ */
+void pixel_scale_bit_depth(const guint16 *src,
+                           guint16 *dst,
+                           gsize pixel_count,
+                           guint bit_depth,
+                           BitDepthScaling_t scaling)
+{
+    BitShift_t shift = get_bit_shift(bit_depth, scaling);
+    if (shift.shift_left == 0 && shift.shift_right >= 16)
+    {
+        if (src != dst)
+        {
+            memcpy(dst, src, pixel_count * sizeof(guint16));
+        }
+        return;
+    }
+    get_shift_kernel(pixel_unpack_get_isa())(&shift, src, dst, pixel_count);
+}
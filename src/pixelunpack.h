@@ -0,0 +1,77 @@
+#ifndef PIXELUNPACK_H_
+#define PIXELUNPACK_H_
+
+#include <glib.h>
+
+#include <stdbool.h>
+
+// Packed Vimba pixel formats that are unpacked in the element because GStreamer has no equivalent format
+typedef enum
+{
+    // The format is passed downstream as is
+    PACKED_FORMAT_NONE,
+    // 10 bit pixels written LSB first into a continuous bit stream (4 pixels in 5 bytes)
+    PACKED_FORMAT_MONO10P,
+    // 12 bit pixels written LSB first into a continuous bit stream (2 pixels in 3 bytes)
+    PACKED_FORMAT_MONO12P,
+    // Legacy GigE Vision format. The upper 8 bits of 2 pixels are stored in the first and third byte, the lower 4 bits
+    // of both pixels share the second byte
+    PACKED_FORMAT_MONO12PACKED
+} PackedFormat_t;
+
+// Placement of the significant bits of pixel values with less than 16 bits in 16 bit pixels
+typedef enum
+{
+    // The value is kept in the least significant bits
+    BIT_DEPTH_SCALING_NONE,
+    // The value is shifted into the most significant bits. The least significant bits are 0
+    BIT_DEPTH_SCALING_SHIFT,
+    // The value is scaled to the full 16 bit range by repeating its most significant bits in the least significant bits
+    BIT_DEPTH_SCALING_SCALE
+} BitDepthScaling_t;
+
+// Instruction set extensions the unpacking kernels are implemented with
+typedef enum
+{
+    PIXEL_UNPACK_ISA_SCALAR,
+    PIXEL_UNPACK_ISA_SSE2,
+    PIXEL_UNPACK_ISA_AVX2,
+    PIXEL_UNPACK_ISA_NEON
+} PixelUnpackIsa_t;
+
+guint packed_format_bits_per_pixel(PackedFormat_t format);
+
+bool pixel_unpack_isa_supported(PixelUnpackIsa_t isa);
+PixelUnpackIsa_t pixel_unpack_get_isa(void);
+void pixel_unpack_set_isa(PixelUnpackIsa_t isa);
+const char *pixel_unpack_isa_name(PixelUnpackIsa_t isa);
+
+void pixel_unpack(PackedFormat_t format,
+                  const guint8 *src,
+                  gsize first_pixel,
+                  gsize pixel_count,
+                  BitDepthScaling_t scaling,
+                  guint16 *dst);
+void pixel_unpack_image(PackedFormat_t format,
+                        const guint8 *src,
+                        gsize src_size,
+                        guint width,
+                        guint height,
+                        guint8 *dst,
+                        gsize dst_stride,
+                        guint dst_bits_per_pixel,
+                        BitDepthScaling_t scaling);
+void pixel_narrow_image(const guint16 *src,
+                        gsize src_size,
+                        guint width,
+                        guint height,
+                        guint bit_depth,
+                        guint8 *dst,
+                        gsize dst_stride);
+void pixel_scale_bit_depth(const guint16 *src,
+                           guint16 *dst,
+                           gsize pixel_count,
+                           guint bit_depth,
+                           BitDepthScaling_t scaling);
+
+#endif // PIXELUNPACK_H_
@@ -0,0 +1,109 @@
+#include "timestampmapping.h"
+
+// If a new sample deviates further than this (in nanoseconds) from the current mapping, the camera clock is assumed to
+// have been reset and the estimation starts over
+#define TIMESTAMP_MAPPING_MAX_DEVIATION 1e9
+
+void timestamp_mapping_reset(TimestampMapping_t *mapping)
+{
+    mapping->sample_count = 0;
+    mapping->next_sample = 0;
+    mapping->offset = 0.;
+    mapping->drift = 1.;
+}
+
+/**
+ * @brief Recalculates drift and offset from the stored samples
+ */
+static void update_mapping(TimestampMapping_t *mapping)
+{
+    guint count = mapping->sample_count;
+
+    if (count >= 2)
+    {
+        double mean_camera = 0., mean_host = 0.;
+        for (guint i = 0; i < count; i++)
+        {
+            mean_camera += mapping->camera_times[i];
+            mean_host += mapping->host_times[i];
+        }
+        mean_camera /= count;
+        mean_host /= count;
+
+        double covariance = 0., variance = 0.;
+        for (guint i = 0; i < count; i++)
+        {
+            double camera_deviation = mapping->camera_times[i] - mean_camera;
+            covariance += camera_deviation * (mapping->host_times[i] - mean_host);
+            variance += camera_deviation * camera_deviation;
+        }
+        // Samples with (almost) identical camera times do not allow estimating the drift. Keep the previous one
+        if (variance > 0.)
+        {
+            mapping->drift = covariance / variance;
+        }
+    }
+
+    // Lower envelope: the sample with the smallest delay relative to the drift line
+    double offset = mapping->host_times[0] - mapping->drift * mapping->camera_times[0];
+    for (guint i = 1; i < count; i++)
+    {
+        double sample_offset = mapping->host_times[i] - mapping->drift * mapping->camera_times[i];
+        if (sample_offset < offset)
+        {
+            offset = sample_offset;
+        }
+    }
+    mapping->offset = offset;
+}
+
+/**
+ * @brief Adds a pair of corresponding camera and host times and updates the mapping
+ *
+ * @param mapping The mapping to update
+ * @param camera_time Timestamp of a frame reported by the camera
+ * @param host_time Host clock time at which the frame was received
+ */
+void timestamp_mapping_add_sample(TimestampMapping_t *mapping, guint64 camera_time, gint64 host_time)
+{
+    if (mapping->sample_count > 0)
+    {
+        double deviation = (double)(host_time - timestamp_mapping_to_host(mapping, camera_time));
+        if (camera_time < mapping->last_camera_time || deviation > TIMESTAMP_MAPPING_MAX_DEVIATION ||
+            deviation < -TIMESTAMP_MAPPING_MAX_DEVIATION)
+        {
+            timestamp_mapping_reset(mapping);
+        }
+    }
+    if (mapping->sample_count == 0)
+    {
+        mapping->camera_reference = camera_time;
+        mapping->host_reference = host_time;
+    }
+    mapping->last_camera_time = camera_time;
+
+    mapping->camera_times[mapping->next_sample] = (double)(camera_time - mapping->camera_reference);
+    mapping->host_times[mapping->next_sample] = (double)(host_time - mapping->host_reference);
+    mapping->next_sample = (mapping->next_sample + 1) % TIMESTAMP_MAPPING_WINDOW_SIZE;
+    if (mapping->sample_count < TIMESTAMP_MAPPING_WINDOW_SIZE)
+    {
+        mapping->sample_count++;
+    }
+
+    update_mapping(mapping);
+}
+
+/**
+ * @brief Converts a camera timestamp to the corresponding host clock time. At least one sample must have been added
+ *
+ * @param mapping The mapping to use
+ * @param camera_time Timestamp reported by the camera
+ * @return gint64 The corresponding host clock time
+ */
+gint64 timestamp_mapping_to_host(TimestampMapping_t *mapping, guint64 camera_time)
+{
+    double camera_delta = camera_time >= mapping->camera_reference
+                              ? (double)(camera_time - mapping->camera_reference)
+                              : -(double)(mapping->camera_reference - camera_time);
+    return mapping->host_reference + (gint64)(mapping->offset + mapping->drift * camera_delta);
+}
@@ -0,0 +1,37 @@
+#ifndef TIMESTAMPMAPPING_H_
+#define TIMESTAMPMAPPING_H_
+
+#include <glib.h>
+
+#include <stdbool.h>
+
+// Number of most recent (camera time, host time) pairs the mapping is estimated from
+#define TIMESTAMP_MAPPING_WINDOW_SIZE 128
+
+// Linear mapping from camera timestamps to host clock times (offset plus drift). The drift is estimated by a least
+// squares fit over the most recent samples. Because the host time of each sample includes a varying transport and
+// scheduling delay that can only make it later, the offset is taken from the lower envelope of the samples rather than
+// their mean. All times are given in nanoseconds
+typedef struct
+{
+    // Ring of the most recent samples relative to the reference point
+    double camera_times[TIMESTAMP_MAPPING_WINDOW_SIZE];
+    double host_times[TIMESTAMP_MAPPING_WINDOW_SIZE];
+    guint sample_count;
+    guint next_sample;
+
+    // First sample after the last reset. Samples are stored relative to it to keep the precision of the doubles
+    guint64 camera_reference;
+    gint64 host_reference;
+    guint64 last_camera_time;
+
+    // host_time = host_reference + offset + drift * (camera_time - camera_reference)
+    double offset;
+    double drift;
+} TimestampMapping_t;
+
+void timestamp_mapping_reset(TimestampMapping_t *mapping);
+void timestamp_mapping_add_sample(TimestampMapping_t *mapping, guint64 camera_time, gint64 host_time);
+gint64 timestamp_mapping_to_host(TimestampMapping_t *mapping, guint64 camera_time);
+
+#endif // TIMESTAMPMAPPING_H_
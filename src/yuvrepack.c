@@ -0,0 +1,426 @@
+#include "yuvrepack.h"
+#include "pixelunpack.h"
+
+#include <stdbool.h>
+#include <string.h>
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#define YUV_REPACK_X86
+#include <immintrin.h>
+#endif
+
+#if defined(__ARM_NEON) || defined(__aarch64__) || defined(_M_ARM64)
+#define YUV_REPACK_NEON
+#include <arm_neon.h>
+#endif
+
+// See pixelunpack.c. The kernels are selected with the instruction set chosen for unpacking
+#if defined(__GNUC__)
+#define TARGET_SSE2 __attribute__((target("sse2")))
+#define TARGET_AVX2 __attribute__((target("avx2")))
+#else
+#define TARGET_SSE2
+#define TARGET_AVX2
+#endif
+
+// Values of black in the video range, used for rows missing from incomplete frames
+#define BLACK_LUMA 16
+#define BLACK_CHROMA 128
+
+// Two rows of the packed image that are repacked into two luma rows and one row of chroma values. Each chroma value
+// is the average of the two rows
+typedef struct
+{
+    const guint8 *src0;
+    const guint8 *src1;
+    guint width;
+    guint8 *luma0;
+    guint8 *luma1;
+    // For NV12 both point into the interleaved chroma plane with v one byte after u
+    guint8 *u;
+    guint8 *v;
+    bool interleaved;
+} YuvRows_t;
+
+// Plane layout of the output image, matching the defaults of GstVideoInfo
+typedef struct
+{
+    gsize luma_stride;
+    gsize chroma_stride;
+    gsize u_offset;
+    gsize v_offset;
+    gsize size;
+} YuvLayout_t;
+
+typedef void (*RepackRowsKernel_t)(const YuvRows_t *rows);
+
+static inline guint8 average(guint a, guint b)
+{
+    return (guint8)((a + b + 1) >> 1);
+}
+
+static YuvLayout_t get_layout(YuvOutput_t output, guint width, guint height)
+{
+    // Odd sizes are rounded up, so that the last chroma row and column cover a complete 2x2 block
+    gsize luma_rows = ((gsize)height + 1) & ~(gsize)1;
+    YuvLayout_t layout;
+    layout.luma_stride = ((gsize)width + 3) & ~(gsize)3;
+    layout.u_offset = layout.luma_stride * luma_rows;
+    if (output == YUV_OUTPUT_NV12)
+    {
+        layout.chroma_stride = layout.luma_stride;
+        layout.v_offset = layout.u_offset + 1;
+        layout.size = layout.u_offset + layout.chroma_stride * luma_rows / 2;
+    }
+    else
+    {
+        layout.chroma_stride = ((((gsize)width + 1) / 2) + 3) & ~(gsize)3;
+        layout.v_offset = layout.u_offset + layout.chroma_stride * luma_rows / 2;
+        layout.size = layout.v_offset + layout.chroma_stride * luma_rows / 2;
+    }
+    return layout;
+}
+
+// Size of one packed row. Rows end with a complete group of pixels
+static gsize get_src_stride(YuvPacking_t packing, guint width)
+{
+    return packing == YUV_PACKING_411 ? ((gsize)width + 3) / 4 * 6 : ((gsize)width + 1) / 2 * 4;
+}
+
+static inline gsize luma_offset(YuvPacking_t packing, guint x)
+{
+    guint index = x & 3;
+    return packing == YUV_PACKING_411 ? (gsize)x / 4 * 6 + 1 + index + (index >= 2) : (gsize)x * 2 + 1;
+}
+
+// Offset of the U value covering the pixel pair. The V value follows 3 (4:1:1) or 2 (4:2:2) bytes later
+static inline gsize chroma_offset(YuvPacking_t packing, guint pair)
+{
+    return packing == YUV_PACKING_411 ? (gsize)pair / 2 * 6 : (gsize)pair * 4;
+}
+
+static void repack_pairs_scalar(YuvPacking_t packing, const YuvRows_t *rows, guint pair, guint end)
+{
+    gsize v_distance = packing == YUV_PACKING_411 ? 3 : 2;
+    gsize chroma_step = rows->interleaved ? 2 : 1;
+    for (; pair < end; pair++)
+    {
+        guint x = 2 * pair;
+        gsize luma = luma_offset(packing, x);
+        rows->luma0[x] = rows->src0[luma];
+        rows->luma1[x] = rows->src1[luma];
+        if (x + 1 < rows->width)
+        {
+            luma = luma_offset(packing, x + 1);
+            rows->luma0[x + 1] = rows->src0[luma];
+            rows->luma1[x + 1] = rows->src1[luma];
+        }
+        gsize chroma = chroma_offset(packing, pair);
+        rows->u[pair * chroma_step] = average(rows->src0[chroma], rows->src1[chroma]);
+        rows->v[pair * chroma_step] = average(rows->src0[chroma + v_distance], rows->src1[chroma + v_distance]);
+    }
+}
+
+static void repack_411_rows_scalar(const YuvRows_t *rows)
+{
+    repack_pairs_scalar(YUV_PACKING_411, rows, 0, (rows->width + 1) / 2);
+}
+
+static void repack_422_rows_scalar(const YuvRows_t *rows)
+{
+    repack_pairs_scalar(YUV_PACKING_422, rows, 0, (rows->width + 1) / 2);
+}
+
+#ifdef YUV_REPACK_X86
+TARGET_SSE2 static void repack_422_rows_sse2(const YuvRows_t *rows)
+{
+    __m128i low_bytes = _mm_set1_epi16(0x00FF);
+    guint pair = 0;
+    // 32 pixels per iteration
+    for (; 2 * pair + 32 <= rows->width; pair += 16)
+    {
+        const guint8 *src[2] = {rows->src0 + 4 * (gsize)pair, rows->src1 + 4 * (gsize)pair};
+        guint8 *luma[2] = {rows->luma0 + 2 * (gsize)pair, rows->luma1 + 2 * (gsize)pair};
+        __m128i chroma[2][2];
+        for (int r = 0; r < 2; r++)
+        {
+            __m128i a = _mm_loadu_si128((const __m128i *)src[r]);
+            __m128i b = _mm_loadu_si128((const __m128i *)(src[r] + 16));
+            __m128i c = _mm_loadu_si128((const __m128i *)(src[r] + 32));
+            __m128i d = _mm_loadu_si128((const __m128i *)(src[r] + 48));
+            _mm_storeu_si128((__m128i *)luma[r], _mm_packus_epi16(_mm_srli_epi16(a, 8), _mm_srli_epi16(b, 8)));
+            _mm_storeu_si128((__m128i *)(luma[r] + 16),
+                             _mm_packus_epi16(_mm_srli_epi16(c, 8), _mm_srli_epi16(d, 8)));
+            chroma[r][0] = _mm_packus_epi16(_mm_and_si128(a, low_bytes), _mm_and_si128(b, low_bytes));
+            chroma[r][1] = _mm_packus_epi16(_mm_and_si128(c, low_bytes), _mm_and_si128(d, low_bytes));
+        }
+        // Interleaved U and V values of 16 pixel pairs, which is exactly the NV12 chroma plane
+        __m128i uv_low = _mm_avg_epu8(chroma[0][0], chroma[1][0]);
+        __m128i uv_high = _mm_avg_epu8(chroma[0][1], chroma[1][1]);
+        if (rows->interleaved)
+        {
+            _mm_storeu_si128((__m128i *)(rows->u + 2 * (gsize)pair), uv_low);
+            _mm_storeu_si128((__m128i *)(rows->u + 2 * (gsize)pair + 16), uv_high);
+        }
+        else
+        {
+            _mm_storeu_si128(
+                (__m128i *)(rows->u + pair),
+                _mm_packus_epi16(_mm_and_si128(uv_low, low_bytes), _mm_and_si128(uv_high, low_bytes)));
+            _mm_storeu_si128((__m128i *)(rows->v + pair),
+                             _mm_packus_epi16(_mm_srli_epi16(uv_low, 8), _mm_srli_epi16(uv_high, 8)));
+        }
+    }
+    repack_pairs_scalar(YUV_PACKING_422, rows, pair, (rows->width + 1) / 2);
+}
+
+// Packs the 16 bit values of a and b into bytes in their original order. _mm256_packus_epi16 works per 128 bit lane
+TARGET_AVX2 static inline __m256i pack_avx2(__m256i a, __m256i b)
+{
+    return _mm256_permute4x64_epi64(_mm256_packus_epi16(a, b), 0xD8);
+}
+
+TARGET_AVX2 static void repack_422_rows_avx2(const YuvRows_t *rows)
+{
+    __m256i low_bytes = _mm256_set1_epi16(0x00FF);
+    guint pair = 0;
+    // 64 pixels per iteration
+    for (; 2 * pair + 64 <= rows->width; pair += 32)
+    {
+        const guint8 *src[2] = {rows->src0 + 4 * (gsize)pair, rows->src1 + 4 * (gsize)pair};
+        guint8 *luma[2] = {rows->luma0 + 2 * (gsize)pair, rows->luma1 + 2 * (gsize)pair};
+        __m256i chroma[2][2];
+        for (int r = 0; r < 2; r++)
+        {
+            __m256i a = _mm256_loadu_si256((const __m256i *)src[r]);
+            __m256i b = _mm256_loadu_si256((const __m256i *)(src[r] + 32));
+            __m256i c = _mm256_loadu_si256((const __m256i *)(src[r] + 64));
+            __m256i d = _mm256_loadu_si256((const __m256i *)(src[r] + 96));
+            _mm256_storeu_si256((__m256i *)luma[r], pack_avx2(_mm256_srli_epi16(a, 8), _mm256_srli_epi16(b, 8)));
+            _mm256_storeu_si256((__m256i *)(luma[r] + 32),
+                                pack_avx2(_mm256_srli_epi16(c, 8), _mm256_srli_epi16(d, 8)));
+            chroma[r][0] = pack_avx2(_mm256_and_si256(a, low_bytes), _mm256_and_si256(b, low_bytes));
+            chroma[r][1] = pack_avx2(_mm256_and_si256(c, low_bytes), _mm256_and_si256(d, low_bytes));
+        }
+        __m256i uv_low = _mm256_avg_epu8(chroma[0][0], chroma[1][0]);
+        __m256i uv_high = _mm256_avg_epu8(chroma[0][1], chroma[1][1]);
+        if (rows->interleaved)
+        {
+            _mm256_storeu_si256((__m256i *)(rows->u + 2 * (gsize)pair), uv_low);
+            _mm256_storeu_si256((__m256i *)(rows->u + 2 * (gsize)pair + 32), uv_high);
+        }
+        else
+        {
+            _mm256_storeu_si256(
+                (__m256i *)(rows->u + pair),
+                pack_avx2(_mm256_and_si256(uv_low, low_bytes), _mm256_and_si256(uv_high, low_bytes)));
+            _mm256_storeu_si256((__m256i *)(rows->v + pair),
+                                pack_avx2(_mm256_srli_epi16(uv_low, 8), _mm256_srli_epi16(uv_high, 8)));
+        }
+    }
+    repack_pairs_scalar(YUV_PACKING_422, rows, pair, (rows->width + 1) / 2);
+}
+
+// The 6 byte groups of 4:1:1 need byte shuffles, which the AVX2 target provides. 128 bit vectors are used since the
+// groups do not line up with the lanes of 256 bit vectors
+TARGET_AVX2 static void repack_411_rows_avx2(const YuvRows_t *rows)
+{
+    // The first vector holds the bytes 0-15 of 4 groups, the second one the bytes 8-23
+    __m128i luma_first = _mm_setr_epi8(1, 2, 4, 5, 7, 8, 10, 11, -1, -1, -1, -1, -1, -1, -1, -1);
+    __m128i luma_second = _mm_setr_epi8(-1, -1, -1, -1, -1, -1, -1, -1, 5, 6, 8, 9, 11, 12, 14, 15);
+    // Each chroma value covers 2 pixel pairs
+    __m128i u_first = _mm_setr_epi8(0, 0, 6, 6, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1);
+    __m128i u_second = _mm_setr_epi8(-1, -1, -1, -1, 4, 4, 10, 10, -1, -1, -1, -1, -1, -1, -1, -1);
+    __m128i v_first = _mm_setr_epi8(3, 3, 9, 9, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1);
+    __m128i v_second = _mm_setr_epi8(-1, -1, -1, -1, 7, 7, 13, 13, -1, -1, -1, -1, -1, -1, -1, -1);
+    __m128i uv_first = _mm_setr_epi8(0, 3, 0, 3, 6, 9, 6, 9, -1, -1, -1, -1, -1, -1, -1, -1);
+    __m128i uv_second = _mm_setr_epi8(-1, -1, -1, -1, -1, -1, -1, -1, 4, 7, 4, 7, 10, 13, 10, 13);
+    guint pair = 0;
+    // 16 pixels per iteration
+    for (; 2 * pair + 16 <= rows->width; pair += 8)
+    {
+        const guint8 *src[2] = {rows->src0 + 3 * (gsize)pair, rows->src1 + 3 * (gsize)pair};
+        guint8 *luma[2] = {rows->luma0 + 2 * (gsize)pair, rows->luma1 + 2 * (gsize)pair};
+        __m128i first[2], second[2];
+        for (int r = 0; r < 2; r++)
+        {
+            first[r] = _mm_loadu_si128((const __m128i *)src[r]);
+            second[r] = _mm_loadu_si128((const __m128i *)(src[r] + 8));
+            _mm_storeu_si128((__m128i *)luma[r],
+                             _mm_or_si128(_mm_shuffle_epi8(first[r], luma_first),
+                                          _mm_shuffle_epi8(second[r], luma_second)));
+        }
+        // Averaging all bytes of both rows is cheaper than extracting the chroma values first
+        __m128i chroma_first = _mm_avg_epu8(first[0], first[1]);
+        __m128i chroma_second = _mm_avg_epu8(second[0], second[1]);
+        if (rows->interleaved)
+        {
+            _mm_storeu_si128((__m128i *)(rows->u + 2 * (gsize)pair),
+                             _mm_or_si128(_mm_shuffle_epi8(chroma_first, uv_first),
+                                          _mm_shuffle_epi8(chroma_second, uv_second)));
+        }
+        else
+        {
+            _mm_storel_epi64((__m128i *)(rows->u + pair),
+                             _mm_or_si128(_mm_shuffle_epi8(chroma_first, u_first),
+                                          _mm_shuffle_epi8(chroma_second, u_second)));
+            _mm_storel_epi64((__m128i *)(rows->v + pair),
+                             _mm_or_si128(_mm_shuffle_epi8(chroma_first, v_first),
+                                          _mm_shuffle_epi8(chroma_second, v_second)));
+        }
+    }
+    repack_pairs_scalar(YUV_PACKING_411, rows, pair, (rows->width + 1) / 2);
+}
+#endif
+
+#ifdef YUV_REPACK_NEON
+static void repack_422_rows_neon(const YuvRows_t *rows)
+{
+    guint pair = 0;
+    // 32 pixels per iteration. The loads split the groups into U, Y0, V and Y1
+    for (; 2 * pair + 32 <= rows->width; pair += 16)
+    {
+        uint8x16x4_t first = vld4q_u8(rows->src0 + 4 * (gsize)pair);
+        uint8x16x4_t second = vld4q_u8(rows->src1 + 4 * (gsize)pair);
+        uint8x16x2_t luma0 = {{first.val[1], first.val[3]}};
+        uint8x16x2_t luma1 = {{second.val[1], second.val[3]}};
+        vst2q_u8(rows->luma0 + 2 * (gsize)pair, luma0);
+        vst2q_u8(rows->luma1 + 2 * (gsize)pair, luma1);
+        uint8x16_t u = vrhaddq_u8(first.val[0], second.val[0]);
+        uint8x16_t v = vrhaddq_u8(first.val[2], second.val[2]);
+        if (rows->interleaved)
+        {
+            uint8x16x2_t uv = {{u, v}};
+            vst2q_u8(rows->u + 2 * (gsize)pair, uv);
+        }
+        else
+        {
+            vst1q_u8(rows->u + pair, u);
+            vst1q_u8(rows->v + pair, v);
+        }
+    }
+    repack_pairs_scalar(YUV_PACKING_422, rows, pair, (rows->width + 1) / 2);
+}
+
+static void repack_411_rows_neon(const YuvRows_t *rows)
+{
+    guint pair = 0;
+    // 32 pixels per iteration. The loads split the groups into alternating U and V values, even and odd luma values
+    for (; 2 * pair + 32 <= rows->width; pair += 16)
+    {
+        uint8x16x3_t first = vld3q_u8(rows->src0 + 3 * (gsize)pair);
+        uint8x16x3_t second = vld3q_u8(rows->src1 + 3 * (gsize)pair);
+        uint8x16x2_t luma0 = {{first.val[1], first.val[2]}};
+        uint8x16x2_t luma1 = {{second.val[1], second.val[2]}};
+        vst2q_u8(rows->luma0 + 2 * (gsize)pair, luma0);
+        vst2q_u8(rows->luma1 + 2 * (gsize)pair, luma1);
+        uint8x16_t uv = vrhaddq_u8(first.val[0], second.val[0]);
+        if (rows->interleaved)
+        {
+            // Each U and V pair covers 2 pixel pairs
+            uint16x8x2_t doubled = vzipq_u16(vreinterpretq_u16_u8(uv), vreinterpretq_u16_u8(uv));
+            vst1q_u8(rows->u + 2 * (gsize)pair, vreinterpretq_u8_u16(doubled.val[0]));
+            vst1q_u8(rows->u + 2 * (gsize)pair + 16, vreinterpretq_u8_u16(doubled.val[1]));
+        }
+        else
+        {
+            uint8x8x2_t planar = vuzp_u8(vget_low_u8(uv), vget_high_u8(uv));
+            uint8x8x2_t u = vzip_u8(planar.val[0], planar.val[0]);
+            uint8x8x2_t v = vzip_u8(planar.val[1], planar.val[1]);
+            vst1q_u8(rows->u + pair, vcombine_u8(u.val[0], u.val[1]));
+            vst1q_u8(rows->v + pair, vcombine_u8(v.val[0], v.val[1]));
+        }
+    }
+    repack_pairs_scalar(YUV_PACKING_411, rows, pair, (rows->width + 1) / 2);
+}
+#endif
+
+static RepackRowsKernel_t get_repack_rows_kernel(PixelUnpackIsa_t isa, YuvPacking_t packing)
+{
+    switch (isa)
+    {
+#ifdef YUV_REPACK_X86
+    case PIXEL_UNPACK_ISA_SSE2:
+        // Regrouping the 6 byte groups of 4:1:1 needs byte shuffles, which SSE2 lacks
+        return packing == YUV_PACKING_411 ? repack_411_rows_scalar : repack_422_rows_sse2;
+    case PIXEL_UNPACK_ISA_AVX2:
+        return packing == YUV_PACKING_411 ? repack_411_rows_avx2 : repack_422_rows_avx2;
+#endif
+#ifdef YUV_REPACK_NEON
+    case PIXEL_UNPACK_ISA_NEON:
+        return packing == YUV_PACKING_411 ? repack_411_rows_neon : repack_422_rows_neon;
+#endif
+    default:
+        return packing == YUV_PACKING_411 ? repack_411_rows_scalar : repack_422_rows_scalar;
+    }
+}
+
+/**
+ * @brief Gets the size of a planar 4:2:0 image with the default strides and plane offsets of GStreamer
+ */
+gsize yuv_repack_output_size(YuvOutput_t output, guint width, guint height)
+{
+    return get_layout(output, width, height).size;
+}
+
+/**
+ * @brief Repacks a packed 4:1:1 or 4:2:2 image into a planar 4:2:0 image. The chroma values of each two rows are
+ * averaged and 4:1:1 chroma values are repeated for both pixel pairs they cover
+ *
+ * @param packing Packed layout of src
+ * @param output Planar layout of dst
+ * @param src The packed image. Rows missing from incomplete images are filled with black
+ * @param src_size Number of valid bytes in src
+ * @param width Width of the image in pixels
+ * @param height Height of the image in pixels
+ * @param dst Receives the planar image. Must hold yuv_repack_output_size bytes. Padding at the end of the rows is
+ * cleared
+ */
+void yuv_repack_image(YuvPacking_t packing,
+                      YuvOutput_t output,
+                      const guint8 *src,
+                      gsize src_size,
+                      guint width,
+                      guint height,
+                      guint8 *dst)
+{
+    YuvLayout_t layout = get_layout(output, width, height);
+    gsize src_stride = get_src_stride(packing, width);
+    guint rows = src_stride > 0 ? (guint)MIN(height, src_size / src_stride) : 0;
+    RepackRowsKernel_t repack_rows = get_repack_rows_kernel(pixel_unpack_get_isa(), packing);
+    // U and V share one row in NV12, so only the U row of I420 is handled like it
+    bool is_planar = output == YUV_OUTPUT_I420;
+    gsize chroma_row_size = is_planar ? ((gsize)width + 1) / 2 : ((gsize)width + 1) / 2 * 2;
+
+    YuvRows_t pair_rows = {.width = width, .interleaved = !is_planar};
+    for (guint y = 0; y < rows; y += 2)
+    {
+        // The last row of an odd number of rows is averaged with itself
+        pair_rows.src0 = src + y * src_stride;
+        pair_rows.src1 = y + 1 < rows ? pair_rows.src0 + src_stride : pair_rows.src0;
+        pair_rows.luma0 = dst + y * layout.luma_stride;
+        pair_rows.luma1 = pair_rows.luma0 + layout.luma_stride;
+        pair_rows.u = dst + layout.u_offset + y / 2 * layout.chroma_stride;
+        pair_rows.v = dst + layout.v_offset + y / 2 * layout.chroma_stride;
+        repack_rows(&pair_rows);
+
+        memset(pair_rows.luma0 + width, 0, layout.luma_stride - width);
+        memset(pair_rows.luma1 + width, 0, layout.luma_stride - width);
+        memset(pair_rows.u + chroma_row_size, 0, layout.chroma_stride - chroma_row_size);
+        if (is_planar)
+        {
+            memset(pair_rows.v + chroma_row_size, 0, layout.chroma_stride - chroma_row_size);
+        }
+    }
+
+    // The row after an odd number of rows only received a copy of the last row above
+    gsize luma_rows = ((gsize)height + 1) & ~(gsize)1;
+    gsize first_black_chroma_row = ((gsize)rows + 1) / 2;
+    gsize black_chroma_size = (luma_rows / 2 - first_black_chroma_row) * layout.chroma_stride;
+    memset(dst + rows * layout.luma_stride, BLACK_LUMA, (luma_rows - rows) * layout.luma_stride);
+    memset(dst + layout.u_offset + first_black_chroma_row * layout.chroma_stride, BLACK_CHROMA, black_chroma_size);
+    if (is_planar)
+    {
+        memset(dst + layout.v_offset + first_black_chroma_row * layout.chroma_stride, BLACK_CHROMA, black_chroma_size);
+    }
+}
@@ -0,0 +1,37 @@
+#ifndef YUVREPACK_H_
+#define YUVREPACK_H_
+
+#include <glib.h>
+
+// Packed YUV layouts delivered by the camera that can be repacked into planar 4:2:0 formats
+typedef enum
+{
+    // The image is not repacked
+    YUV_PACKING_NONE,
+    // 4:1:1 with 4 pixels in 6 bytes: U Y0 Y1 V Y2 Y3 (GStreamer IYU1)
+    YUV_PACKING_411,
+    // 4:2:2 with 2 pixels in 4 bytes: U Y0 V Y1 (GStreamer UYVY)
+    YUV_PACKING_422
+} YuvPacking_t;
+
+// Planar 4:2:0 layouts the repacked image can be written in. The planes use the default strides and offsets of
+// GstVideoInfo
+typedef enum
+{
+    // Y plane followed by a U and a V plane of half width and height
+    YUV_OUTPUT_I420,
+    // Y plane followed by a plane of interleaved U and V values of half width and height
+    YUV_OUTPUT_NV12
+} YuvOutput_t;
+
+gsize yuv_repack_output_size(YuvOutput_t output, guint width, guint height);
+
+void yuv_repack_image(YuvPacking_t packing,
+                      YuvOutput_t output,
+                      const guint8 *src,
+                      gsize src_size,
+                      guint width,
+                      guint height,
+                      guint8 *dst);
+
+#endif // YUVREPACK_H_